@@ -2,70 +2,66 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdlib.h>
 
 #include "Tree/NameTable/NameTable.h"
+#include "Tree/TreeVisitor.h"
 #include "BackEnd.h"
 
-static void AsmCodeBuild(TreeNode* node, NameTableType* localTable, 
-                         const NameTableType* allNamesTable, FILE* outStream, size_t numberOfTabs);
-
-static void AsmCodeBuildFunc(TreeNode* node, const NameTableType* allNamesTable, 
-                             size_t* varRamId, FILE* outStream, size_t numberOfTabs);
-
-static void AsmCodePrintStringLiteral(TreeNode* node, NameTableType* localTable, 
-                          const NameTableType* allNamesTable, FILE* outStream, size_t numberOfTabs);   
-
-static void NameTablePushFuncParams(TreeNode* node, NameTableType* local, 
-                                    const NameTableType* allNamesTable, size_t* varRamId);
-static void AsmCodeBuildIf(TreeNode* node, NameTableType* localTable, 
-                             const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                             size_t numberOfTabs);
-static void AsmCodeBuildWhile(TreeNode* node, NameTableType* localTable, 
-                              const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                              size_t numberOfTabs);
-static void AsmCodeBuildAssign(TreeNode* node, NameTableType* localTable, 
-                               const NameTableType* allNamesTable, size_t* varRamId, FILE* outStream,
-                               size_t numberOfTabs);
-static void AsmCodeBuildAnd(TreeNode* node, NameTableType* localTable, 
-                            const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                            size_t numberOfTabs);
-static void AsmCodeBuildOr(TreeNode* node, NameTableType* localTable, 
-                            const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                            size_t numberOfTabs);
-static void AsmCodeBuildFuncCall(TreeNode* node, NameTableType* localTable, 
-                                 const NameTableType* allNamesTable, FILE* outStream,
-                                 size_t numberOfTabs);
-static void AsmCodeBuildEq(TreeNode* node, NameTableType* localTable, 
-                            const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                            size_t numberOfTabs);
-static void AsmCodeBuildNotEq(TreeNode* node, NameTableType* localTable, 
-                              const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                              size_t numberOfTabs);
-static void AsmCodeBuildGreaterEq(TreeNode* node, NameTableType* localTable, 
-                                  const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                                  size_t numberOfTabs);
-static void AsmCodeBuildLessEq(TreeNode* node, NameTableType* localTable, 
-                               const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                               size_t numberOfTabs);
-static void AsmCodeBuildLess(TreeNode* node, NameTableType* localTable, 
-                             const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                             size_t numberOfTabs);
-static void AsmCodeBuildGreater(TreeNode* node, NameTableType* localTable, 
-                                const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                                size_t numberOfTabs);
-
-static void AsmCodeBuildPrint(TreeNode* node, NameTableType* localTable, 
-                        const NameTableType* allNamesTable, FILE* outStream, size_t numberOfTabs);
+// Code of the operation is printed before its children (pre), between them (in) and after them
+// (post). Labels of IF, WHILE and OR are taken before their code blocks, so they are kept on
+// the labels stack until the blocks are built.
+struct AsmCodeContext
+{
+    NameTableType*       localTable;    ///< table of the function being built
+    const NameTableType* allNamesTable;
+
+    FILE*  outStream;
+    size_t numberOfTabs;
+
+    size_t varRamId;
+    size_t labelId;
+
+    size_t* labelsStack;
+    size_t  labelsStackSize;
+    size_t  labelsStackCapacity;
+
+    bool memErr;
+};
+
+static const size_t LABELS_STACK_STANDARD_CAPACITY = 16;
+
+static TreeVisitAction AsmCodeBuildPre (TreeNode** link, TreeVisitState* state, void* context);
+static TreeVisitAction AsmCodeBuildIn  (TreeNode** link, TreeVisitState* state, void* context);
+static TreeVisitAction AsmCodeBuildPost(TreeNode** link, TreeVisitState* state, void* context);
+
+static bool   AsmCodeLabelPush(AsmCodeContext* context, const size_t id);
+static size_t AsmCodeLabelPop (AsmCodeContext* context);
+
+static void AsmCodeBuildFunc(const TreeNode* node, AsmCodeContext* context);
+
+static void AsmCodePrintStringLiteral(const TreeNode* node, AsmCodeContext* context);
+
+static void            NameTablePushFuncParams(const TreeNode* node, AsmCodeContext* context);
+static TreeVisitAction NameTablePushFuncParam (const TreeNode* node, TreeConstVisitState* state,
+                                               void* visitContext);
+
+static bool AsmCodeBuildIfCondition     (AsmCodeContext* context);
+static bool AsmCodeBuildWhileBegin      (AsmCodeContext* context);
+static void AsmCodeBuildWhileCondition  (AsmCodeContext* context);
+static void AsmCodeBuildAssign          (const TreeNode* node, AsmCodeContext* context);
+static void AsmCodeBuildAnd             (AsmCodeContext* context);
+static bool AsmCodeBuildOrFirst         (AsmCodeContext* context);
+static void AsmCodeBuildOrSecond        (AsmCodeContext* context);
+static void AsmCodeBuildFuncCallBegin   (AsmCodeContext* context);
+static void AsmCodeBuildFuncCallEnd     (const TreeNode* node, AsmCodeContext* context);
+static void AsmCodeBuildCmp             (const char* jumpCmd, const char* labelName,
+                                         AsmCodeContext* context);
 
 static void PrintTabs(const size_t numberOfTabs, FILE* outStream);
 static void FprintfLine(FILE* outStream, const size_t numberOfTabs, const char* format, ...);
 
-#define PRINT(...) FprintfLine(outStream, numberOfTabs, __VA_ARGS__)
-#define CODE_BUILD(NODE) AsmCodeBuild(NODE, localTable, allNamesTable, outStream, numberOfTabs)
-
-#define PARAMS(NODE)                NODE, localTable, allNamesTable, outStream, numberOfTabs
-#define PARAMS_WITH_RAM_ID(NODE)    NODE, localTable, allNamesTable, &varRamId, outStream, numberOfTabs
-#define PARAMS_WITH_LABEL_ID(NODE)  NODE, localTable, allNamesTable, &labelId,  outStream, numberOfTabs
+#define PRINT(...) FprintfLine(context->outStream, context->numberOfTabs, __VA_ARGS__)
 
 void AsmCodeBuild(Tree* tree, FILE* outStream, FILE* outBinStream)
 {
@@ -75,25 +71,37 @@ void AsmCodeBuild(Tree* tree, FILE* outStream, FILE* outBinStream)
 
     fprintf(outStream, "call main:\n"
                        "hlt\n\n");
-    
-    AsmCodeBuild(tree->root, nullptr, tree->allNamesTable, outStream, 0);
+
+    static const TreeVisitor asmVisitor = { AsmCodeBuildPre, AsmCodeBuildIn, AsmCodeBuildPost,
+                                            false };
+
+    AsmCodeContext context = {};
+    context.allNamesTable  = tree->allNamesTable;
+    context.outStream      = outStream;
+
+    if (TreeVisit(&tree->root, &asmVisitor, &context) != TreeErrors::NO_ERR || context.memErr)
+        fprintf(stderr, "Can't build asm code, not enough memory\n");
+
+    free(context.labelsStack);
 
     fprintf(outStream, "    ret\n");
 }
 
-static void AsmCodeBuild(TreeNode* node, NameTableType* localTable, 
-                         const NameTableType* allNamesTable, FILE* outStream, size_t numberOfTabs)
+//---------------------------------------------------------------------------------------
+
+static TreeVisitAction AsmCodeBuildPre(TreeNode** link, TreeVisitState* state, void* visitContext)
 {
-    static size_t varRamId = 0;
-    static size_t labelId  = 0;
+    assert(link);
+    assert(state);
+    assert(visitContext);
 
-    if (node == nullptr)
-        return;
+    AsmCodeContext* context = (AsmCodeContext*)visitContext;
+    TreeNode*       node    = *link;
 
     if (node->valueType == TreeNodeValueType::NUM)
     {
         PRINT("push %d\n", node->value.num);
-        return;
+        return TreeVisitAction::SKIP_CHILDREN;
     }
 
     if (node->valueType == TreeNodeValueType::NAME)
@@ -101,274 +109,361 @@ static void AsmCodeBuild(TreeNode* node, NameTableType* localTable,
         assert(!node->left && !node->right);
 
         Name* varName = nullptr;
-        NameTableFind(localTable, allNamesTable->data[node->value.nameId].name, &varName);
+        NameTableFind(context->localTable, context->allNamesTable->data[node->value.nameId].symbol,
+                      &varName);
         assert(varName);
 
         PRINT("push [%zu]\n", varName->varRamId);
 
-        return;
+        return TreeVisitAction::SKIP_CHILDREN;
     }
 
     if (node->valueType == TreeNodeValueType::STRING_LITERAL)
     {
-        AsmCodePrintStringLiteral(PARAMS(node));
+        AsmCodePrintStringLiteral(node, context);
 
-        return;
+        return TreeVisitAction::SKIP_CHILDREN;
     }
 
     assert(node->valueType == TreeNodeValueType::OPERATION);
 
     switch (node->value.operation)
     {
-        case TreeOperationId::ADD:
+        case TreeOperationId::SIN:
+        case TreeOperationId::COS:
+        case TreeOperationId::TAN:
+        case TreeOperationId::COT:
+        case TreeOperationId::SQRT:
+        case TreeOperationId::RETURN:
         {
-            CODE_BUILD(node->left);
-            CODE_BUILD(node->right);
-
-            PRINT("add\n");
+            TreeVisitSetChildren(state, &node->left, nullptr);
             break;
         }
-        case TreeOperationId::SUB:
-        {
-            CODE_BUILD(node->left);
-            CODE_BUILD(node->right);
 
-            PRINT("sub\n");
-            break;
-        }
-        case TreeOperationId::MUL:
-        {
-            CODE_BUILD(node->left);
-            CODE_BUILD(node->right);
+        case TreeOperationId::COMMA:
+            // Comma goes in the opposite way, because it is used here only for func call
+            return TreeVisitAction::REVERSE_CHILDREN;
 
-            PRINT("mul\n");
+        case TreeOperationId::TYPE:
+        {
+            TreeVisitSetChildren(state, nullptr, &node->right);
             break;
         }
-        case TreeOperationId::DIV:
+
+        case TreeOperationId::FUNC:
         {
-            CODE_BUILD(node->left);
-            CODE_BUILD(node->right);
+            AsmCodeBuildFunc(node, context);
 
-            PRINT("div\n");
+            TreeVisitSetChildren(state, nullptr, &node->left->right);
             break;
         }
-        case TreeOperationId::SIN:
-        {
-            CODE_BUILD(node->left);
 
-            PRINT("sin\n");
+        case TreeOperationId::IF:
+        {
+            fprintf(context->outStream, "\n");
+            PRINT("@ if condition:\n");
             break;
         }
-        case TreeOperationId::COS:
-        {
-            CODE_BUILD(node->left);
 
-            PRINT("cos\n");
+        case TreeOperationId::WHILE:
+        {
+            if (!AsmCodeBuildWhileBegin(context))
+                return TreeVisitAction::STOP;
             break;
         }
-        case TreeOperationId::TAN:
-        {
-            CODE_BUILD(node->left);
 
-            PRINT("tan\n");
+        case TreeOperationId::ASSIGN:
+        {
+            TreeVisitSetChildren(state, nullptr, &node->right);
             break;
         }
-        case TreeOperationId::COT:
+
+        case TreeOperationId::FUNC_CALL:
         {
-            CODE_BUILD(node->left);
+            AsmCodeBuildFuncCallBegin(context);
 
-            PRINT("cot\n");
+            TreeVisitSetChildren(state, &node->left->left, nullptr);
             break;
         }
-        case TreeOperationId::SQRT:
-        {
-            CODE_BUILD(node->left);
 
-            PRINT("sqrt\n");
-            break;
+        case TreeOperationId::READ:
+        {
+            PRINT("in\n");
+            return TreeVisitAction::SKIP_CHILDREN;
         }
 
-        case TreeOperationId::COMMA:
+        case TreeOperationId::PRINT:
         {
-            CODE_BUILD(node->right);
-            CODE_BUILD(node->left);
+            assert(node->left);
 
-            // Comma goes in the opposite way, because it is used here only for func call
+            if (node->left->valueType == TreeNodeValueType::STRING_LITERAL)
+            {
+                AsmCodePrintStringLiteral(node->left, context);
+                return TreeVisitAction::SKIP_CHILDREN;
+            }
+
+            TreeVisitSetChildren(state, &node->left, nullptr);
             break;
         }
+
+        case TreeOperationId::ADD:
+        case TreeOperationId::SUB:
+        case TreeOperationId::MUL:
+        case TreeOperationId::DIV:
         case TreeOperationId::NEW_FUNC:
-        {
-            CODE_BUILD(node->left);
+        case TreeOperationId::LINE_END:
+        case TreeOperationId::AND:
+        case TreeOperationId::OR:
+        case TreeOperationId::EQ:
+        case TreeOperationId::NOT_EQ:
+        case TreeOperationId::LESS:
+        case TreeOperationId::LESS_EQ:
+        case TreeOperationId::GREATER:
+        case TreeOperationId::GREATER_EQ:
+            break;
+
+        default:
+            assert(false);
+            break;
+    }
+
+    return TreeVisitAction::CONTINUE;
+}
+
+static TreeVisitAction AsmCodeBuildIn(TreeNode** link, TreeVisitState*, void* visitContext)
+{
+    assert(link);
+    assert(visitContext);
 
-            fprintf(outStream, "\n");
+    AsmCodeContext* context = (AsmCodeContext*)visitContext;
+    TreeNode*       node    = *link;
 
-            CODE_BUILD(node->right);
+    if (node->valueType != TreeNodeValueType::OPERATION)
+        return TreeVisitAction::CONTINUE;
 
+    switch (node->value.operation)
+    {
+        case TreeOperationId::NEW_FUNC:
+        {
+            fprintf(context->outStream, "\n");
             break;
         }
 
-        case TreeOperationId::TYPE:
+        case TreeOperationId::IF:
         {
-            CODE_BUILD(node->right);
+            if (!AsmCodeBuildIfCondition(context))
+                return TreeVisitAction::STOP;
             break;
         }
 
-        case TreeOperationId::FUNC:
+        case TreeOperationId::WHILE:
         {
-            AsmCodeBuildFunc(node, allNamesTable, &varRamId, outStream, numberOfTabs);
-            
+            AsmCodeBuildWhileCondition(context);
             break;
         }
 
-        case TreeOperationId::LINE_END:
+        case TreeOperationId::OR:
         {
-            CODE_BUILD(node->left);
-            CODE_BUILD(node->right);
+            if (!AsmCodeBuildOrFirst(context))
+                return TreeVisitAction::STOP;
+            break;
+        }
 
+        default:
+            break;
+    }
+
+    return TreeVisitAction::CONTINUE;
+}
+
+static TreeVisitAction AsmCodeBuildPost(TreeNode** link, TreeVisitState*, void* visitContext)
+{
+    assert(link);
+    assert(visitContext);
+
+    AsmCodeContext* context = (AsmCodeContext*)visitContext;
+    TreeNode*       node    = *link;
+
+    if (node->valueType != TreeNodeValueType::OPERATION)
+        return TreeVisitAction::CONTINUE;
+
+    switch (node->value.operation)
+    {
+        case TreeOperationId::ADD:  PRINT("add\n");  break;
+        case TreeOperationId::SUB:  PRINT("sub\n");  break;
+        case TreeOperationId::MUL:  PRINT("mul\n");  break;
+        case TreeOperationId::DIV:  PRINT("div\n");  break;
+        case TreeOperationId::SIN:  PRINT("sin\n");  break;
+        case TreeOperationId::COS:  PRINT("cos\n");  break;
+        case TreeOperationId::TAN:  PRINT("tan\n");  break;
+        case TreeOperationId::COT:  PRINT("cot\n");  break;
+        case TreeOperationId::SQRT: PRINT("sqrt\n"); break;
+
+        case TreeOperationId::FUNC:
+        {
+            context->numberOfTabs -= 1;
+            context->localTable    = nullptr;
             break;
         }
 
         case TreeOperationId::IF:
         {
-            AsmCodeBuildIf(PARAMS_WITH_LABEL_ID(node));
+            context->numberOfTabs -= 1;
+            PRINT("END_IF_%zu:\n\n", AsmCodeLabelPop(context));
             break;
         }
 
         case TreeOperationId::WHILE:
         {
-            AsmCodeBuildWhile(PARAMS_WITH_LABEL_ID(node));
+            context->numberOfTabs -= 1;
+            PRINT("END_WHILE_%zu:\n\n", AsmCodeLabelPop(context));
             break;
         }
 
         case TreeOperationId::AND:
         {
-            AsmCodeBuildAnd(PARAMS_WITH_LABEL_ID(node));
+            AsmCodeBuildAnd(context);
             break;
         }
 
         case TreeOperationId::OR:
         {
-            AsmCodeBuildOr(PARAMS_WITH_LABEL_ID(node));
+            AsmCodeBuildOrSecond(context);
             break;
         }
 
         case TreeOperationId::ASSIGN:
         {
-            AsmCodeBuildAssign(PARAMS_WITH_RAM_ID(node));
+            AsmCodeBuildAssign(node, context);
             break;
         }
 
         case TreeOperationId::FUNC_CALL:
         {
-            AsmCodeBuildFuncCall(PARAMS(node));
+            AsmCodeBuildFuncCallEnd(node, context);
             break;
         }
 
         case TreeOperationId::RETURN:
         {
-            CODE_BUILD(node->left);
-
             PRINT("ret\n");
             break;
         }
 
-        case TreeOperationId::EQ:
-        {
-            AsmCodeBuildEq(PARAMS_WITH_LABEL_ID(node));
-            break;
-        }
-        case TreeOperationId::NOT_EQ:
-        {
-            AsmCodeBuildNotEq(PARAMS_WITH_LABEL_ID(node));
-            break;
-        }
-        case TreeOperationId::LESS:
-        {
-            AsmCodeBuildLess(PARAMS_WITH_LABEL_ID(node));
-            break;
-        }
-        case TreeOperationId::LESS_EQ:
-        {
-            AsmCodeBuildLessEq(PARAMS_WITH_LABEL_ID(node));
-            break;
-        }
-        case TreeOperationId::GREATER:
-        {
-            AsmCodeBuildGreater(PARAMS_WITH_LABEL_ID(node));
-            break;
-        }
-        case TreeOperationId::GREATER_EQ:
+        case TreeOperationId::EQ:         AsmCodeBuildCmp("je",  "EQ",         context); break;
+        case TreeOperationId::NOT_EQ:     AsmCodeBuildCmp("jne", "NOT_EQ",     context); break;
+        case TreeOperationId::LESS:       AsmCodeBuildCmp("jb",  "LESS",       context); break;
+        case TreeOperationId::LESS_EQ:    AsmCodeBuildCmp("jbe", "LESS_EQ",    context); break;
+        case TreeOperationId::GREATER:    AsmCodeBuildCmp("ja",  "GREATER",    context); break;
+        case TreeOperationId::GREATER_EQ: AsmCodeBuildCmp("jae", "GREATER_EQ", context); break;
+
+        case TreeOperationId::PRINT:
         {
-            AsmCodeBuildGreaterEq(PARAMS_WITH_LABEL_ID(node));
+            if (node->left->valueType != TreeNodeValueType::STRING_LITERAL)
+            {
+                PRINT("out\n");
+                PRINT("pop\n");
+            }
             break;
         }
 
-        case TreeOperationId::READ:
-        {
-            PRINT("in\n");
+        default:
             break;
-        }
+    }
 
-        case TreeOperationId::PRINT:
-        {
-            AsmCodeBuildPrint(PARAMS(node));
+    return TreeVisitAction::CONTINUE;
+}
 
-            break;
+//---------------------------------------------------------------------------------------
+
+static bool AsmCodeLabelPush(AsmCodeContext* context, const size_t id)
+{
+    assert(context);
+
+    if (context->labelsStackSize == context->labelsStackCapacity)
+    {
+        const size_t newCapacity = context->labelsStackCapacity > 0 ?
+                                   2 * context->labelsStackCapacity : LABELS_STACK_STANDARD_CAPACITY;
+
+        size_t* newStack = (size_t*)realloc(context->labelsStack, newCapacity * sizeof(*newStack));
+        if (newStack == nullptr)
+        {
+            context->memErr = true;
+            return false;
         }
 
-        default:
-            assert(false);
-            break;
+        context->labelsStack         = newStack;
+        context->labelsStackCapacity = newCapacity;
     }
+
+    context->labelsStack[context->labelsStackSize++] = id;
+
+    return true;
 }
 
-static void AsmCodeBuildFunc(TreeNode* node, const NameTableType* allNamesTable, 
-                             size_t* varRamId, FILE* outStream, size_t numberOfTabs)
+static size_t AsmCodeLabelPop(AsmCodeContext* context)
+{
+    assert(context);
+    assert(context->labelsStackSize > 0);
+
+    return context->labelsStack[--context->labelsStackSize];
+}
+
+//---------------------------------------------------------------------------------------
+
+static void AsmCodeBuildFunc(const TreeNode* node, AsmCodeContext* context)
 {
     assert(node->left->valueType == TreeNodeValueType::NAME);
+    assert(context->localTable == nullptr);
 
-    PRINT("%s: \n", allNamesTable->data[node->left->value.nameId].name);
-    numberOfTabs += 1;
+    PRINT("%s: \n", context->allNamesTable->data[node->left->value.nameId].name);
+    context->numberOfTabs += 1;
 
     NameTableType* localTable = nullptr;
     NameTableCtor(&localTable);
 
-    allNamesTable->data[node->left->value.nameId].localNameTable = localTable;
+    context->allNamesTable->data[node->left->value.nameId].localNameTable = localTable;
+    context->localTable = localTable;
 
-    NameTablePushFuncParams(node->left->left, localTable, allNamesTable, varRamId);
+    NameTablePushFuncParams(node->left->left, context);
 
     for (size_t i = 0; i < localTable->size; ++i)
     {
         PRINT("pop [%zu]\n", localTable->data[i].varRamId);
     }
+}
+
+static void NameTablePushFuncParams(const TreeNode* node, AsmCodeContext* context)
+{
+    assert(context);
+
+    static const TreeConstVisitor paramsVisitor = { NameTablePushFuncParam, nullptr, nullptr, false };
 
-    CODE_BUILD(node->left->right);
+    if (TreeVisit(node, &paramsVisitor, context) != TreeErrors::NO_ERR)
+        context->memErr = true;
 }
 
-static void NameTablePushFuncParams(TreeNode* node, NameTableType* local, 
-                                    const NameTableType* allNamesTable, size_t* varRamId)
+static TreeVisitAction NameTablePushFuncParam(const TreeNode* node, TreeConstVisitState* state,
+                                              void* visitContext)
 {
-    assert(local);
-    assert(allNamesTable);
+    assert(node);
+    assert(state);
+    assert(visitContext);
 
-    if (node == nullptr)
-        return;
+    AsmCodeContext* context = (AsmCodeContext*)visitContext;
 
     if (node->valueType == TreeNodeValueType::NAME)
     {
         Name pushName = {};
-        NameCtor(&pushName, allNamesTable->data[node->value.nameId].name, nullptr, *varRamId);
-        // TODO: Name ctors strdups name. 
-        // It's kind of useless when I am creating local table - 
-        // I'm not going to delete local tables strings without deleting global table
-        // Just using extra mem + time. 
+        NameCtor(&pushName, context->allNamesTable->data[node->value.nameId].symbol, nullptr,
+                 context->varRamId);
 
         // TODO: mem leak never DTOR name table. + Create recursive name table dtor
-        *varRamId += 1;
+        context->varRamId += 1;
 
-        NameTablePush(local, pushName);
+        NameTablePush(context->localTable, pushName);
 
-        return;
+        return TreeVisitAction::SKIP_CHILDREN;
     }
 
     assert(node->valueType == TreeNodeValueType::OPERATION);
@@ -376,16 +471,11 @@ static void NameTablePushFuncParams(TreeNode* node, NameTableType* local,
     switch (node->value.operation)
     {
         case TreeOperationId::COMMA:
-        {
-            NameTablePushFuncParams(node->left, local,  allNamesTable, varRamId);
-            NameTablePushFuncParams(node->right, local, allNamesTable, varRamId);
-
             break;
-        }
+
         case TreeOperationId::TYPE:
         {
-            NameTablePushFuncParams(node->right, local, allNamesTable, varRamId);
-            
+            TreeVisitSetChildren(state, nullptr, node->right);
             break;
         }   
 
@@ -395,75 +485,73 @@ static void NameTablePushFuncParams(TreeNode* node, NameTableType* local,
             break;
         }
     }
+
+    return TreeVisitAction::CONTINUE;
 }
 
-static void AsmCodeBuildIf(TreeNode* node, NameTableType* localTable, 
-                           const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                           size_t numberOfTabs)
+static bool AsmCodeBuildIfCondition(AsmCodeContext* context)
 {
-    fprintf(outStream, "\n");
-    PRINT("@ if condition:\n");
-
-    CODE_BUILD(node->left);
-
-    size_t id = *labelId;
+    size_t id = context->labelId;
     PRINT("push 0\n");
     PRINT("je END_IF_%zu:\n", id);
-    *labelId += 1;
+    context->labelId += 1;
 
     PRINT("@ if code block:\n");
 
-    AsmCodeBuild(node->right, localTable, allNamesTable, outStream, numberOfTabs + 1);
-    
-    PRINT("END_IF_%zu:\n\n", id);
+    context->numberOfTabs += 1;
+
+    return AsmCodeLabelPush(context, id);
 }
 
-static void AsmCodeBuildWhile(TreeNode* node, NameTableType* localTable, 
-                              const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                              size_t numberOfTabs)
+static bool AsmCodeBuildWhileBegin(AsmCodeContext* context)
 {
-    size_t id = *labelId;
+    size_t id = context->labelId;
 
-    fprintf(outStream, "\n");
+    fprintf(context->outStream, "\n");
 
     PRINT("while_%zu:\n", id);
 
-    *labelId += 1;
+    context->labelId += 1;
     PRINT("@ while condition: \n");
 
-    CODE_BUILD(node->left);
+    return AsmCodeLabelPush(context, id);
+}
+
+static void AsmCodeBuildWhileCondition(AsmCodeContext* context)
+{
+    assert(context->labelsStackSize > 0);
+
+    size_t id = context->labelsStack[context->labelsStackSize - 1];
 
     PRINT("push 0\n");
     PRINT("je END_WHILE_%zu:\n", id);
 
-    *labelId += 1;
+    context->labelId += 1;
 
     PRINT("@ while code block: \n");
 
-    AsmCodeBuild(node->right, localTable, allNamesTable, outStream, numberOfTabs + 1);
-
-    PRINT("END_WHILE_%zu:\n\n", id);
+    context->numberOfTabs += 1;
 }
 
-static void AsmCodeBuildAssign(TreeNode* node, NameTableType* localTable, 
-                              const NameTableType* allNamesTable, size_t* varRamId, FILE* outStream,
-                              size_t numberOfTabs)
+static void AsmCodeBuildAssign(const TreeNode* node, AsmCodeContext* context)
 {
-    CODE_BUILD(node->right);
-
     assert(node->left->valueType == TreeNodeValueType::NAME);
 
+    NameTableType*       localTable    = context->localTable;
+    const NameTableType* allNamesTable = context->allNamesTable;
+
     Name* varNameInTablePtr = nullptr;
-    NameTableFind(localTable, allNamesTable->data[node->left->value.nameId].name, &varNameInTablePtr);
+    NameTableFind(localTable, allNamesTable->data[node->left->value.nameId].symbol, &varNameInTablePtr);
 
     // TODO: it is hotfix, a lot of operations are done
     // better fix: split assigning and defining and push only once
     if (varNameInTablePtr == nullptr)
     {
         Name pushName = {};
-        NameCtor(&pushName, allNamesTable->data[node->left->value.nameId].name, nullptr, *varRamId);
+        NameCtor(&pushName, allNamesTable->data[node->left->value.nameId].symbol, nullptr,
+                 context->varRamId);
 
-        *varRamId += 1;
+        context->varRamId += 1;
 
         NameTablePush(localTable, pushName);
         varNameInTablePtr = localTable->data + localTable->size - 1;    // pointing on pushed name
@@ -472,32 +560,23 @@ static void AsmCodeBuildAssign(TreeNode* node, NameTableType* localTable,
     PRINT("pop [%zu]\n", varNameInTablePtr->varRamId);
 }
 
-static void AsmCodeBuildAnd(TreeNode* node, NameTableType* localTable, 
-                              const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                              size_t numberOfTabs)
+static void AsmCodeBuildAnd(AsmCodeContext* context)
 {
-    CODE_BUILD(node->left);
-    CODE_BUILD(node->right);
-
     PRINT("mul\n");
     PRINT("push 0\n");
-    PRINT("je AND_FALSE_%zu:\n", *labelId);
+    PRINT("je AND_FALSE_%zu:\n", context->labelId);
     PRINT("push 1\n");
-    PRINT("jmp AND_END_%zu:\n", *labelId);
-    PRINT("AND_FALSE_%zu:\n", *labelId);
+    PRINT("jmp AND_END_%zu:\n", context->labelId);
+    PRINT("AND_FALSE_%zu:\n", context->labelId);
     PRINT("push 0\n");
-    PRINT("AND_END_%zu:\n\n", *labelId);
+    PRINT("AND_END_%zu:\n\n", context->labelId);
 
-    *labelId += 1;
+    context->labelId += 1;
 }
 
-static void AsmCodeBuildOr(TreeNode* node, NameTableType* localTable, 
-                           const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                           size_t numberOfTabs)
+static bool AsmCodeBuildOrFirst(AsmCodeContext* context)
 {
-    CODE_BUILD(node->left);
-
-    size_t id = *labelId;
+    size_t id = context->labelId;
 
     PRINT("push 0\n");
     PRINT("je OR_FIRST_VAL_SET_ZERO_%zu:\n", id);
@@ -507,9 +586,14 @@ static void AsmCodeBuildOr(TreeNode* node, NameTableType* localTable,
     PRINT("push 0\n");
     PRINT("OR_FIRST_VAL_END_%zu\n\n", id);
 
-    *labelId += 1;
+    context->labelId += 1;
 
-    CODE_BUILD(node->right);
+    return AsmCodeLabelPush(context, id);
+}
+
+static void AsmCodeBuildOrSecond(AsmCodeContext* context)
+{
+    size_t id = AsmCodeLabelPop(context);
 
     PRINT("push 0\n");
     PRINT("je OR_SECOND_VAL_SET_ZERO_%zu:\n", id);
@@ -529,149 +613,57 @@ static void AsmCodeBuildOr(TreeNode* node, NameTableType* localTable,
     PRINT("OR_END_%zu:\n\n", id);
 }
 
-static void AsmCodeBuildFuncCall(TreeNode* node, NameTableType* localTable, 
-                                 const NameTableType* allNamesTable, FILE* outStream,
-                                 size_t numberOfTabs)
+static void AsmCodeBuildFuncCallBegin(AsmCodeContext* context)
 {
     PRINT("@ pushing func local vars:\n");
 
-    for (size_t i = 0; i < localTable->size; ++i)
+    for (size_t i = 0; i < context->localTable->size; ++i)
     {
-        PRINT("push [%zu]\n", localTable->data[i].varRamId);
+        PRINT("push [%zu]\n", context->localTable->data[i].varRamId);
     }
 
     PRINT("@ pushing func args:\n");
-    CODE_BUILD(node->left->left);
+}
 
+static void AsmCodeBuildFuncCallEnd(const TreeNode* node, AsmCodeContext* context)
+{
     assert(node->left->valueType == TreeNodeValueType::NAME);
 
     PRINT(
-                    "call %s:\n", allNamesTable->data[node->left->value.nameId].name);
+                    "call %s:\n", context->allNamesTable->data[node->left->value.nameId].name);
 
     PRINT("@ saving func return\n");
 
     PRINT("pop rax\n");
 
-    for (int i = (int)localTable->size - 1; i > -1; --i)
+    for (int i = (int)context->localTable->size - 1; i > -1; --i)
     {
-        PRINT("pop [%zu]\n", localTable->data[i].varRamId);
+        PRINT("pop [%zu]\n", context->localTable->data[i].varRamId);
     }
 
     PRINT("push rax\n");
 }
 
-static void AsmCodeBuildEq(TreeNode* node, NameTableType* localTable, 
-                           const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                           size_t numberOfTabs)
+// Operands are on the stack, jump command pushes 1 if the comparison is true otherwise 0
+static void AsmCodeBuildCmp(const char* jumpCmd, const char* labelName, AsmCodeContext* context)
 {
-    CODE_BUILD(node->left);
-    CODE_BUILD(node->right);
+    assert(jumpCmd);
+    assert(labelName);
 
-    size_t id = *labelId;
-    PRINT("je EQ_%zu:\n", id);
+    size_t id = context->labelId;
+    PRINT("%s %s_%zu:\n", jumpCmd, labelName, id);
     PRINT("push 0\n");
-    PRINT("jmp AFTER_EQ_%zu:\n", id);
-    PRINT("EQ_%zu:\n", id);
+    PRINT("jmp AFTER_%s_%zu:\n", labelName, id);
+    PRINT("%s_%zu:\n", labelName, id);
     PRINT("push 1\n");
-    PRINT("AFTER_EQ_%zu:\n\n", id);
-
-    *labelId += 1;
-}
+    PRINT("AFTER_%s_%zu:\n\n", labelName, id);
 
-static void AsmCodeBuildNotEq(TreeNode* node, NameTableType* localTable, 
-                              const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                              size_t numberOfTabs)
-{
-    CODE_BUILD(node->left);
-    CODE_BUILD(node->right);
-
-    size_t id = *labelId;
-    PRINT("jne NOT_EQ_%zu:\n", id);
-    PRINT("push 0\n");
-    PRINT("jmp AFTER_NOT_EQ_%zu:\n", id);
-    PRINT("NOT_EQ_%zu:\n", id);
-    PRINT("push 1\n");
-    PRINT("AFTER_NOT_EQ_%zu:\n\n", id);
-    
-    *labelId += 1;
+    context->labelId += 1;
 }
 
-static void AsmCodeBuildLess(TreeNode* node, NameTableType* localTable, 
-                              const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                              size_t numberOfTabs)
+static void AsmCodePrintStringLiteral(const TreeNode* node, AsmCodeContext* context)
 {
-    CODE_BUILD(node->left);
-    CODE_BUILD(node->right);
-
-    size_t id = *labelId;
-    PRINT("jb LESS_%zu:\n", id);
-    PRINT("push 0\n");
-    PRINT("jmp AFTER_LESS_%zu:\n", id);
-    PRINT("LESS_%zu:\n", id);
-    PRINT("push 1\n");
-    PRINT("AFTER_LESS_%zu:\n\n", id);
-    
-    *labelId += 1;
-}
-
-static void AsmCodeBuildLessEq(TreeNode* node, NameTableType* localTable, 
-                              const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                              size_t numberOfTabs)
-{
-    CODE_BUILD(node->left);
-    CODE_BUILD(node->right);
-
-    size_t id = *labelId;
-    PRINT("jbe LESS_EQ_%zu:\n", id);
-    PRINT("push 0\n");
-    PRINT("jmp AFTER_LESS_EQ_%zu:\n", id);
-    PRINT("LESS_EQ_%zu:\n", id);
-    PRINT("push 1\n");
-    PRINT("AFTER_LESS_EQ_%zu:\n\n", id);
-    
-    *labelId += 1;
-}
-
-static void AsmCodeBuildGreater(TreeNode* node, NameTableType* localTable, 
-                              const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                              size_t numberOfTabs)
-{
-    CODE_BUILD(node->left);
-    CODE_BUILD(node->right);
-
-    size_t id = *labelId;
-    PRINT("ja GREATER_%zu:\n", id);
-    PRINT("push 0\n");
-    PRINT("jmp AFTER_GREATER_%zu:\n", id);
-    PRINT("GREATER_%zu:\n", id);
-    PRINT("push 1\n");
-    PRINT("AFTER_GREATER_%zu:\n\n", id);
-
-    *labelId += 1;
-}
-
-static void AsmCodeBuildGreaterEq(TreeNode* node, NameTableType* localTable, 
-                                const NameTableType* allNamesTable, size_t* labelId, FILE* outStream,
-                                size_t numberOfTabs)
-{
-    CODE_BUILD(node->left);
-    CODE_BUILD(node->right);
-
-    size_t id = *labelId;
-    PRINT("jae GREATER_EQ_%zu:\n", id);
-    PRINT("push 0\n");
-    PRINT("jmp AFTER_GREATER_EQ_%zu:\n", id);
-    PRINT("GREATER_EQ_%zu:\n", id);
-    PRINT("push 1\n");
-    PRINT("AFTER_GREATER_EQ_%zu:\n\n", id);
-
-    *labelId += 1;
-}
-
-static void AsmCodePrintStringLiteral(TreeNode* node, NameTableType* localTable, 
-                          const NameTableType* allNamesTable, FILE* outStream, size_t numberOfTabs)
-{
-    const char* string = allNamesTable->data[node->value.nameId].name;
+    const char* string = context->allNamesTable->data[node->value.nameId].name;
 
     size_t pos = 1; //skipping " char
 
@@ -688,24 +680,6 @@ static void AsmCodePrintStringLiteral(TreeNode* node, NameTableType* localTable,
     PRINT("pop\n");
 }
 
-static void AsmCodeBuildPrint(TreeNode* node, NameTableType* localTable, 
-                        const NameTableType* allNamesTable, FILE* outStream, size_t numberOfTabs)
-{
-    assert(node->left);
-
-    if (node->left->valueType == TreeNodeValueType::STRING_LITERAL)
-    {
-        AsmCodePrintStringLiteral(PARAMS(node->left));
-
-        return;
-    }
-
-    CODE_BUILD(node->left);
-
-    PRINT("out\n");
-    PRINT("pop\n");
-}
-
 static void PrintTabs(const size_t numberOfTabs, FILE* outStream)
 {
     for (size_t i = 0; i < numberOfTabs; ++i)
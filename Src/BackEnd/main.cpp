@@ -3,12 +3,14 @@
 #include "BackEnd.h"
 #include "Tree/Tree.h"
 #include "Common/Log.h"
+#include "Common/CommandLineArgs.h"
 
 int main(int argc, char* argv[])
 {
     assert(argc > 3);
 
     LogOpen(argv[0]);
+    TreeDumpPolicyInit(ArgsGetOption(argc, argv, "--dump="));
     setbuf(stdout, nullptr);
     FILE* inStream     = fopen(argv[1], "r");
     FILE* outStream    = fopen(argv[2], "w");
@@ -17,7 +19,7 @@ int main(int argc, char* argv[])
     Tree tree = {};
     TreeCtor(&tree);
 
-    TreeReadPrefixFormat(&tree, inStream);
+    TreeRead(&tree, inStream);
 
     TreeGraphicDump(&tree, true);
 
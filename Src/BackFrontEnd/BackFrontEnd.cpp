@@ -1,10 +1,22 @@
 #include <assert.h>
 
 #include "Tree/DSL.h"
+#include "Tree/TreeVisitor.h"
 #include "BackFrontEnd.h"
 
-static void CodeBuild(TreeNode* node, NameTableType* allNamesTable, FILE* outStream, 
-                                                                    size_t numberOfTabs);
+// Code of the operation is printed before its children (pre), between them (in)
+// and after them (post)
+struct CodeBuildContext
+{
+    const NameTableType* allNamesTable;
+    FILE*                outStream;
+    size_t               numberOfTabs;
+};
+
+static TreeVisitAction CodeBuildPre (TreeNode** link, TreeVisitState* state, void* context);
+static TreeVisitAction CodeBuildIn  (TreeNode** link, TreeVisitState* state, void* context);
+static TreeVisitAction CodeBuildPost(TreeNode** link, TreeVisitState* state, void* context);
+
 static void PrintTabs(size_t numberOfTabs, FILE* outStream);
 
 void CodeBuild(Tree* tree, FILE* outStream)
@@ -12,26 +24,33 @@ void CodeBuild(Tree* tree, FILE* outStream)
     assert(tree);
     assert(outStream);
 
-    CodeBuild(tree->root, tree->allNamesTable, outStream, 0);
-}
+    static const TreeVisitor codeVisitor = { CodeBuildPre, CodeBuildIn, CodeBuildPost, false };
 
-#define CODE_BUILD(NODE)           CodeBuild(NODE, allNamesTable, outStream, numberOfTabs)
-#define CODE_BUILD_TAB_SHIFT(NODE) CodeBuild(NODE, allNamesTable, outStream, numberOfTabs + 1)
+    CodeBuildContext context = { tree->allNamesTable, outStream, 0 };
 
-static void CodeBuild(TreeNode* node, NameTableType* allNamesTable, FILE* outStream, 
-                                                                    size_t numberOfTabs)
+    if (TreeVisit(&tree->root, &codeVisitor, &context) != TreeErrors::NO_ERR)
+        fprintf(stderr, "Can't build code, not enough memory\n");
+}
+
+static TreeVisitAction CodeBuildPre(TreeNode** link, TreeVisitState* state, void* visitContext)
 {
-    if (node == nullptr)
-        return;
-    
+    assert(link);
+    assert(state);
+    assert(visitContext);
+
+    CodeBuildContext*    context       = (CodeBuildContext*)visitContext;
+    const NameTableType* allNamesTable = context->allNamesTable;
+    FILE*                outStream     = context->outStream;
+    TreeNode*            node          = *link;
+
     if (node->valueType == TreeNodeValueType::NUM)
     {
         if (node->value.num < 0)
             fprintf(outStream, "(0 + %d) ", -node->value.num);
         else
             fprintf(outStream, "%d ", node->value.num);
-            
-        return;
+
+        return TreeVisitAction::SKIP_CHILDREN;
     }
 
     if (node->valueType == TreeNodeValueType::NAME)
@@ -39,384 +58,247 @@ static void CodeBuild(TreeNode* node, NameTableType* allNamesTable, FILE* outStr
         assert(!node->left && !node->right);
 
         fprintf(outStream, "%s ", allNamesTable->data[node->value.nameId].name);
-        return;
+        return TreeVisitAction::SKIP_CHILDREN;
     }
 
     if (node->valueType == TreeNodeValueType::STRING_LITERAL)
     {
         fprintf(outStream, "\"%s\" ", allNamesTable->data[node->value.nameId].name);
-        return;
+        return TreeVisitAction::SKIP_CHILDREN;
     }
 
     assert(node->valueType == TreeNodeValueType::OPERATION);
 
     switch (node->value.operation)
     {
-        case TreeOperationId::NEW_FUNC:
-        {
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "\n");
-
-            CODE_BUILD(node->right);
-
-            break;
-        }
-
         case TreeOperationId::TYPE_INT:
         {
             fprintf(outStream, "575757 ");
-            break;
+            return TreeVisitAction::SKIP_CHILDREN;
         }
 
         case TreeOperationId::FUNC:
         {
             fprintf(outStream, "%s ", allNamesTable->data[node->left->value.nameId].name);
 
-            assert(numberOfTabs == 0);
-
-            CODE_BUILD_TAB_SHIFT(node->left->left);
-
-            fprintf(outStream, "\n57\n");
-
-            CODE_BUILD_TAB_SHIFT(node->left->right);
-
-            fprintf(outStream, "{\n");
+            assert(context->numberOfTabs == 0);
+            context->numberOfTabs += 1;
 
+            TreeVisitSetChildren(state, &node->left->left, &node->left->right);
             break;
         }
 
         case TreeOperationId::LINE_END:
         {
-            PrintTabs(numberOfTabs, outStream);
-
-            CODE_BUILD(node->left);
-
-            if (!(node->left->valueType == TreeNodeValueType::OPERATION && 
-                  (node->left->value.operation == TreeOperationId::IF   ||
-                   node->left->value.operation == TreeOperationId::WHILE)))
-                fprintf(outStream, "57\n");
-
-            CODE_BUILD(node->right);
-
-            break;
-        }
-
-        case TreeOperationId::ASSIGN:
-        {
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "== ");
-
-            CODE_BUILD(node->right);
-
+            PrintTabs(context->numberOfTabs, outStream);
             break;
         }
 
         case TreeOperationId::READ:
         {
             fprintf(outStream, "{ ");
-            
-            break;
+            return TreeVisitAction::SKIP_CHILDREN;
         }
 
         case TreeOperationId::PRINT:
         {
             fprintf(outStream, ". ");
 
-            CODE_BUILD(node->left);
-
+            TreeVisitSetChildren(state, &node->left, nullptr);
             break;
         }
 
         case TreeOperationId::FUNC_CALL:
         {
             fprintf(outStream, "%s { ", allNamesTable->data[node->left->value.nameId].name);
-            
-            CODE_BUILD(node->left->left);
-
-            fprintf(outStream, "57 ");
 
+            TreeVisitSetChildren(state, &node->left->left, nullptr);
             break;
         }
 
         case TreeOperationId::IF:
         {
             fprintf(outStream, "57? ");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "57\n");
-            PrintTabs(numberOfTabs, outStream);
-            fprintf(outStream, "57\n");
-             
-            CODE_BUILD_TAB_SHIFT(node->right);
-
-            PrintTabs(numberOfTabs, outStream);
-            fprintf(outStream, "{\n");
-
             break;
         }
 
         case TreeOperationId::WHILE:
         {
             fprintf(outStream, "57! ");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "57\n");
-            PrintTabs(numberOfTabs, outStream);
-            fprintf(outStream, "57\n");
-             
-            CODE_BUILD_TAB_SHIFT(node->right);
-
-            PrintTabs(numberOfTabs, outStream);
-            fprintf(outStream, "{\n");
-
             break;
         }
 
         case TreeOperationId::ADD:
-        {
-            fprintf(outStream, "(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "- ");
-
-            CODE_BUILD(node->right);
-
-            fprintf(outStream, ") ");
-
-            break;
-        }
         case TreeOperationId::SUB:
-        {
-            fprintf(outStream, "(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "+ ");
-
-            CODE_BUILD(node->right);
-
-            fprintf(outStream, ") ");
-
-            break;
-        }
         case TreeOperationId::MUL:
-        {
-            fprintf(outStream, "(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "/ ");
-
-            CODE_BUILD(node->right);
-
-            fprintf(outStream, ") ");
-
-            break;
-        }
         case TreeOperationId::DIV:
+        case TreeOperationId::GREATER:
+        case TreeOperationId::GREATER_EQ:
+        case TreeOperationId::LESS:
+        case TreeOperationId::LESS_EQ:
+        case TreeOperationId::EQ:
+        case TreeOperationId::NOT_EQ:
+        case TreeOperationId::AND:
+        case TreeOperationId::OR:
+        case TreeOperationId::POW:
         {
             fprintf(outStream, "(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "* ");
-
-            CODE_BUILD(node->right);
-
-            fprintf(outStream, ") ");
-
             break;
         }
-        case TreeOperationId::GREATER:
-        {
-            fprintf(outStream, "(");
 
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "< ");
-
-            CODE_BUILD(node->right);
-
-            fprintf(outStream, ") ");
+        // unary operations have only left child
+        case TreeOperationId::SIN:  fprintf(outStream, "sin(");  break;
+        case TreeOperationId::COS:  fprintf(outStream, "cos(");  break;
+        case TreeOperationId::TAN:  fprintf(outStream, "tan(");  break;
+        case TreeOperationId::COT:  fprintf(outStream, "cot(");  break;
+        case TreeOperationId::SQRT: fprintf(outStream, "sqrt("); break;
 
+        default:
             break;
-        }
-        case TreeOperationId::GREATER_EQ:
-        {
-            fprintf(outStream, "(");
+    }
 
-            CODE_BUILD(node->left);
+    return TreeVisitAction::CONTINUE;
+}
 
-            fprintf(outStream, "<= ");
+static TreeVisitAction CodeBuildIn(TreeNode** link, TreeVisitState*, void* visitContext)
+{
+    assert(link);
+    assert(visitContext);
 
-            CODE_BUILD(node->right);
+    CodeBuildContext* context   = (CodeBuildContext*)visitContext;
+    FILE*             outStream = context->outStream;
+    TreeNode*         node      = *link;
 
-            fprintf(outStream, ") ");
+    assert(node->valueType == TreeNodeValueType::OPERATION);
 
+    switch (node->value.operation)
+    {
+        case TreeOperationId::NEW_FUNC:
+        {
+            fprintf(outStream, "\n");
             break;
         }
-        case TreeOperationId::LESS:
-        {
-            fprintf(outStream, "(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "> ");
-
-            CODE_BUILD(node->right);
-
-            fprintf(outStream, ") ");
 
+        case TreeOperationId::FUNC:
+        {
+            fprintf(outStream, "\n57\n");
             break;
         }
-        case TreeOperationId::LESS_EQ:
-        {
-            fprintf(outStream, "(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, ">= ");
 
-            CODE_BUILD(node->right);
-
-            fprintf(outStream, ") ");
+        case TreeOperationId::LINE_END:
+        {
+            if (!(node->left->valueType == TreeNodeValueType::OPERATION &&
+                  (node->left->value.operation == TreeOperationId::IF   ||
+                   node->left->value.operation == TreeOperationId::WHILE)))
+                fprintf(outStream, "57\n");
 
             break;
         }
-        case TreeOperationId::EQ:
-        {
-            fprintf(outStream, "(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "!= ");
-
-            CODE_BUILD(node->right);
-
-            fprintf(outStream, ") ");
 
+        case TreeOperationId::ASSIGN:
+        {
+            fprintf(outStream, "== ");
             break;
         }
-        case TreeOperationId::NOT_EQ:
-        {
-            fprintf(outStream, "(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "= ");
-
-            CODE_BUILD(node->right);
 
-            fprintf(outStream, ") ");
+        case TreeOperationId::IF:
+        case TreeOperationId::WHILE:
+        {
+            fprintf(outStream, "57\n");
+            PrintTabs(context->numberOfTabs, outStream);
+            fprintf(outStream, "57\n");
 
+            context->numberOfTabs += 1;
             break;
         }
-        case TreeOperationId::AND:
-        {
-            fprintf(outStream, "(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, "or ");
-
-            CODE_BUILD(node->right);
 
-            fprintf(outStream, ") ");
+        case TreeOperationId::ADD:        fprintf(outStream, "- ");     break;
+        case TreeOperationId::SUB:        fprintf(outStream, "+ ");     break;
+        case TreeOperationId::MUL:        fprintf(outStream, "/ ");     break;
+        case TreeOperationId::DIV:        fprintf(outStream, "* ");     break;
+        case TreeOperationId::GREATER:    fprintf(outStream, "< ");     break;
+        case TreeOperationId::GREATER_EQ: fprintf(outStream, "<= ");    break;
+        case TreeOperationId::LESS:       fprintf(outStream, "> ");     break;
+        case TreeOperationId::LESS_EQ:    fprintf(outStream, ">= ");    break;
+        case TreeOperationId::EQ:         fprintf(outStream, "!= ");    break;
+        case TreeOperationId::NOT_EQ:     fprintf(outStream, "= ");     break;
+        case TreeOperationId::AND:        fprintf(outStream, "or ");    break;
+        case TreeOperationId::OR:         fprintf(outStream, "and ");   break;
+        case TreeOperationId::POW:        fprintf(outStream, ") ^ ("); break;
 
+        default:
             break;
-        }
-        case TreeOperationId::OR:
-        {
-            fprintf(outStream, "(");
+    }
 
-            CODE_BUILD(node->left);
+    return TreeVisitAction::CONTINUE;
+}
 
-            fprintf(outStream, "and ");
+static TreeVisitAction CodeBuildPost(TreeNode** link, TreeVisitState*, void* visitContext)
+{
+    assert(link);
+    assert(visitContext);
 
-            CODE_BUILD(node->right);
+    CodeBuildContext* context   = (CodeBuildContext*)visitContext;
+    FILE*             outStream = context->outStream;
+    TreeNode*         node      = *link;
 
-            fprintf(outStream, ") ");
+    if (node->valueType != TreeNodeValueType::OPERATION)
+        return TreeVisitAction::CONTINUE;
 
-            break;
-        }
-        case TreeOperationId::POW:
+    switch (node->value.operation)
+    {
+        case TreeOperationId::FUNC:
         {
-            fprintf(outStream, "(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, ") ^ (");
-
-            CODE_BUILD(node->right);
-
-            fprintf(outStream, ") ");
+            fprintf(outStream, "{\n");
 
+            context->numberOfTabs -= 1;
             break;
         }
 
-        case TreeOperationId::SIN:
+        case TreeOperationId::FUNC_CALL:
         {
-            fprintf(outStream, "sin(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, ") ");
-
+            fprintf(outStream, "57 ");
             break;
         }
-        case TreeOperationId::COS:
-        {
-            fprintf(outStream, "cos(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, ") ");
 
-            break;
-        }
-        case TreeOperationId::TAN:
+        case TreeOperationId::IF:
+        case TreeOperationId::WHILE:
         {
-            fprintf(outStream, "tan(");
-
-            CODE_BUILD(node->left);
-
-            fprintf(outStream, ") ");
+            context->numberOfTabs -= 1;
 
+            PrintTabs(context->numberOfTabs, outStream);
+            fprintf(outStream, "{\n");
             break;
         }
-        case TreeOperationId::COT:
-        {
-            fprintf(outStream, "cot(");
-
-            CODE_BUILD(node->left);
 
-            fprintf(outStream, ") ");
-
-            break;
-        }
+        case TreeOperationId::ADD:
+        case TreeOperationId::SUB:
+        case TreeOperationId::MUL:
+        case TreeOperationId::DIV:
+        case TreeOperationId::GREATER:
+        case TreeOperationId::GREATER_EQ:
+        case TreeOperationId::LESS:
+        case TreeOperationId::LESS_EQ:
+        case TreeOperationId::EQ:
+        case TreeOperationId::NOT_EQ:
+        case TreeOperationId::AND:
+        case TreeOperationId::OR:
+        case TreeOperationId::POW:
+        case TreeOperationId::SIN:
+        case TreeOperationId::COS:
+        case TreeOperationId::TAN:
+        case TreeOperationId::COT:
         case TreeOperationId::SQRT:
         {
-            fprintf(outStream, "sqrt(");
-
-            CODE_BUILD(node->left);
-
             fprintf(outStream, ") ");
-
             break;
         }
 
         default:
-        {
-            CODE_BUILD(node->left);
-            CODE_BUILD(node->right);
             break;
-        }
     }
+
+    return TreeVisitAction::CONTINUE;
 }
 
 static void PrintTabs(size_t numberOfTabs, FILE* outStream)
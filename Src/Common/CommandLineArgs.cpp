@@ -0,0 +1,34 @@
+#include <assert.h>
+#include <string.h>
+
+#include "CommandLineArgs.h"
+
+bool ArgsHasFlag(const int argc, char* const argv[], const char* flag)
+{
+    assert(argv);
+    assert(flag);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], flag) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+const char* ArgsGetOption(const int argc, char* const argv[], const char* optionName)
+{
+    assert(argv);
+    assert(optionName);
+
+    const size_t optionNameLength = strlen(optionName);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], optionName, optionNameLength) == 0)
+            return argv[i] + optionNameLength;
+    }
+
+    return nullptr;
+}
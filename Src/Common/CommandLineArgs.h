@@ -0,0 +1,22 @@
+#ifndef COMMAND_LINE_ARGS_H
+#define COMMAND_LINE_ARGS_H
+
+/// @file
+/// @brief Contains functions to work with optional command line flags.
+/// @details Flags are expected after the positional arguments (input / output files).
+
+/// @brief Checks if flag is passed to the program
+/// @param [in]argc argc from main
+/// @param [in]argv argv from main
+/// @param [in]flag flag to find (for example "--binary")
+/// @return true if flag is found otherwise false
+bool ArgsHasFlag(const int argc, char* const argv[], const char* flag);
+
+/// @brief Finds option in "--name=value" form
+/// @param [in]argc argc from main
+/// @param [in]argv argv from main
+/// @param [in]optionName option name with '=' at the end (for example "--dump=")
+/// @return pointer to the value in argv or nullptr if option is not found
+const char* ArgsGetOption(const int argc, char* const argv[], const char* optionName);
+
+#endif
@@ -2,14 +2,52 @@
 #include <execinfo.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <unistd.h>
 #include <fcntl.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "Log.h"
 
-static int LOG_FILE;
+// Logging is asynchronous: every thread formats its messages into its own ring buffer
+// and a background writer thread flushes all ring buffers to the log file.
+// Ring buffer has one producer (its thread) and one consumer (writer thread or LogFlush
+// under LOG_DRAIN_MUTEX), so head and tail are the only synchronization needed.
+
+static const size_t LOG_BUFFER_SIZE = 1 << 16; // has to be a power of 2
+
+struct LogBuffer
+{
+    char data[LOG_BUFFER_SIZE];
+
+    std::atomic<size_t> head; ///< total number of bytes written by the producer
+    std::atomic<size_t> tail; ///< total number of bytes flushed by the consumer
+
+    LogBuffer* next;
+};
+
+static int LOG_FILE = -1;
+
+static LogLevel LOG_LEVEL     = LogLevel::INFO;
+static bool     LOG_BACKTRACE = false;
+
+static std::atomic<LogBuffer*>  LOG_BUFFERS = {nullptr};
+static thread_local LogBuffer*  LOG_THREAD_BUFFER = nullptr;
+
+static std::mutex               LOG_DRAIN_MUTEX;
+static std::mutex               LOG_WRITER_MUTEX;
+static std::condition_variable  LOG_WRITER_CONDITION;
+static std::thread              LOG_WRITER;
+static bool                     LOG_WRITER_STOP = false;
+
+static const std::chrono::milliseconds LOG_WRITER_PERIOD(10);
 
 static inline void PrintSeparator();
 static void LogClose();
@@ -17,6 +55,13 @@ static void LogClose();
 static inline size_t Min(size_t a, size_t b);
 static int TryOpenFile(const char* name);
 
+static LogBuffer* LogGetThreadBuffer();
+static void LogBufferPush(const char* message, size_t length);
+static void LogBufferDrain(LogBuffer* buffer);
+static void LogDrainAll();
+static void LogWriterLoop();
+static void LogBacktrace(const char* header);
+
 void LogOpen(const char* argv0)
 {
     assert(argv0);
@@ -25,19 +70,63 @@ void LogOpen(const char* argv0)
     if (LOG_FILE == -1)
         return;
 
+    LogSetLevel(LogLevelFromString(getenv("LOG_LEVEL"), LogLevel::INFO));
+
+    const char* backtraceEnv = getenv("LOG_BACKTRACE");
+    LogSetBacktrace(backtraceEnv != nullptr && strcmp(backtraceEnv, "0") != 0);
+
+    LOG_WRITER_STOP = false;
+    LOG_WRITER      = std::thread(LogWriterLoop);
+
     time_t timeInSeconds = time(nullptr);
 
     Log("<pre>\n\n");
 
-    Log(HTML_RED_HEAD_BEGIN "\n" 
+    Log(HTML_RED_HEAD_BEGIN "\n"
         "Log file was opened by program %s, compiled %s at %s. "
         "Opening time: %s"
-        HTML_HEAD_END "\n", 
+        HTML_HEAD_END "\n",
         argv0, __DATE__, __TIME__, ctime(&timeInSeconds));
 
     atexit(LogClose);
 }
 
+void LogSetLevel(const LogLevel level)
+{
+    LOG_LEVEL = level;
+}
+
+bool LogLevelIsOn(const LogLevel level)
+{
+    return LOG_FILE != -1 && level <= LOG_LEVEL;
+}
+
+LogLevel LogLevelFromString(const char* levelName, const LogLevel defaultLevel)
+{
+    if (levelName == nullptr)
+        return defaultLevel;
+
+    if (strcasecmp(levelName, "none")  == 0) return LogLevel::NONE;
+    if (strcasecmp(levelName, "error") == 0) return LogLevel::ERROR;
+    if (strcasecmp(levelName, "info")  == 0) return LogLevel::INFO;
+    if (strcasecmp(levelName, "trace") == 0) return LogLevel::TRACE;
+
+    return defaultLevel;
+}
+
+void LogSetBacktrace(const bool captureBacktrace)
+{
+    LOG_BACKTRACE = captureBacktrace;
+}
+
+void LogFlush()
+{
+    if (LOG_FILE == -1)
+        return;
+
+    LogDrainAll();
+}
+
 static void LogClose()
 {
     if (LOG_FILE == -1)
@@ -54,6 +143,17 @@ static void LogClose()
 
     Log("</pre>\n");
 
+    {
+        std::lock_guard<std::mutex> lock(LOG_WRITER_MUTEX);
+        LOG_WRITER_STOP = true;
+    }
+    LOG_WRITER_CONDITION.notify_one();
+
+    if (LOG_WRITER.joinable())
+        LOG_WRITER.join();
+
+    LogDrainAll();
+
     close(LOG_FILE);
     LOG_FILE = -1;
 }
@@ -63,90 +163,214 @@ void LogBegin(const char* fileName, const char* funcName, const int line)
     assert(fileName);
     assert(funcName);
 
-    if (LOG_FILE == -1)
+    if (!LogLevelIsOn(LogLevel::INFO))
         return;
 
-    time_t timeInSeconds = time(nullptr);     
+    time_t timeInSeconds = time(nullptr);
 
-    Log("\n-----------------------\n\n"                            
-        HTML_GREEN_HEAD_BEGIN "\n"                                 
-        "New log called %s"                                        
-        "Called from file: %s, from function: %s, from line: %d\n" 
-        HTML_HEAD_END "\n\n\n",                                    
-        ctime(&timeInSeconds), fileName, funcName, line);                                 
+    Log("\n-----------------------\n\n"
+        HTML_GREEN_HEAD_BEGIN "\n"
+        "New log called %s"
+        "Called from file: %s, from function: %s, from line: %d\n"
+        HTML_HEAD_END "\n\n\n",
+        ctime(&timeInSeconds), fileName, funcName, line);
 
-    static const size_t buffSize = 128;
-    static void* buffer[buffSize];
-    int numb = backtrace(buffer, buffSize);
-    Log("Functions calling stack on beginning:\n");
-    backtrace_symbols_fd(buffer, numb, LOG_FILE);
+    if (LOG_BACKTRACE)
+        LogBacktrace("Functions calling stack on beginning:\n");
 }
 
 ssize_t Log(const char* format, ...)
 {
     assert(format);
 
+    if (!LogLevelIsOn(LogLevel::INFO))
+        return 0;
+
     va_list args = {};
 
     va_start(args, format);
 
     static const size_t BufSize = 1024;
-    static char buf[BufSize];
+    char buf[BufSize];
 
     size_t numberOfChars = (size_t) vsnprintf(buf, BufSize, format, args);
 
     va_end(args);
 
-    numberOfChars = Min(numberOfChars, BufSize);
-    
-    return write(LOG_FILE, buf, numberOfChars * sizeof(char));
+    numberOfChars = Min(numberOfChars, BufSize - 1);
+
+    LogBufferPush(buf, numberOfChars);
+
+    return (ssize_t)numberOfChars;
 }
 
 ssize_t LogError(const char* format, ...)
 {
     assert(format);
 
+    if (!LogLevelIsOn(LogLevel::ERROR))
+        return 0;
+
     va_list args = {};
 
     va_start(args, format);
 
+    static const size_t HeadBeginSize = sizeof(HTML_RED_HEAD_BEGIN) - 1;
+    static const size_t HeadEndSize   = sizeof(HTML_HEAD_END)       - 1;
+
     static const size_t BufSize = 1024;
-    static char buf[BufSize];
+    char buf[HeadBeginSize + BufSize + HeadEndSize];
 
-    size_t numberOfChars = (size_t) vsnprintf(buf, BufSize, format, args);
+    memcpy(buf, HTML_RED_HEAD_BEGIN, HeadBeginSize);
+
+    size_t numberOfChars = (size_t) vsnprintf(buf + HeadBeginSize, BufSize, format, args);
 
     va_end(args);
 
-    numberOfChars = Min(numberOfChars, BufSize);
-    
-    ssize_t numberOfPrintedChars = 0;
-    
-    //TODO: check each print result
-    numberOfPrintedChars += write(LOG_FILE, HTML_RED_HEAD_BEGIN, sizeof(HTML_RED_HEAD_BEGIN) - 1);
-    numberOfPrintedChars += write(LOG_FILE, buf, numberOfChars * sizeof(char));
-    numberOfPrintedChars += write(LOG_FILE, HTML_HEAD_END,       sizeof(HTML_HEAD_END) - 1);
-    
-    return numberOfPrintedChars;
+    numberOfChars = Min(numberOfChars, BufSize - 1);
+
+    memcpy(buf + HeadBeginSize + numberOfChars, HTML_HEAD_END, HeadEndSize);
+    numberOfChars += HeadBeginSize + HeadEndSize;
+
+    LogBufferPush(buf, numberOfChars);
+
+    return (ssize_t)numberOfChars;
 }
 
 void LogEnd(const char* fileName, const char* funcName, const int line)
 {
+    if (!LogLevelIsOn(LogLevel::INFO))
+        return;
+
+    if (LOG_BACKTRACE)
+        LogBacktrace("Functions calling stack on ending:\n");
+
+    time_t timeInSeconds = time(nullptr);
+    Log("\n" HTML_GREEN_HEAD_BEGIN "\n"
+        "Logging ended %s"
+        "Ended in file: %s, function: %s, line: %d\n"
+        HTML_HEAD_END "\n\n"
+        "-----------------------\n\n\n",
+        ctime(&timeInSeconds), fileName, funcName, line);
+}
+
+static void LogBacktrace(const char* header)
+{
+    assert(header);
+
     static const size_t buffSize = 128;
-    static void* buffer[buffSize];
+    void* buffer[buffSize];
     int numb = backtrace(buffer, buffSize);
-    
-    Log("Functions calling stack on ending:\n");
-    backtrace_symbols_fd(buffer, numb, LOG_FILE);
 
-    time_t timeInSeconds = time(nullptr);  
-    Log("\n" HTML_GREEN_HEAD_BEGIN "\n"                       
-        "Logging ended %s"                                    
-        "Ended in file: %s, function: %s, line: %d\n"         
-        HTML_HEAD_END "\n\n"                                  
-        "-----------------------\n\n\n",                      
-        ctime(&timeInSeconds), fileName, funcName, line);                                 
+    Log("%s", header);
+
+    char** symbols = backtrace_symbols(buffer, numb);
+    if (symbols == nullptr)
+        return;
+
+    for (int i = 0; i < numb; ++i)
+        Log("%s\n", symbols[i]);
+
+    free(symbols);
+}
+
+//---------------------------------------------------------------------------------------
+
+static LogBuffer* LogGetThreadBuffer()
+{
+    if (LOG_THREAD_BUFFER)
+        return LOG_THREAD_BUFFER;
+
+    LogBuffer* buffer = new LogBuffer;
+    buffer->head.store(0);
+    buffer->tail.store(0);
+
+    // Buffers are never removed from the list, so lock-free push to the front is enough
+    buffer->next = LOG_BUFFERS.load(std::memory_order_relaxed);
+    while (!LOG_BUFFERS.compare_exchange_weak(buffer->next, buffer, std::memory_order_release,
+                                                                    std::memory_order_relaxed))
+        ;
+
+    LOG_THREAD_BUFFER = buffer;
+    return buffer;
 }
 
+// Message is published only as a whole, so messages of different threads are never mixed
+static void LogBufferPush(const char* message, size_t length)
+{
+    assert(message);
+    assert(length <= LOG_BUFFER_SIZE);
+
+    LogBuffer* buffer = LogGetThreadBuffer();
+
+    size_t head = buffer->head.load(std::memory_order_relaxed);
+
+    while (LOG_BUFFER_SIZE - (head - buffer->tail.load(std::memory_order_acquire)) < length)
+    {
+        LOG_WRITER_CONDITION.notify_one();
+        std::this_thread::yield();
+    }
+
+    size_t pos        = head & (LOG_BUFFER_SIZE - 1);
+    size_t firstChunk = Min(length, LOG_BUFFER_SIZE - pos);
+
+    memcpy(buffer->data + pos, message, firstChunk);
+    memcpy(buffer->data, message + firstChunk, length - firstChunk);
+
+    head += length;
+    buffer->head.store(head, std::memory_order_release);
+
+    if (head - buffer->tail.load(std::memory_order_relaxed) > LOG_BUFFER_SIZE / 2)
+        LOG_WRITER_CONDITION.notify_one();
+}
+
+// Has to be called under LOG_DRAIN_MUTEX
+static void LogBufferDrain(LogBuffer* buffer)
+{
+    assert(buffer);
+
+    size_t tail = buffer->tail.load(std::memory_order_relaxed);
+    size_t head = buffer->head.load(std::memory_order_acquire);
+
+    while (tail != head)
+    {
+        size_t pos   = tail & (LOG_BUFFER_SIZE - 1);
+        size_t chunk = Min(head - tail, LOG_BUFFER_SIZE - pos);
+
+        ssize_t written = write(LOG_FILE, buffer->data + pos, chunk);
+        if (written <= 0)
+            written = (ssize_t)chunk; // dropping on error so producers are never blocked forever
+
+        tail += (size_t)written;
+        buffer->tail.store(tail, std::memory_order_release);
+    }
+}
+
+static void LogDrainAll()
+{
+    std::lock_guard<std::mutex> lock(LOG_DRAIN_MUTEX);
+
+    for (LogBuffer* buffer = LOG_BUFFERS.load(std::memory_order_acquire); buffer;
+                    buffer = buffer->next)
+        LogBufferDrain(buffer);
+}
+
+static void LogWriterLoop()
+{
+    std::unique_lock<std::mutex> lock(LOG_WRITER_MUTEX);
+
+    while (!LOG_WRITER_STOP)
+    {
+        LOG_WRITER_CONDITION.wait_for(lock, LOG_WRITER_PERIOD);
+
+        lock.unlock();
+        LogDrainAll();
+        lock.lock();
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
 static inline void PrintSeparator()
 {
     Log("\n\n---------------------------------------------------------------------------\n\n");
@@ -163,7 +387,7 @@ static int TryOpenFile(const char* name)
 
     const size_t  fileNameSize  = 256;
     char fileName[fileNameSize] = "";
-    
+
     assert(strlen(name) + sizeof(fileSuffix) <= fileNameSize);
     snprintf(fileName, fileNameSize, "%s%s", name, fileSuffix);
 
@@ -174,6 +398,6 @@ static int TryOpenFile(const char* name)
         creat(fileName, 0666);
         LOG_FILE = open(fileName, O_WRONLY | O_APPEND);
     }
-    
+
     return LOG_FILE;
-}
\ No newline at end of file
+}
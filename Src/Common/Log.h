@@ -6,10 +6,48 @@
 
 #include "Colors.h"
 
-/// @brief Opens log file with name argv0
+//#define LOG_NO_TRACE
+
+/// @brief Levels of logging. Messages with level higher than current one are not printed
+enum class LogLevel
+{
+    NONE,
+    ERROR,  ///< LogError
+    INFO,   ///< Log, LogBegin, LogEnd
+    TRACE,  ///< per node / per token tracing, LOG_TRACE
+};
+
+/// @brief Opens log file with name argv0 and starts background writer thread
+/// @details Log level is taken from LOG_LEVEL environment variable (none, error, info, trace).
+/// @details INFO is used by default. Backtraces in LogBegin / LogEnd are captured only
+/// @details if LOG_BACKTRACE environment variable is set (and is not "0").
 /// @param [in]argv0 log file name (usually argv[0])
 void LogOpen(const char* argv0);
 
+/// @brief Turns on / off capturing functions calling stack in LogBegin and LogEnd
+/// @param [in]captureBacktrace true to capture backtraces
+void LogSetBacktrace(const bool captureBacktrace);
+
+/// @brief Synchronously writes everything logged so far to the log file
+/// @details Messages are buffered and written by background thread, 
+/// @details so this can be used before something dangerous (for example abort)
+void LogFlush();
+
+/// @brief Sets current log level
+/// @param [in]level new log level
+void LogSetLevel(const LogLevel level);
+
+/// @brief Checks if messages with level are printed
+/// @param [in]level level to check
+/// @return true if messages with this level are printed otherwise false
+bool LogLevelIsOn(const LogLevel level);
+
+/// @brief Converts level name (none, error, info, trace) to LogLevel
+/// @param [in]levelName name to convert
+/// @param [in]defaultLevel level returned if levelName is unknown or nullptr
+/// @return log level
+LogLevel LogLevelFromString(const char* levelName, const LogLevel defaultLevel);
+
 /// @brief Begins new logging part
 /// @param [in]fileName file from which logging is called
 /// @param [in]funcName function from which logging is called
@@ -20,6 +58,7 @@ void LogBegin(const char* fileName, const char* funcName, const int line);
 #define LOG_BEGIN() LogBegin(__FILE__, __func__, __LINE__)
 
 /// @brief Prints string to log file
+/// @details String is put in the calling thread buffer and is written to the file later
 /// @param [in]format string format as in printf
 /// @param [in]params as in printf
 ssize_t Log(const char* format, ...);
@@ -35,4 +74,25 @@ void LogEnd(const char* fileName, const char* funcName, const int line);
 /// @brief LogEnd with __FILE__, __func__, __LINE__
 #define LOG_END() LogEnd(__FILE__, __func__, __LINE__);
 
+#ifndef LOG_NO_TRACE
+
+    /// @brief Executes code only if LogLevel::TRACE is on
+    #define ON_LOG_TRACE(...)                       \
+    do                                              \
+    {                                               \
+        if (LogLevelIsOn(LogLevel::TRACE))          \
+        {                                           \
+            __VA_ARGS__                             \
+        }                                           \
+    } while (0)
+
+#else
+
+    #define ON_LOG_TRACE(...) do {} while (0)
+
+#endif
+
+/// @brief Log with LogLevel::TRACE. Compiled out if LOG_NO_TRACE is defined
+#define LOG_TRACE(...) ON_LOG_TRACE(Log(__VA_ARGS__);)
+
 #endif
\ No newline at end of file
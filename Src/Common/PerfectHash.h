@@ -0,0 +1,142 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+/// @file
+/// @brief Contains compile-time perfect hash tables for small fixed sets of strings.
+/// @details Seed of the hash is chosen at compile time so that no two keys share a slot,
+/// so lookup is one hash calculation and one string comparison.
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Key of the perfect hash table and value returned for it
+struct PerfectHashKey
+{
+    const char* name;
+    int         value;
+};
+
+/// @brief Perfect hash table, has to be created with PerfectHashTableCreate
+template <size_t KeysCount, size_t TableSize>
+struct PerfectHashTable
+{
+    static_assert((TableSize & (TableSize - 1)) == 0, "TableSize has to be a power of 2");
+    static_assert(KeysCount <= TableSize, "TableSize is too small");
+
+    PerfectHashKey keys [KeysCount];
+    int            slots[TableSize];    ///< index in keys, -1 if slot is empty
+    uint32_t       seed;
+    bool           ignoreCase;
+};
+
+static constexpr char PerfectHashToLower(const char c)
+{
+    return 'A' <= c && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+}
+
+/// @brief FNV-1a hash with seed
+static constexpr uint32_t PerfectHashString(const char* string, const size_t length,
+                                            const uint32_t seed, const bool ignoreCase)
+{
+    uint32_t hash = 2166136261u ^ seed;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= (uint8_t)(ignoreCase ? PerfectHashToLower(string[i]) : string[i]);
+        hash *= 16777619u;
+    }
+
+    return hash ^ (hash >> 15);
+}
+
+static constexpr size_t PerfectHashStrlen(const char* string)
+{
+    size_t length = 0;
+    while (string[length] != '\0')
+        ++length;
+
+    return length;
+}
+
+/// @brief Chooses the seed without collisions and fills the table at compile time
+template <size_t TableSize, size_t KeysCount>
+static constexpr PerfectHashTable<KeysCount, TableSize>
+PerfectHashTableCreate(const PerfectHashKey (&keys)[KeysCount], const bool ignoreCase)
+{
+    PerfectHashTable<KeysCount, TableSize> table = {};
+
+    for (size_t i = 0; i < KeysCount; ++i)
+        table.keys[i] = keys[i];
+
+    table.ignoreCase = ignoreCase;
+
+    for (uint32_t seed = 0; ; ++seed)
+    {
+        for (size_t slot = 0; slot < TableSize; ++slot)
+            table.slots[slot] = -1;
+
+        bool collision = false;
+        for (size_t i = 0; i < KeysCount && !collision; ++i)
+        {
+            size_t slot = PerfectHashString(keys[i].name, PerfectHashStrlen(keys[i].name),
+                                            seed, ignoreCase) & (TableSize - 1);
+
+            if (table.slots[slot] != -1)
+                collision = true;
+            else
+                table.slots[slot] = (int)i;
+        }
+
+        if (!collision)
+        {
+            table.seed = seed;
+            return table;
+        }
+    }
+}
+
+/// @brief Finds string in the table
+/// @param [in]table table to find in
+/// @param [in]string string to find (doesn't have to be null terminated)
+/// @param [in]length length of the string
+/// @param [out]outValue value of the key if found
+/// @return true if string is found otherwise false
+template <size_t KeysCount, size_t TableSize>
+static inline bool PerfectHashFind(const PerfectHashTable<KeysCount, TableSize>& table,
+                                   const char* string, const size_t length, int* outValue)
+{
+    assert(string);
+    assert(outValue);
+
+    size_t slot = PerfectHashString(string, length, table.seed, table.ignoreCase) & (TableSize - 1);
+
+    if (table.slots[slot] == -1)
+        return false;
+
+    const PerfectHashKey* key = &table.keys[table.slots[slot]];
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        char keyChar    = key->name[i];
+        char stringChar = string[i];
+
+        if (table.ignoreCase)
+        {
+            keyChar    = PerfectHashToLower(keyChar);
+            stringChar = PerfectHashToLower(stringChar);
+        }
+
+        // key ending before the string is caught here too
+        if (keyChar != stringChar)
+            return false;
+    }
+
+    if (key->name[length] != '\0')
+        return false;
+
+    *outValue = key->value;
+    return true;
+}
+
+#endif
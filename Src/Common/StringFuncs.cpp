@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <limits.h>
 
 #include "StringFuncs.h"
 
@@ -36,3 +37,55 @@ const char* SkipSymbolsWhileStatement(const char* string, int (*statementFunc)(i
     
     return stringPtr;
 }
+
+ScanIntErrors ScanInt(const char* string, int* outValue, size_t* outLength)
+{
+    assert(string);
+    assert(outValue);
+    assert(outLength);
+
+    const char* stringPtr = string;
+
+    while (*stringPtr == ' ' || ('\t' <= *stringPtr && *stringPtr <= '\r'))
+        ++stringPtr;
+
+    bool isNegative = false;
+    if (*stringPtr == '-' || *stringPtr == '+')
+    {
+        isNegative = *stringPtr == '-';
+        ++stringPtr;
+    }
+
+    if (*stringPtr < '0' || '9' < *stringPtr)
+    {
+        *outLength = 0;
+        return ScanIntErrors::NO_DIGITS;
+    }
+
+    // INT_MIN absolute value is bigger than INT_MAX
+    const unsigned int limit = isNegative ? (unsigned int)INT_MAX + 1u : (unsigned int)INT_MAX;
+
+    unsigned int value    = 0;
+    bool         overflow = false;
+
+    while ('0' <= *stringPtr && *stringPtr <= '9')
+    {
+        unsigned int digit = (unsigned int)(*stringPtr - '0');
+
+        if (value > (limit - digit) / 10)
+            overflow = true;
+        else
+            value = value * 10 + digit;
+
+        ++stringPtr;
+    }
+
+    *outLength = (size_t)(stringPtr - string);
+
+    if (overflow)
+        return ScanIntErrors::OVERFLOW_ERR;
+
+    *outValue = isNegative ? (int)(0u - value) : (int)value;
+
+    return ScanIntErrors::NO_ERR;
+}
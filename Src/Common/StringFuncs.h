@@ -1,8 +1,27 @@
 #ifndef STRING_FUNCS_H
 #define STRING_FUNCS_H
 
+#include <stddef.h>
+
 const char* SkipSymbolsUntilStopChar (const char* string, const char stopChar);
 const char* SkipSymbolsWhileStatement(const char* string, int (*statementFunc)(int));
 const char* SkipSymbolsWhileChar     (const char* string, const char skippingChar);
 
+enum class ScanIntErrors
+{
+    NO_ERR,
+
+    NO_DIGITS,
+    OVERFLOW_ERR,
+};
+
+/// @brief Reads decimal int the same way sscanf("%d%n") does, but reports overflow
+/// @details Skips leading whitespaces, reads optional sign and digits. 
+/// On overflow all digits are consumed anyway
+/// @param [in]string string to read from
+/// @param [out]outValue read value (not changed on error)
+/// @param [out]outLength number of consumed chars including skipped whitespaces (0 if no digits)
+/// @return errors that occurred
+ScanIntErrors ScanInt(const char* string, int* outValue, size_t* outLength);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mutex>
+
+#include "SymbolPool.h"
+
+// Strings are copied to big chunks one after another, chunks are never reallocated,
+// so interned strings never move. Symbol ids are positions in the names array.
+// Hash index is open addressing table that contains symbol ids.
+// Pool is guarded by the mutex. Every thread also has a small direct mapped cache of
+// the strings it interned, cache hits don't lock: interned strings never move,
+// so they can be compared without the pool.
+
+static const size_t SYMBOL_POOL_CHUNK_SIZE     = 1 << 14;
+static const size_t SYMBOL_POOL_START_CAPACITY = 256;        // has to be a power of 2
+
+struct SymbolPoolChunk
+{
+    SymbolPoolChunk* prev;
+
+    char*  data;
+    size_t size;
+    size_t capacity;
+};
+
+struct SymbolPool
+{
+    SymbolPoolChunk* chunk;    ///< current chunk, previous ones are linked by prev
+
+    const char** names;        ///< names[symbol] - interned string
+    size_t*      lengths;
+    uint32_t*    hashes;
+    size_t       size;
+    size_t       capacity;
+
+    SymbolId*    index;        ///< SYMBOL_ID_POISON - empty slot
+    size_t       indexCapacity;
+};
+
+static SymbolPool SYMBOL_POOL = {};
+static std::mutex SYMBOL_POOL_MUTEX;
+
+static const size_t SYMBOL_CACHE_SIZE = 256;   // has to be a power of 2
+
+struct SymbolCacheEntry
+{
+    const char* name;       ///< interned string, nullptr if entry is empty
+    size_t      length;
+    uint32_t    hash;
+    SymbolId    symbol;
+};
+
+static thread_local SymbolCacheEntry SYMBOL_CACHE[SYMBOL_CACHE_SIZE] = {};
+
+static bool SymbolPoolCtor();
+static void SymbolPoolDtor();
+
+static bool SymbolPoolRealloc();
+static char* SymbolPoolCopyString(const char* string, const size_t length);
+static SymbolId SymbolPoolFind(const char* string, const size_t length, const uint32_t hash);
+
+static inline uint32_t SymbolHash(const char* string, const size_t length);
+
+//---------------------------------------------------------------------------------------
+
+SymbolId SymbolIntern(const char* string)
+{
+    assert(string);
+
+    return SymbolIntern(string, strlen(string));
+}
+
+SymbolId SymbolIntern(const char* string, const size_t length)
+{
+    assert(string);
+
+    uint32_t hash = SymbolHash(string, length);
+
+    SymbolCacheEntry* cacheEntry = &SYMBOL_CACHE[hash & (SYMBOL_CACHE_SIZE - 1)];
+
+    if (cacheEntry->name != nullptr && cacheEntry->hash == hash && cacheEntry->length == length &&
+        memcmp(cacheEntry->name, string, length) == 0)
+        return cacheEntry->symbol;
+
+    std::lock_guard<std::mutex> lock(SYMBOL_POOL_MUTEX);
+
+    if (SYMBOL_POOL.index == nullptr && !SymbolPoolCtor())
+        return SYMBOL_ID_POISON;
+
+    SymbolId symbol = SymbolPoolFind(string, length, hash);
+
+    if (symbol != SYMBOL_ID_POISON)
+    {
+        *cacheEntry = {SYMBOL_POOL.names[symbol], length, hash, symbol};
+        return symbol;
+    }
+
+    // Index is kept twice bigger than names so its load factor is always <= 1/2
+    if (SYMBOL_POOL.size >= SYMBOL_POOL.capacity && !SymbolPoolRealloc())
+        return SYMBOL_ID_POISON;
+
+    char* name = SymbolPoolCopyString(string, length);
+    if (name == nullptr)
+        return SYMBOL_ID_POISON;
+
+    symbol = (SymbolId)SYMBOL_POOL.size++;
+
+    SYMBOL_POOL.names  [symbol] = name;
+    SYMBOL_POOL.lengths[symbol] = length;
+    SYMBOL_POOL.hashes [symbol] = hash;
+
+    const size_t mask = SYMBOL_POOL.indexCapacity - 1;
+
+    size_t slot = hash & mask;
+    while (SYMBOL_POOL.index[slot] != SYMBOL_ID_POISON)
+        slot = (slot + 1) & mask;
+
+    SYMBOL_POOL.index[slot] = symbol;
+
+    *cacheEntry = {name, length, hash, symbol};
+
+    return symbol;
+}
+
+SymbolId SymbolFind(const char* string)
+{
+    assert(string);
+
+    std::lock_guard<std::mutex> lock(SYMBOL_POOL_MUTEX);
+
+    if (SYMBOL_POOL.index == nullptr)
+        return SYMBOL_ID_POISON;
+
+    size_t length = strlen(string);
+
+    return SymbolPoolFind(string, length, SymbolHash(string, length));
+}
+
+const char* SymbolGetName(const SymbolId symbol)
+{
+    std::lock_guard<std::mutex> lock(SYMBOL_POOL_MUTEX);
+
+    assert(symbol < SYMBOL_POOL.size);
+
+    return SYMBOL_POOL.names[symbol];
+}
+
+//---------------------------------------------------------------------------------------
+
+static SymbolId SymbolPoolFind(const char* string, const size_t length, const uint32_t hash)
+{
+    assert(string);
+    assert(SYMBOL_POOL.index);
+
+    const size_t mask = SYMBOL_POOL.indexCapacity - 1;
+
+    for (size_t slot = hash & mask; SYMBOL_POOL.index[slot] != SYMBOL_ID_POISON;
+                slot = (slot + 1) & mask)
+    {
+        SymbolId symbol = SYMBOL_POOL.index[slot];
+
+        if (SYMBOL_POOL.hashes[symbol] == hash && SYMBOL_POOL.lengths[symbol] == length &&
+            memcmp(SYMBOL_POOL.names[symbol], string, length) == 0)
+            return symbol;
+    }
+
+    return SYMBOL_ID_POISON;
+}
+
+static char* SymbolPoolCopyString(const char* string, const size_t length)
+{
+    assert(string);
+
+    SymbolPoolChunk* chunk = SYMBOL_POOL.chunk;
+
+    if (chunk == nullptr || chunk->capacity - chunk->size < length + 1)
+    {
+        size_t capacity = length + 1 > SYMBOL_POOL_CHUNK_SIZE ? length + 1 : SYMBOL_POOL_CHUNK_SIZE;
+
+        chunk = (SymbolPoolChunk*)calloc(1, sizeof(*chunk));
+        if (chunk == nullptr)
+            return nullptr;
+
+        chunk->data = (char*)calloc(capacity, sizeof(*chunk->data));
+        if (chunk->data == nullptr)
+        {
+            free(chunk);
+            return nullptr;
+        }
+
+        chunk->capacity = capacity;
+        chunk->prev     = SYMBOL_POOL.chunk;
+
+        SYMBOL_POOL.chunk = chunk;
+    }
+
+    char* name = chunk->data + chunk->size;
+
+    memcpy(name, string, length);
+    name[length] = '\0';
+
+    chunk->size += length + 1;
+
+    return name;
+}
+
+//---------------------------------------------------------------------------------------
+
+static bool SymbolPoolCtor()
+{
+    SYMBOL_POOL.capacity = SYMBOL_POOL_START_CAPACITY / 2;
+
+    SYMBOL_POOL.names   = (const char**)calloc(SYMBOL_POOL.capacity, sizeof(*SYMBOL_POOL.names));
+    SYMBOL_POOL.lengths = (size_t*)     calloc(SYMBOL_POOL.capacity, sizeof(*SYMBOL_POOL.lengths));
+    SYMBOL_POOL.hashes  = (uint32_t*)   calloc(SYMBOL_POOL.capacity, sizeof(*SYMBOL_POOL.hashes));
+
+    SYMBOL_POOL.indexCapacity = SYMBOL_POOL_START_CAPACITY;
+    SYMBOL_POOL.index = (SymbolId*)calloc(SYMBOL_POOL.indexCapacity, sizeof(*SYMBOL_POOL.index));
+
+    if (SYMBOL_POOL.names == nullptr || SYMBOL_POOL.lengths == nullptr ||
+        SYMBOL_POOL.hashes == nullptr || SYMBOL_POOL.index == nullptr)
+    {
+        SymbolPoolDtor();
+        return false;
+    }
+
+    for (size_t i = 0; i < SYMBOL_POOL.indexCapacity; ++i)
+        SYMBOL_POOL.index[i] = SYMBOL_ID_POISON;
+
+    atexit(SymbolPoolDtor);
+
+    return true;
+}
+
+static void SymbolPoolDtor()
+{
+    while (SYMBOL_POOL.chunk)
+    {
+        SymbolPoolChunk* prev = SYMBOL_POOL.chunk->prev;
+
+        free(SYMBOL_POOL.chunk->data);
+        free(SYMBOL_POOL.chunk);
+
+        SYMBOL_POOL.chunk = prev;
+    }
+
+    free(SYMBOL_POOL.names);
+    free(SYMBOL_POOL.lengths);
+    free(SYMBOL_POOL.hashes);
+    free(SYMBOL_POOL.index);
+
+    SYMBOL_POOL = {};
+}
+
+static bool SymbolPoolRealloc()
+{
+    size_t capacity      = SYMBOL_POOL.capacity      << 1;
+    size_t indexCapacity = SYMBOL_POOL.indexCapacity << 1;
+
+    const char** names   = (const char**)realloc(SYMBOL_POOL.names,   capacity * sizeof(*names));
+    if (names   == nullptr) return false;
+    SYMBOL_POOL.names = names;
+
+    size_t*      lengths = (size_t*)     realloc(SYMBOL_POOL.lengths, capacity * sizeof(*lengths));
+    if (lengths == nullptr) return false;
+    SYMBOL_POOL.lengths = lengths;
+
+    uint32_t*    hashes  = (uint32_t*)   realloc(SYMBOL_POOL.hashes,  capacity * sizeof(*hashes));
+    if (hashes  == nullptr) return false;
+    SYMBOL_POOL.hashes = hashes;
+
+    SymbolId* index = (SymbolId*)calloc(indexCapacity, sizeof(*index));
+    if (index == nullptr) return false;
+
+    for (size_t i = 0; i < indexCapacity; ++i)
+        index[i] = SYMBOL_ID_POISON;
+
+    const size_t mask = indexCapacity - 1;
+    for (size_t symbol = 0; symbol < SYMBOL_POOL.size; ++symbol)
+    {
+        size_t slot = SYMBOL_POOL.hashes[symbol] & mask;
+        while (index[slot] != SYMBOL_ID_POISON)
+            slot = (slot + 1) & mask;
+
+        index[slot] = (SymbolId)symbol;
+    }
+
+    free(SYMBOL_POOL.index);
+
+    SYMBOL_POOL.index         = index;
+    SYMBOL_POOL.indexCapacity = indexCapacity;
+    SYMBOL_POOL.capacity      = capacity;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+
+// FNV-1a
+static inline uint32_t SymbolHash(const char* string, const size_t length)
+{
+    assert(string);
+
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= (uint8_t)string[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
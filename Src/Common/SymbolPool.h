@@ -0,0 +1,40 @@
+#ifndef SYMBOL_POOL_H
+#define SYMBOL_POOL_H
+
+/// @file
+/// @brief Contains global string interning pool.
+/// @details Every string is stored in the pool only once and gets a symbol id.
+/// Strings are never moved or freed until the program ends,
+/// so pointers returned by SymbolGetName() are valid all the time.
+/// All functions can be called from several threads at once.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t SymbolId;
+
+/// @brief Symbol id that is never given to a string
+static const SymbolId SYMBOL_ID_POISON = UINT32_MAX;
+
+/// @brief Puts string to the pool if it isn't there yet
+/// @param [in]string string to intern
+/// @return symbol id of the string or SYMBOL_ID_POISON if memory allocation failed
+SymbolId SymbolIntern(const char* string);
+
+/// @brief Puts string to the pool if it isn't there yet
+/// @param [in]string string to intern (doesn't have to be null terminated)
+/// @param [in]length length of the string
+/// @return symbol id of the string or SYMBOL_ID_POISON if memory allocation failed
+SymbolId SymbolIntern(const char* string, const size_t length);
+
+/// @brief Finds string in the pool without interning it
+/// @param [in]string string to find
+/// @return symbol id of the string or SYMBOL_ID_POISON if string is not in the pool
+SymbolId SymbolFind(const char* string);
+
+/// @brief Gets interned string
+/// @param [in]symbol symbol id given by SymbolIntern
+/// @return null terminated string that lives until the end of the program
+const char* SymbolGetName(const SymbolId symbol);
+
+#endif
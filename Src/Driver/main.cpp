@@ -0,0 +1,103 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Common/Log.h"
+#include "Common/CommandLineArgs.h"
+#include "FastInput/InputOutput.h"
+#include "FrontEnd/SyntaxParser.h"
+#include "MiddleEnd/MiddleEnd.h"
+#include "BackEnd/BackEnd.h"
+
+// Runs frontEnd, middleEnd and backEnd in one process passing the tree in memory.
+// Usage: compiler <input file> <asm file> <bin file>
+//                 [--parse-tree=<file>] [--simplified-tree=<file>] [--binary] [--dump=<policy>]
+//                 [--lex-threads=<count>] [--parse-threads=<count>] [--inline-size=<nodes>]
+// Intermediate trees are written only if their files are given (in binary format with --binary).
+// With --lex-threads code is lexed beforehand on several threads instead of on demand.
+// With --parse-threads function definitions are lexed and parsed on several threads.
+// With --inline-size callees of at most that many nodes are inlined, 0 turns inlining off.
+
+static void DumpIntermediateTree(const Tree* tree, const char* fileName, TreeFileFormat format);
+
+int main(int argc, char* argv[])
+{
+    assert(argc > 3);
+
+    LogOpen(argv[0]);
+    TreeDumpPolicyInit(ArgsGetOption(argc, argv, "--dump="));
+    setbuf(stdout, nullptr);
+
+    FILE* inStream     = fopen(argv[1], "r");
+    FILE* outStream    = fopen(argv[2], "w");
+    FILE* outBinStream = fopen(argv[3], "w");
+
+    if (inStream == nullptr || outStream == nullptr || outBinStream == nullptr)
+    {
+        fprintf(stderr, "Can't open files\n");
+        return 1;
+    }
+
+    TreeFileFormat treeFormat = ArgsHasFlag(argc, argv, "--binary") ? TreeFileFormat::BINARY :
+                                                                       TreeFileFormat::PREFIX;
+
+    MappedText inputTxt = {};
+    MappedTextCtor(&inputTxt, inStream);
+
+    const char* lexThreadsOption = ArgsGetOption(argc, argv, "--lex-threads=");
+    size_t      lexThreadsCount  = lexThreadsOption ? strtoul(lexThreadsOption, nullptr, 10) : 0;
+
+    const char* parseThreadsOption = ArgsGetOption(argc, argv, "--parse-threads=");
+    size_t      parseThreadsCount  = parseThreadsOption ? strtoul(parseThreadsOption, nullptr, 10) : 0;
+
+    const char* inlineSizeOption = ArgsGetOption(argc, argv, "--inline-size=");
+    size_t      inlineSizeLimit  = inlineSizeOption ? strtoul(inlineSizeOption, nullptr, 10) :
+                                                      TREE_INLINE_STANDARD_SIZE_LIMIT;
+
+    SyntaxParserErrors err = SyntaxParserErrors::NO_ERR;
+    Tree tree = parseThreadsCount > 0 ? CodeParseParallel(inputTxt.text, &err, parseThreadsCount) :
+                                        CodeParse        (inputTxt.text, &err, lexThreadsCount);
+
+    MappedTextDtor(&inputTxt);
+
+    if (err == SyntaxParserErrors::NO_ERR)
+    {
+        DumpIntermediateTree(&tree, ArgsGetOption(argc, argv, "--parse-tree="), treeFormat);
+        TreeGraphicDump(&tree, false);
+
+        TreeSimplify(&tree, inlineSizeLimit);
+
+        DumpIntermediateTree(&tree, ArgsGetOption(argc, argv, "--simplified-tree="), treeFormat);
+        TreeGraphicDump(&tree, false);
+
+        AsmCodeBuild(&tree, outStream, outBinStream);
+    }
+
+    TreeDtor(&tree);
+
+    fclose(inStream);
+    fclose(outStream);
+    fclose(outBinStream);
+
+    return (int)err;
+}
+
+static void DumpIntermediateTree(const Tree* tree, const char* fileName, TreeFileFormat format)
+{
+    assert(tree);
+
+    if (fileName == nullptr)
+        return;
+
+    FILE* outStream = fopen(fileName, "w");
+
+    if (outStream == nullptr)
+    {
+        fprintf(stderr, "Can't open file %s\n", fileName);
+        return;
+    }
+
+    TreePrint(tree, outStream, format);
+
+    fclose(outStream);
+}
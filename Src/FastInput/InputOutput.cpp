@@ -2,7 +2,10 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "Common/Colors.h"
 #include "InputOutput.h"
@@ -10,6 +13,10 @@
 
 //------------------------------------------------------------------------------------------------
 
+static int MappedTextMap (MappedText* text, const int fd, const size_t fileSize);
+static int MappedTextRead(MappedText* text, FILE* const inStream);
+
+//------------------------------------------------------------------------------------------------
 
 int TextTypeCtor(TextType* text, const char* const fileName)
 {
@@ -93,6 +100,114 @@ char* ReadText(FILE* const inStream)
 
 //------------------------------------------------------------------------------------------------
 
+int MappedTextCtor(MappedText* text, FILE* const inStream)
+{
+    assert(text);
+    assert(inStream);
+
+    *text = {};
+
+    int fd = fileno(inStream);
+    struct stat fileStats = {};
+
+    if (fd != -1 && fstat(fd, &fileStats) == 0 && S_ISREG(fileStats.st_mode) && fileStats.st_size > 0 &&
+        MappedTextMap(text, fd, (size_t)fileStats.st_size) == 0)
+        return 0;
+
+    return MappedTextRead(text, inStream);
+}
+
+//------------------------------------------------------------------------------------------------
+
+static int MappedTextMap(MappedText* text, const int fd, const size_t fileSize)
+{
+    assert(text);
+
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+    // file pages + at least one zero page for the sentinel
+    const size_t mappingSz = (fileSize / pageSize + 1) * pageSize;
+
+    void* mapping = mmap(nullptr, mappingSz, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+        return -1;
+
+    // file replaces the beginning of the zero reserved region, the rest of its last page is zeroed
+    void* fileMapping = mmap(mapping, fileSize, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (fileMapping == MAP_FAILED)
+    {
+        munmap(mapping, mappingSz);
+        return -1;
+    }
+
+    madvise(mapping, fileSize, MADV_SEQUENTIAL);
+
+    text->text      = (const char*)mapping;
+    text->textSz    = fileSize;
+    text->mapping   = mapping;
+    text->mappingSz = mappingSz;
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------------------------
+
+static int MappedTextRead(MappedText* text, FILE* const inStream)
+{
+    assert(text);
+    assert(inStream);
+
+    size_t capacity = 1 << 12;
+    size_t size     = 0;
+
+    char* buffer = (char*) calloc(capacity, sizeof(*buffer));
+    if (buffer == nullptr)
+        return -1;
+
+    size_t nRead = 0;
+    while ((nRead = fread(buffer + size, sizeof(*buffer), capacity - size - 1, inStream)) > 0)
+    {
+        size += nRead;
+
+        if (capacity - size > 1)
+            continue;
+
+        char* tmp = (char*) realloc(buffer, 2 * capacity * sizeof(*buffer));
+        if (tmp == nullptr)
+        {
+            free(buffer);
+            return -1;
+        }
+
+        buffer    = tmp;
+        capacity *= 2;
+    }
+
+    buffer[size] = '\0';
+
+    text->text    = buffer;
+    text->textSz  = size;
+    text->mapping = buffer;
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------------------------
+
+void MappedTextDtor(MappedText* text)
+{
+    assert(text);
+
+    if (text->mappingSz > 0)
+        munmap(text->mapping, text->mappingSz);
+    else
+        free(text->mapping);
+
+    *text = {};
+}
+
+//------------------------------------------------------------------------------------------------
+
 int PrintLines(LineType* lines, const size_t linesCnt, FILE* const outStream)
 {
     assert(lines);
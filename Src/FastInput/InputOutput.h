@@ -24,6 +24,16 @@ struct TextType
     size_t linesCnt;            ///< number of elements in ptrArr
 };
 
+/// @brief Contains text of the whole input that is mapped to memory if possible
+struct MappedText
+{
+    const char* text;           ///< text, always followed by '\0' sentinel
+    size_t      textSz;         ///< number of chars in text without sentinel
+
+    void*       mapping;        ///< start of the mapping or heap buffer if text wasn't mapped
+    size_t      mappingSz;      ///< size of the mapping in bytes, 0 if text wasn't mapped
+};
+
 /// @brief Destructs text
 ///
 /// @details Free all dynamic arrays
@@ -61,6 +71,22 @@ char* ReadText(FILE* const inStream);
 
 //------------------------------------------------------------------------------------------------
 
+/// @brief maps the whole inStream to memory
+///
+/// @details Regular files are mapped with mmap, one more zero page is reserved after the file 
+/// so the text is always null terminated without copying. 
+/// Pipes, terminals and files that can't be mapped are read to the heap.
+/// @param [out]text struct to fill
+/// @param [in]inStream stream to read from
+/// @return 0 if no errors occurred otherwise not 0
+int MappedTextCtor(MappedText* text, FILE* const inStream);
+
+/// @brief Unmaps or frees text
+/// @param [out]text struct to destruct
+void MappedTextDtor(MappedText* text);
+
+//------------------------------------------------------------------------------------------------
+
 /// @brief prints text
 ///
 /// @param [in]lines array containing pointers to the lines.
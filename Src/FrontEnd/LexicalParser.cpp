@@ -1,16 +1,257 @@
 #include <assert.h>
-#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <thread>
+
 #include "LexicalParser.h"
-#include "Common/StringFuncs.h"
 #include "Common/Colors.h"
+#include "Common/StringFuncs.h"
+#include "Common/PerfectHash.h"
 #include "LexicalParserTokenType.h"
 
-static inline void SyntaxError(const size_t line, const size_t posErr, const char* str)
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+//---------------------------------------------------------------------------------------
+
+// Every char is classified once with the table instead of ctype calls and long switch.
+// Class of the first char defines which token (or skipped run) begins here.
+
+enum class LexCharClass : unsigned char
+{
+    ERROR,
+    END,
+
+    BLANK,
+    NEW_LINE,
+    COMMENT,
+
+    DIGIT,
+    FIVE,           ///< 57, 57?, 57!, 575757 keywords start with it
+    LETTER,         ///< letters and '_'
+    QUOTE,
+
+    SINGLE_OP,      ///< one char operation, id is in singleOps
+    EQ,
+    EXCLAMATION,
+    LESS_OR_GREATER,
+};
+
+struct LexCharTable
+{
+    LexCharClass classes  [256];
+    LangOpId     singleOps[256];
+};
+
+static constexpr LexCharTable LexCharTableCreate()
+{
+    LexCharTable table = {};
+
+    for (int c = 0; c < 256; ++c)
+    {
+        table.classes  [c] = LexCharClass::ERROR;
+        table.singleOps[c] = LangOpId::PROGRAM_END;
+    }
+
+    for (int c = 'a'; c <= 'z'; ++c) table.classes[c] = LexCharClass::LETTER;
+    for (int c = 'A'; c <= 'Z'; ++c) table.classes[c] = LexCharClass::LETTER;
+    for (int c = '0'; c <= '9'; ++c) table.classes[c] = LexCharClass::DIGIT;
+
+    table.classes['_']  = LexCharClass::LETTER;
+    table.classes['5']  = LexCharClass::FIVE;
+    table.classes['\0'] = LexCharClass::END;
+    table.classes[' ']  = LexCharClass::BLANK;
+    table.classes['\t'] = LexCharClass::BLANK;
+    table.classes['\n'] = LexCharClass::NEW_LINE;
+    table.classes['@']  = LexCharClass::COMMENT;
+    table.classes['"']  = LexCharClass::QUOTE;
+    table.classes['=']  = LexCharClass::EQ;
+    table.classes['!']  = LexCharClass::EXCLAMATION;
+    table.classes['<']  = LexCharClass::LESS_OR_GREATER;
+    table.classes['>']  = LexCharClass::LESS_OR_GREATER;
+
+    struct { char c; LangOpId langOpId; } singleOps[] =
+    {
+        { '+', LangOpId::SUB       },
+        { '-', LangOpId::ADD       },
+        { '*', LangOpId::DIV       },
+        { '/', LangOpId::MUL       },
+        { '^', LangOpId::POW       },
+        { '(', LangOpId::L_BRACKET },
+        { ')', LangOpId::R_BRACKET },
+        { '{', LangOpId::L_BRACE   },
+        { '.', LangOpId::PRINT     },
+    };
+
+    for (size_t i = 0; i < sizeof(singleOps) / sizeof(*singleOps); ++i)
+    {
+        table.classes  [(unsigned char)singleOps[i].c] = LexCharClass::SINGLE_OP;
+        table.singleOps[(unsigned char)singleOps[i].c] = singleOps[i].langOpId;
+    }
+
+    return table;
+}
+
+static constexpr LexCharTable LEX_CHAR_TABLE = LexCharTableCreate();
+
+static inline bool LexCharIsWordChar(const char c)
+{
+    LexCharClass charClass = LEX_CHAR_TABLE.classes[(unsigned char)c];
+
+    return charClass == LexCharClass::LETTER || charClass == LexCharClass::DIGIT ||
+           charClass == LexCharClass::FIVE;
+}
+
+static constexpr PerfectHashKey LEX_KEYWORDS[] =
+{
+    { "sqrt", (int)LangOpId::SQRT },
+    { "sin",  (int)LangOpId::SIN  },
+    { "cos",  (int)LangOpId::COS  },
+    { "tan",  (int)LangOpId::TAN  },
+    { "cot",  (int)LangOpId::COT  },
+    { "and",  (int)LangOpId::AND  },
+    { "or",   (int)LangOpId::OR   },
+};
+
+static constexpr auto LEX_KEYWORDS_TABLE = PerfectHashTableCreate<16>(LEX_KEYWORDS, false);
+
+//---------------------------------------------------------------------------------------
+
+// Runs of blanks and comment bodies are skipped by 16 (32 with AVX2) bytes at a time.
+// Loads are aligned, so they never cross the page boundary and never read
+// the memory after the '\0' sentinel that isn't mapped.
+
+#if defined(__AVX2__)
+    typedef __m256i LexVector;
+    static const size_t   LEX_VECTOR_SIZE      = 32;
+    static const uint32_t LEX_VECTOR_FULL_MASK = 0xFFFFFFFF;
+
+    #define LEX_VECTOR_LOAD(PTR)        _mm256_load_si256((const __m256i*)(PTR))
+    #define LEX_VECTOR_SET(C)           _mm256_set1_epi8(C)
+    #define LEX_VECTOR_EQ(A, B)         _mm256_cmpeq_epi8(A, B)
+    #define LEX_VECTOR_OR(A, B)         _mm256_or_si256(A, B)
+    #define LEX_VECTOR_MASK(A)          (uint32_t)_mm256_movemask_epi8(A)
+    #define LEX_SIMD
+#elif defined(__SSE2__)
+    typedef __m128i LexVector;
+    static const size_t   LEX_VECTOR_SIZE      = 16;
+    static const uint32_t LEX_VECTOR_FULL_MASK = 0xFFFF;
+
+    #define LEX_VECTOR_LOAD(PTR)        _mm_load_si128((const __m128i*)(PTR))
+    #define LEX_VECTOR_SET(C)           _mm_set1_epi8(C)
+    #define LEX_VECTOR_EQ(A, B)         _mm_cmpeq_epi8(A, B)
+    #define LEX_VECTOR_OR(A, B)         _mm_or_si128(A, B)
+    #define LEX_VECTOR_MASK(A)          (uint32_t)_mm_movemask_epi8(A)
+    #define LEX_SIMD
+#endif
+
+static size_t SkipBlanks(const char* str, const size_t posStart)
+{
+    assert(str);
+
+    size_t pos = posStart;
+
+#ifdef LEX_SIMD
+    // scalar until aligned
+    while ((uintptr_t)(str + pos) % LEX_VECTOR_SIZE != 0)
+    {
+        if (str[pos] != ' ' && str[pos] != '\t' && str[pos] != '\n')
+            return pos;
+
+        pos++;
+    }
+
+    const LexVector spaces   = LEX_VECTOR_SET(' ');
+    const LexVector tabs     = LEX_VECTOR_SET('\t');
+    const LexVector newLines = LEX_VECTOR_SET('\n');
+
+    while (true)
+    {
+        LexVector chars = LEX_VECTOR_LOAD(str + pos);
+
+        uint32_t blanksMask = LEX_VECTOR_MASK(LEX_VECTOR_OR(LEX_VECTOR_OR(LEX_VECTOR_EQ(chars, spaces),
+                                                                          LEX_VECTOR_EQ(chars, tabs)),
+                                                            LEX_VECTOR_EQ(chars, newLines)));
+
+        uint32_t notBlanksMask = ~blanksMask & LEX_VECTOR_FULL_MASK;
+
+        if (notBlanksMask != 0)
+            return pos + (size_t)__builtin_ctz(notBlanksMask);
+
+        pos += LEX_VECTOR_SIZE;
+    }
+#else
+    while (str[pos] == ' ' || str[pos] == '\t' || str[pos] == '\n')
+        pos++;
+
+    return pos;
+#endif
+}
+
+// Skips comment until '\n' (it is not skipped) or '\0'
+static size_t SkipComment(const char* str, const size_t posStart)
+{
+    assert(str);
+    assert(str[posStart] == '@');
+
+    size_t pos = posStart;
+
+#ifdef LEX_SIMD
+    while ((uintptr_t)(str + pos) % LEX_VECTOR_SIZE != 0)
+    {
+        if (str[pos] == '\n' || str[pos] == '\0')
+            return pos;
+
+        pos++;
+    }
+
+    const LexVector newLines = LEX_VECTOR_SET('\n');
+    const LexVector zeros    = LEX_VECTOR_SET('\0');
+
+    while (true)
+    {
+        LexVector chars = LEX_VECTOR_LOAD(str + pos);
+
+        uint32_t stopMask = LEX_VECTOR_MASK(LEX_VECTOR_OR(LEX_VECTOR_EQ(chars, newLines),
+                                                          LEX_VECTOR_EQ(chars, zeros)));
+
+        if (stopMask != 0)
+            return pos + (size_t)__builtin_ctz(stopMask);
+
+        pos += LEX_VECTOR_SIZE;
+    }
+#else
+    while (str[pos] != '\n' && str[pos] != '\0')
+        pos++;
+
+    return pos;
+#endif
+}
+
+#undef LEX_VECTOR_LOAD
+#undef LEX_VECTOR_SET
+#undef LEX_VECTOR_EQ
+#undef LEX_VECTOR_OR
+#undef LEX_VECTOR_MASK
+
+//---------------------------------------------------------------------------------------
+
+// Lines aren't counted while lexing, so line of the error is found by counting '\n' before it
+static inline void SyntaxError(const size_t posErr, const char* str)
 {
     assert(str);
 
+    size_t line = 0;
+    for (size_t pos = 0; pos < posErr; ++pos)
+        if (str[pos] == '\n')
+            line++;
+
     printf(RED_TEXT("Syntax error in line %zu. String - "), line);
 
     size_t pos = posErr;
@@ -24,27 +265,36 @@ static inline void SyntaxError(const size_t line, const size_t posErr, const cha
 }
 
 #define PUSH_LANG_OP_TOKEN(LANG_OP_ID)                                                      \
-    TokensArrPush(tokens, TokenCreate(TokenValueCreate(LANG_OP_ID),                         \
-                                                TokenValueType::LANG_OP, line, posStart))
+    TokensArrPush(tokens, TokenValueCreate(LANG_OP_ID), TokenValueType::LANG_OP, posStart)
 
-#define PUSH_NAME_TOKEN(WORD)                                                               \
-    TokensArrPush(tokens, TokenCreate(TokenValueCreate(WORD),                               \
-                                    TokenValueType::NAME, line, posStart));                 \
+#define PUSH_NAME_TOKEN(WORD, LENGTH)                                                       \
+    TokensArrPush(tokens, TokenValueCreate(WORD, LENGTH), TokenValueType::NAME, posStart)
 
 #define PUSH_NUM_TOKEN(VALUE)                                                               \
-    TokensArrPush(tokens, TokenCreate(TokenValueCreate(VALUE), TokenValueType::NUM, line, pos));
+    TokensArrPush(tokens, TokenValueCreate(VALUE), TokenValueType::NUM, pos)
 
-static size_t ParseNumber(const char* str, const size_t posStart, const size_t line, 
-                                                                TokensArr* tokens)
+static size_t ParseNumber(const char* str, const size_t posStart, TokensArr* tokens,
+                          LexicalParserErrors* outErr)
 {
     assert(str);
     assert(tokens);
+    assert(outErr);
 
     size_t pos = posStart;
 
-    int value = 0;
-    int shift = 0;
-    sscanf(str + pos, "%d%n", &value, &shift);
+    int    value = 0;
+    size_t shift = 0;
+    ScanIntErrors scanErr = ScanInt(str + pos, &value, &shift);
+
+    if (scanErr != ScanIntErrors::NO_ERR)
+    {
+        printf(RED_TEXT("Integer literal is too big. "));
+        SyntaxError(posStart, str);
+        *outErr = LexicalParserErrors::SYNTAX_ERR;
+
+        return pos + shift;
+    }
+
     pos += shift;
 
     PUSH_NUM_TOKEN(value);
@@ -52,52 +302,28 @@ static size_t ParseNumber(const char* str, const size_t posStart, const size_t l
     return pos;
 }
 
-static size_t ParseWord(const char* str, const size_t posStart, const size_t line, 
-                                                              TokensArr* tokens)
+static size_t ParseWord(const char* str, const size_t posStart, TokensArr* tokens)
 {
     assert(str);
     assert(tokens);
 
     size_t pos = posStart;
 
-    static const size_t maxWordSize   =  64;
-    static char word[maxWordSize + 1] =  "";
-    
-    size_t wordPos = 0;
-
-    while (isalpha(str[pos]) || isdigit(str[pos]) || str[pos] == '_')
-    {
-        assert(wordPos < maxWordSize);
-
-        word[wordPos] = str[pos];
+    while (LexCharIsWordChar(str[pos]))
         ++pos;
-        ++wordPos;
-    }
 
-    word[wordPos] = '\0';
-
-    if (strcmp(word, "sqrt") == 0)
-        PUSH_LANG_OP_TOKEN(LangOpId::SQRT);
-    else if (strcmp(word, "sin") == 0)
-        PUSH_LANG_OP_TOKEN(LangOpId::SIN);
-    else if (strcmp(word, "cos") == 0)
-        PUSH_LANG_OP_TOKEN(LangOpId::COS);
-    else if (strcmp(word, "tan") == 0)
-            PUSH_LANG_OP_TOKEN(LangOpId::TAN);
-    else if (strcmp(word, "cot") == 0)
-            PUSH_LANG_OP_TOKEN(LangOpId::COT); 
-    else if (strcmp(word, "and") == 0)
-            PUSH_LANG_OP_TOKEN(LangOpId::AND);
-    else if (strcmp(word, "or") == 0)
-            PUSH_LANG_OP_TOKEN(LangOpId::OR);
+    // word isn't copied anywhere: keyword is found right in the text, name is interned from it
+    int langOpId = 0;
+
+    if (PerfectHashFind(LEX_KEYWORDS_TABLE, str + posStart, pos - posStart, &langOpId))
+        PUSH_LANG_OP_TOKEN((LangOpId)langOpId);
     else
-        PUSH_NAME_TOKEN(word);
+        PUSH_NAME_TOKEN(str + posStart, pos - posStart);
 
     return pos;
 }
 
-static size_t ParseEq(const char* str, const size_t posStart, const size_t line, 
-                                                                TokensArr* tokens)
+static size_t ParseEq(const char* str, const size_t posStart, TokensArr* tokens)
 {
     assert(str);
     assert(tokens);
@@ -117,8 +343,8 @@ static size_t ParseEq(const char* str, const size_t posStart, const size_t line,
     return pos;
 }
 
-static size_t ParseExclamation(const char* str, const size_t posStart, const size_t line, 
-                                TokensArr* tokens, LexicalParserErrors* outErr)
+static size_t ParseExclamation(const char* str, const size_t posStart, TokensArr* tokens,
+                               LexicalParserErrors* outErr)
 {
     assert(str);
     assert(tokens);
@@ -134,7 +360,7 @@ static size_t ParseExclamation(const char* str, const size_t posStart, const siz
     }
     else
     {
-        SyntaxError(line, pos, str);
+        SyntaxError(pos, str);
         *outErr = LexicalParserErrors::SYNTAX_ERR;
 
         //TODO: syn_assert / or add not as !
@@ -143,8 +369,7 @@ static size_t ParseExclamation(const char* str, const size_t posStart, const siz
     return pos;
 }
 
-static size_t ParseLessOrGreater(const char* str, const size_t posStart, const size_t line, 
-                                                                        TokensArr* tokens)
+static size_t ParseLessOrGreater(const char* str, const size_t posStart, TokensArr* tokens)
 {
     assert(str);
     assert(tokens);
@@ -172,22 +397,22 @@ static size_t ParseLessOrGreater(const char* str, const size_t posStart, const s
     return pos;
 }
 
-static size_t Parse5(const char* str, const size_t posStart, const size_t line, 
-                                                                    TokensArr* tokens)
+static size_t Parse5(const char* str, const size_t posStart, TokensArr* tokens,
+                     LexicalParserErrors* outErr)
 {
     assert(str);
     assert(tokens);
 
     size_t pos = posStart;
 
-    int value = 0;
-    int shift = 0;
+    int    value = 0;
+    size_t shift = 0;
 
-    sscanf(str + pos, "%d%n", &value, &shift);
+    ScanIntErrors scanErr = ScanInt(str + pos, &value, &shift);
     pos += shift;
 
-    if (value != 57 && value != 575757)
-        return ParseNumber(str, posStart, line, tokens);
+    if (scanErr != ScanIntErrors::NO_ERR || (value != 57 && value != 575757))
+        return ParseNumber(str, posStart, tokens, outErr);
 
     if (value == 575757)
     {
@@ -220,212 +445,177 @@ static size_t Parse5(const char* str, const size_t posStart, const size_t line,
     return pos;
 }
 
-static size_t ParseQuotes(const char* str, const size_t posStart, const size_t line,
-                                                                        TokensArr* tokens)
+// String literal is interned right from the text with its quotes,
+// no static buffer is used, so chunks can be lexed in parallel
+static size_t ParseQuotes(const char* str, const size_t posStart, TokensArr* tokens,
+                          LexicalParserErrors* outErr)
 {
     assert(str);
     assert(tokens);
+    assert(outErr);
 
-    size_t pos = posStart;
-
-    static const size_t maxWordLength  = 1024;
-    static char    word[maxWordLength] =   "";
+    size_t pos = posStart + 1;
 
-    size_t wordPos = 0;
+    while (str[pos] != '"' && str[pos] != '\0')
+        pos++;
 
-    do
+    if (str[pos] == '\0')
     {
-        word[wordPos] = str[pos];
-        wordPos++;
-        pos++;
+        SyntaxError(posStart, str);
+        *outErr = LexicalParserErrors::SYNTAX_ERR;
 
-        assert(wordPos < maxWordLength);
-    } while (str[pos] != '"');
+        return pos;
+    }
 
-    word[wordPos] = str[pos];
     pos++;
-    wordPos++;
-    word[wordPos] = '\0';
 
-    PUSH_NAME_TOKEN(word);
+    PUSH_NAME_TOKEN(str + posStart, pos - posStart);
 
-    return pos;                                                
+    return pos;
 }
 
 #undef  PUSH_LANG_OP_TOKEN
 #define PUSH_LANG_OP_TOKEN(LANG_OP_ID)                                                      \
-    TokensArrPush(tokens, TokenCreate(TokenValueCreate(LANG_OP_ID),                         \
-                                                TokenValueType::LANG_OP, line, pos))        
+    TokensArrPush(tokens, TokenValueCreate(LANG_OP_ID), TokenValueType::LANG_OP, pos)
 
-LexicalParserErrors ParseOnTokens(const char* code, TokensArr* tokens)
+// Lexes code from pos until one token is pushed or posEnd is reached, blanks and comments
+// before the token are skipped. PROGRAM_END is pushed on '\0' every time it is reached.
+static size_t ParseToken(const char* code, const size_t posStart, const size_t posEnd,
+                         TokensArr* tokens, LexicalParserErrors* outErr)
 {
-    size_t pos  = 0;
-    size_t line = 0;
+    assert(code);
+    assert(tokens);
+    assert(outErr);
 
-    LexicalParserErrors error = LexicalParserErrors::NO_ERR;
+    size_t pos = posStart;
+
+    const size_t        tokensCount = tokens->size;
+    LexicalParserErrors error       = LexicalParserErrors::NO_ERR;
 
-    while (code[pos] != '\0' && error == LexicalParserErrors::NO_ERR)
+    while (tokens->size == tokensCount && pos < posEnd && error == LexicalParserErrors::NO_ERR)
     {
-        switch (code[pos])
+        const unsigned char curChar = (unsigned char)code[pos];
+
+        switch (LEX_CHAR_TABLE.classes[curChar])
         {
-            case '+':
+            case LexCharClass::SINGLE_OP:
             {
-                PUSH_LANG_OP_TOKEN(LangOpId::SUB);
+                PUSH_LANG_OP_TOKEN(LEX_CHAR_TABLE.singleOps[curChar]);
                 pos++;
-                break; 
-            }
-            case '*':
-            {
-                PUSH_LANG_OP_TOKEN(LangOpId::DIV);
-                pos++;
-                break; 
-            }
-            case '/':
-            {
-                PUSH_LANG_OP_TOKEN(LangOpId::MUL);
-                pos++;
-                break; 
-            }
-            case '^':
-            {
-                PUSH_LANG_OP_TOKEN(LangOpId::POW);
-                pos++;
-                break; 
-            }
-
-            case '=':
-            {
-                pos = ParseEq(code, pos, line, tokens);
                 break;
             }
 
-            case '<':
-            case '>':
+            case LexCharClass::EQ:
             {
-                pos = ParseLessOrGreater(code, pos, line, tokens);
+                pos = ParseEq(code, pos, tokens);
                 break;
             }
 
-            case '!':
+            case LexCharClass::LESS_OR_GREATER:
             {
-                pos = ParseExclamation(code, pos, line, tokens, &error);
+                pos = ParseLessOrGreater(code, pos, tokens);
                 break;
             }
 
-            case '-':
+            case LexCharClass::EXCLAMATION:
             {
-                PUSH_LANG_OP_TOKEN(LangOpId::ADD);
-                pos++;
+                pos = ParseExclamation(code, pos, tokens, &error);
                 break;
             }
 
-            case '(':
+            case LexCharClass::QUOTE:
             {
-                PUSH_LANG_OP_TOKEN(LangOpId::L_BRACKET);
-                ++pos;
+                pos = ParseQuotes(code, pos, tokens, &error);
                 break;
             }
 
-            case ')':
+            case LexCharClass::BLANK:
+            case LexCharClass::NEW_LINE:
             {
-                PUSH_LANG_OP_TOKEN(LangOpId::R_BRACKET);
-                ++pos;
+                pos = SkipBlanks(code, pos);
                 break;
             }
 
-            case '{':
+            case LexCharClass::COMMENT:
             {
-                PUSH_LANG_OP_TOKEN(LangOpId::L_BRACE);
-                pos++;
-                break; 
-            }
-
-            case '.':
-            {
-                PUSH_LANG_OP_TOKEN(LangOpId::PRINT);
-                pos++;
-                break;
-            }
-
-            case '"':
-            {
-                pos = ParseQuotes(code, pos, line, tokens);
+                pos = SkipComment(code, pos);
                 break;
             }
 
-            case '\t':
-            case ' ':
-            {
-                const char* codePtr = SkipSymbolsWhileStatement(code + pos, isblank);
-                pos = codePtr - code;
-                break;
-            }
-            case '\n':
+            case LexCharClass::DIGIT:
             {
-                pos++;
-                line++;
+                pos = ParseNumber(code, pos, tokens, &error);
                 break;
             }
 
-            case '@':
+            case LexCharClass::FIVE:
             {
-                const char* codePtr = SkipSymbolsUntilStopChar(code + pos, '\n');
-                pos = codePtr - code;
+                pos = Parse5(code, pos, tokens, &error);
                 break;
             }
 
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
+            case LexCharClass::LETTER:
             {
-                pos = ParseNumber(code, pos, line, tokens);
+                pos = ParseWord(code, pos, tokens);
                 break;
             }
 
-            case '5':
+            case LexCharClass::END:
             {
-                pos = Parse5(code, pos, line, tokens);
+                PUSH_LANG_OP_TOKEN(LangOpId::PROGRAM_END);
                 break;
             }
 
+            case LexCharClass::ERROR:
             default:
             {
-                if (isalpha(code[pos]) || code[pos] == '_')
-                {
-                    pos = ParseWord(code, pos, line, tokens);
-                    break;
-                }
-
-                SyntaxError(line, pos, code);
+                SyntaxError(pos, code);
                 error = LexicalParserErrors::SYNTAX_ERR;
                 break;
             }
         }
     }
 
+    *outErr = error;
+
+    return pos;
+}
+
+LexicalParserErrors ParseOnTokens(const char* code, TokensArr* tokens)
+{
+    assert(code);
+    assert(tokens);
+
+    size_t pos  = 0;
+
+    LexicalParserErrors error = LexicalParserErrors::NO_ERR;
+
+    do
+    {
+        pos = ParseToken(code, pos, SIZE_MAX, tokens, &error);
+    } while (error == LexicalParserErrors::NO_ERR &&
+             TokensArrGetKind(tokens, tokens->size - 1) != TokenKindCreate(LangOpId::PROGRAM_END));
+
     assert(error == LexicalParserErrors::NO_ERR);
 
     /*
     for (size_t i = 0; i < tokens->size; ++i)
     {
+        TokenValue value = TokensArrGetValue(tokens, i);
+
         printf("--------------------------------\n");
-        printf("line - %zu, pos - %zu, token - %zu\n", tokens->data[i].line, tokens->data[i].pos, i);
-        switch (tokens->data[i].valueType)
+        printf("line - %zu, pos - %zu, token - %zu\n", TokensArrGetLine(tokens, i),
+                                                       TokensArrGetPos (tokens, i), i);
+        switch (TokensArrGetValueType(tokens, i))
         {
             case TokenValueType::LANG_OP:
-                printf("Operation - %d\n", (int)tokens->data[i].value.langOpId);
+                printf("Operation - %d\n", (int)value.langOpId);
                 break;
             case TokenValueType::NAME:
-                printf("Variable - %s\n", tokens->data[i].value.name);
+                printf("Variable - %s\n", SymbolGetName(value.symbol));
                 break;
             case TokenValueType::NUM:
-                printf("Value - %d\n", tokens->data[i].value.num);
+                printf("Value - %d\n", value.num);
                 break;
             default:
                 abort();
@@ -433,30 +623,240 @@ LexicalParserErrors ParseOnTokens(const char* code, TokensArr* tokens)
         }
     }
     */
-    if (error != LexicalParserErrors::NO_ERR)
-        return error;
 
-    PUSH_LANG_OP_TOKEN(LangOpId::PROGRAM_END);
+    return error;
+}
+
+//---------------------------------------------------------------------------------------
+
+// Code is cut only right before "575757" that begins a line and isn't inside a string
+// literal or a comment. Such lines are function definitions in the usual code. Cut is
+// safe for lexing anyway: previous token always ends at '\n', so chunks are lexed
+// independently. Positions of the tokens are in the whole code, so lines don't need fixing.
+
+static const size_t LEX_MAX_THREADS_COUNT = 64;
+
+struct LexChunk
+{
+    size_t begin;
+    size_t end;     ///< SIZE_MAX for the last chunk, it ends with PROGRAM_END
+
+    TokensArr           tokens;
+    LexicalParserErrors error;
+};
+
+static void ParseChunk(const char* code, LexChunk* chunk);
+
+LexicalParserErrors ParseOnTokensParallel(const char* code, TokensArr* tokens,
+                                          const size_t threadsCount)
+{
+    assert(code);
+    assert(tokens);
+    assert(threadsCount > 0);
+
+    const size_t chunksCountMax = threadsCount < LEX_MAX_THREADS_COUNT ? threadsCount :
+                                                                         LEX_MAX_THREADS_COUNT;
+
+    size_t splitPoints[LEX_MAX_THREADS_COUNT + 1] = {};
+    size_t chunksCount = LexFindSplitPoints(code, strlen(code), splitPoints, chunksCountMax);
+
+    LexChunk* chunks = (LexChunk*)calloc(chunksCount, sizeof(*chunks));
+    if (chunks == nullptr)
+        return LexicalParserErrors::MEM_ERR;
+
+    for (size_t i = 0; i < chunksCount; ++i)
+    {
+        chunks[i].begin = splitPoints[i];
+        chunks[i].end   = i + 1 < chunksCount ? splitPoints[i + 1] : SIZE_MAX;
+
+        if (TokensArrCtor(&chunks[i].tokens, code) != TokensArrErrors::NO_ERR)
+            chunks[i].error = LexicalParserErrors::MEM_ERR;
+    }
+
+    // the first chunk is lexed by this thread
+    std::thread workers[LEX_MAX_THREADS_COUNT];
+
+    for (size_t i = 1; i < chunksCount; ++i)
+        workers[i] = std::thread(ParseChunk, code, &chunks[i]);
+
+    ParseChunk(code, &chunks[0]);
+
+    for (size_t i = 1; i < chunksCount; ++i)
+        workers[i].join();
+
+    LexicalParserErrors error = LexicalParserErrors::NO_ERR;
+
+    for (size_t i = 0; i < chunksCount; ++i)
+    {
+        if (error == LexicalParserErrors::NO_ERR)
+            error = chunks[i].error;
+
+        if (error == LexicalParserErrors::NO_ERR &&
+            TokensArrAppend(tokens, &chunks[i].tokens) != TokensArrErrors::NO_ERR)
+            error = LexicalParserErrors::MEM_ERR;
+
+        TokensArrDtor(&chunks[i].tokens);
+    }
+
+    free(chunks);
 
     return error;
 }
 
-Token TokenCreate(TokenValue value, TokenValueType valueType,   const size_t line, 
-                                                                const size_t pos)
+static void ParseChunk(const char* code, LexChunk* chunk)
 {
-    Token token = {};
+    assert(code);
+    assert(chunk);
 
-    token.value     = value;
-    token.valueType = valueType;
-    token.line      =      line;
-    token.pos       =       pos;
+    size_t pos = chunk->begin;
 
-    return token;
+    while (pos < chunk->end && chunk->error == LexicalParserErrors::NO_ERR)
+    {
+        pos = ParseToken(code, pos, chunk->end, &chunk->tokens, &chunk->error);
+
+        if (!TokensArrIsEmpty(&chunk->tokens) &&
+            TokensArrGetKind(&chunk->tokens, chunk->tokens.size - 1) ==
+                                                        TokenKindCreate(LangOpId::PROGRAM_END))
+            break;
+    }
 }
 
-Token TokenCopy(const Token* token)
+size_t LexFindSplitPoints(const char* code, const size_t codeSize, size_t* splitPoints,
+                          const size_t maxChunksCount)
 {
-    return TokenCreate(token->value, token->valueType, token->line, token->pos);
+    assert(code);
+    assert(splitPoints);
+    assert(maxChunksCount > 0);
+
+    static const char   TYPE_KEYWORD[]     = "575757";
+    static const size_t TYPE_KEYWORD_LEN   = sizeof(TYPE_KEYWORD) - 1;
+
+    size_t chunksCount = 1;
+    splitPoints[0]     = 0;
+
+    const size_t chunkSize = codeSize / maxChunksCount + 1;
+
+    bool inString  = false;
+    bool inComment = false;
+
+    for (size_t pos = 0; pos < codeSize && chunksCount < maxChunksCount; ++pos)
+    {
+        const char c = code[pos];
+
+        if (inString)
+        {
+            inString  = c != '"';
+            continue;
+        }
+
+        if (inComment)
+        {
+            inComment = c != '\n';
+            continue;
+        }
+
+        if (c == '"')
+            inString = true;
+        else if (c == '@')
+            inComment = true;
+        else if (c == '\n' && pos + 1 >= chunksCount * chunkSize &&
+                 strncmp(code + pos + 1, TYPE_KEYWORD, TYPE_KEYWORD_LEN) == 0)
+            splitPoints[chunksCount++] = pos + 1;
+    }
+
+    return chunksCount;
+}
+
+//---------------------------------------------------------------------------------------
+
+LexicalParserErrors TokenStreamCtor(TokenStream* stream, const char* code,
+                                    const size_t lexThreadsCount)
+{
+    assert(stream);
+    assert(code);
+
+    *stream = {};
+
+    stream->code    = code;
+    stream->codeEnd = SIZE_MAX;
+
+    if (TokensArrCtor(&stream->window, code, TOKEN_STREAM_WINDOW_CAPACITY) != TokensArrErrors::NO_ERR)
+    {
+        stream->error = LexicalParserErrors::MEM_ERR;
+        return stream->error;
+    }
+
+    if (lexThreadsCount == 0)
+        return stream->error;
+
+    // everything is lexed now, the stream only gives PROGRAM_END after the last token
+    stream->error   = ParseOnTokensParallel(code, &stream->window, lexThreadsCount);
+    stream->codePos = stream->error == LexicalParserErrors::NO_ERR ?
+                      TokensArrGetPos(&stream->window, stream->window.size - 1) : 0;
+
+    return stream->error;
+}
+
+LexicalParserErrors TokenStreamCtor(TokenStream* stream, const char* code,
+                                    const size_t codeBegin, const size_t codeEnd)
+{
+    assert(stream);
+    assert(code);
+    assert(codeBegin <= codeEnd);
+
+    *stream = {};
+
+    stream->code    = code;
+    stream->codePos = codeBegin;
+    stream->codeEnd = codeEnd;
+
+    if (TokensArrCtor(&stream->window, code, TOKEN_STREAM_WINDOW_CAPACITY) != TokensArrErrors::NO_ERR)
+        stream->error = LexicalParserErrors::MEM_ERR;
+
+    return stream->error;
+}
+
+void TokenStreamDtor(TokenStream* stream)
+{
+    assert(stream);
+
+    TokensArrDtor(&stream->window);
+
+    *stream = {};
+}
+
+size_t TokenStreamFetch(TokenStream* stream, const size_t tokenPos)
+{
+    assert(stream);
+    assert(tokenPos >= stream->windowStart);
+
+    while (tokenPos >= stream->windowStart + stream->window.size)
+    {
+        // tokens before tokenPos - TOKEN_STREAM_LOOKAHEAD can't be asked anymore
+        if (stream->window.size >= TOKEN_STREAM_WINDOW_CAPACITY &&
+            tokenPos - TOKEN_STREAM_LOOKAHEAD > stream->windowStart)
+        {
+            size_t dropCount = tokenPos - TOKEN_STREAM_LOOKAHEAD - stream->windowStart;
+
+            TokensArrDropFront(&stream->window, dropCount);
+            stream->windowStart += dropCount;
+        }
+
+        const size_t tokensCount = stream->window.size;
+
+        if (stream->error == LexicalParserErrors::NO_ERR)
+            stream->codePos = ParseToken(stream->code, stream->codePos, stream->codeEnd,
+                                         &stream->window, &stream->error);
+
+        // after the error or at the end of the code range program is ended, so parser stops
+        if (stream->error != LexicalParserErrors::NO_ERR || stream->window.size == tokensCount)
+        {
+            TokensArrPush(&stream->window, TokenValueCreate(LangOpId::PROGRAM_END),
+                                           TokenValueType::LANG_OP, stream->codePos);
+        }
+    }
+
+    return tokenPos - stream->windowStart;
 }
 
 TokenValue TokenValueCreate(int value)
@@ -473,7 +873,17 @@ TokenValue TokenValueCreate(const char* word)
 {
     TokenValue val =
     {
-        .name = strdup(word),
+        .symbol = SymbolIntern(word),
+    };
+
+    return val;
+}
+
+TokenValue TokenValueCreate(const char* word, const size_t length)
+{
+    TokenValue val =
+    {
+        .symbol = SymbolIntern(word, length),
     };
 
     return val;
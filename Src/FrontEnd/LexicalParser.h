@@ -9,16 +9,69 @@ enum class LexicalParserErrors
     NO_ERR,
 
     SYNTAX_ERR,
+    MEM_ERR,
 };
 
-Token TokenCopy(const Token* token);
-Token TokenCreate(TokenValue value, TokenValueType valueType,   const size_t line, 
-                                                                const size_t pos);
+/// @brief Max count of tokens stream keeps in memory
+static const size_t TOKEN_STREAM_WINDOW_CAPACITY = 64;
+/// @brief How far the parser can look ahead of the current token
+static const size_t TOKEN_STREAM_LOOKAHEAD       = 1;
+
+/// @brief Tokens that are lexed on demand.
+/// @details Only the window of the last fetched tokens is stored, so memory doesn't
+/// depend on the size of the program.
+struct TokenStream
+{
+    const char* code;
+    size_t      codePos;        ///< position the lexer stopped at
+    size_t      codeEnd;        ///< stream gives PROGRAM_END at this position
+
+    TokensArr   window;         ///< last lexed tokens (all tokens if they are lexed in parallel)
+    size_t      windowStart;    ///< index of the first window token in the whole stream
+
+    LexicalParserErrors error;  ///< first lexing error, stream gives PROGRAM_END after it
+};
 
 TokenValue TokenValueCreate (const char* name);
+TokenValue TokenValueCreate (const char* name, const size_t length);
 TokenValue TokenValueCreate (const int value);
 TokenValue TokenValueCreate (const LangOpId tokenId);
 
+/// @brief Lexes the whole code into tokens
 LexicalParserErrors ParseOnTokens(const char* code, TokensArr* tokens);
 
+/// @brief Lexes the whole code into tokens on several threads
+/// @details Code is cut into chunks at the lines that begin with 575757 outside
+/// string literals and comments, chunks are lexed in parallel and appended to tokens in order.
+/// @param [in]code code to lex
+/// @param [out]tokens constructed tokensArr to append tokens to
+/// @param [in]threadsCount max count of the threads (and chunks)
+LexicalParserErrors ParseOnTokensParallel(const char* code, TokensArr* tokens,
+                                          const size_t threadsCount);
+
+/// @brief Finds where code can be cut into chunks that are lexed independently
+/// @details Code is cut only right before "575757" that begins a line and isn't inside
+/// a string literal or a comment, such lines are function definitions in the usual code.
+/// @param [out]splitPoints beginnings of the chunks, the first one is always 0
+/// @param [in]maxChunksCount max count of the chunks, they are about codeSize / maxChunksCount long
+/// @return count of the chunks
+size_t LexFindSplitPoints(const char* code, const size_t codeSize, size_t* splitPoints,
+                          const size_t maxChunksCount);
+
+/// @brief Stream constructor
+/// @param [in]lexThreadsCount 0 - tokens are lexed on demand,
+/// otherwise the whole code is lexed at once by ParseOnTokensParallel on so many threads
+LexicalParserErrors TokenStreamCtor(TokenStream* stream, const char* code,
+                                    const size_t lexThreadsCount = 0);
+/// @brief Constructor of the stream that lexes only code from codeBegin to codeEnd
+/// on demand and gives PROGRAM_END at codeEnd
+LexicalParserErrors TokenStreamCtor(TokenStream* stream, const char* code,
+                                    const size_t codeBegin, const size_t codeEnd);
+void                TokenStreamDtor(TokenStream* stream);
+
+/// @brief Lexes tokens until tokenPos if they aren't lexed yet
+/// @details tokenPos can't be less than the biggest asked position - TOKEN_STREAM_LOOKAHEAD
+/// @return position of the token in stream->window
+size_t TokenStreamFetch(TokenStream* stream, const size_t tokenPos);
+
 #endif 
\ No newline at end of file
@@ -2,6 +2,9 @@
 #define LEXICAL_PARSER_TOKEN_TYPE
 
 #include <stddef.h>
+#include <stdint.h>
+
+#include "Common/SymbolPool.h"
 
 enum class LangOpId
 {
@@ -47,8 +50,8 @@ enum class LangOpId
 
 union TokenValue
 {
-    LangOpId      langOpId;
-    char*           name;
+    LangOpId        langOpId;
+    SymbolId        symbol;     ///< interned name
     int             num;
 };
 
@@ -59,13 +62,47 @@ enum class TokenValueType
     NUM,
 };
 
-struct Token
+/// @brief Kind of the packed token. Kinds of LANG_OP tokens are their LangOpId,
+/// so checking for the operation is one byte comparison
+enum class TokenKind : uint8_t
 {
-    TokenValue     value;
-    TokenValueType valueType;
+    NAME = 128,     ///< payload is SymbolId
+    NUM,            ///< payload is the num itself (TOKEN_PAYLOAD_BITS bits, two's complement)
+    BIG_NUM,        ///< num doesn't fit into payload, payload is index in TokensArr bigNums
+};
 
-    size_t line;
-    size_t pos;
+static_assert((int)LangOpId::PRINT < (int)TokenKind::NAME, "LangOpId doesn't fit in TokenKind");
+
+static const unsigned TOKEN_PAYLOAD_BITS = 24;
+static const uint32_t TOKEN_PAYLOAD_MAX  = (1u << TOKEN_PAYLOAD_BITS) - 1;
+
+/// @brief Packed token, line is not stored and is found by pos
+struct Token
+{
+    uint32_t kind    : 8;                   ///< TokenKind
+    uint32_t payload : TOKEN_PAYLOAD_BITS;  ///< SymbolId, num or bigNums index
+    uint32_t pos;                           ///< offset of the token in the code
 };
 
+static_assert(sizeof(Token) == 8, "Token has to be packed into 8 bytes");
+
+static constexpr TokenKind TokenKindCreate(const LangOpId langOpId)
+{
+    return (TokenKind)langOpId;
+}
+
+static inline TokenValueType TokenKindGetValueType(const TokenKind kind)
+{
+    switch (kind)
+    {
+        case TokenKind::NAME:
+            return TokenValueType::NAME;
+        case TokenKind::NUM:
+        case TokenKind::BIG_NUM:
+            return TokenValueType::NUM;
+        default:
+            return TokenValueType::LANG_OP;
+    }
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ScopeTable.h"
+
+//---------------------------------------------------------------------------------------
+
+static const size_t SCOPE_TABLE_STANDARD_CAPACITY        = 64;
+static const size_t SCOPE_TABLE_STANDARD_INDEX_CAPACITY  = 128;
+static const size_t SCOPE_TABLE_STANDARD_SCOPES_CAPACITY = 16;
+
+static ScopeTableErrors ScopeTableIndexRealloc(ScopeTable* table, const size_t indexCapacity);
+
+static ScopeTableSlot*  ScopeTableGetSlot(const ScopeTable* table, const SymbolId symbol);
+
+static inline size_t ScopeTableSymbolHash(const SymbolId symbol)
+{
+    return (size_t)symbol * 0x9E3779B97F4A7C15ull >> 32;
+}
+
+//---------------------------------------------------------------------------------------
+
+ScopeTableErrors ScopeTableCtor(ScopeTable* table)
+{
+    assert(table);
+
+    *table = {};
+
+    table->entries     = (ScopeTableEntry*)calloc(SCOPE_TABLE_STANDARD_CAPACITY,
+                                                  sizeof(*table->entries));
+    table->scopeStarts = (size_t*)calloc(SCOPE_TABLE_STANDARD_SCOPES_CAPACITY,
+                                         sizeof(*table->scopeStarts));
+
+    if (table->entries == nullptr || table->scopeStarts == nullptr)
+    {
+        ScopeTableDtor(table);
+        return ScopeTableErrors::MEM_ERR;
+    }
+
+    table->capacity       = SCOPE_TABLE_STANDARD_CAPACITY;
+    table->scopesCapacity = SCOPE_TABLE_STANDARD_SCOPES_CAPACITY;
+
+    // global scope
+    table->scopeStarts[0] = 0;
+    table->scopesCount    = 1;
+
+    if (ScopeTableIndexRealloc(table, SCOPE_TABLE_STANDARD_INDEX_CAPACITY) != ScopeTableErrors::NO_ERR)
+    {
+        ScopeTableDtor(table);
+        return ScopeTableErrors::MEM_ERR;
+    }
+
+    return ScopeTableErrors::NO_ERR;
+}
+
+void ScopeTableDtor(ScopeTable* table)
+{
+    assert(table);
+
+    free(table->entries);
+    free(table->index);
+    free(table->scopeStarts);
+
+    *table = {};
+}
+
+//---------------------------------------------------------------------------------------
+
+ScopeTableErrors ScopeTablePushScope(ScopeTable* table)
+{
+    assert(table);
+    assert(table->scopeStarts);
+
+    if (table->scopesCount == table->scopesCapacity)
+    {
+        size_t* newScopeStarts = (size_t*)realloc(table->scopeStarts,
+                                                  2 * table->scopesCapacity * sizeof(*newScopeStarts));
+        if (newScopeStarts == nullptr)
+            return ScopeTableErrors::MEM_ERR;
+
+        table->scopeStarts     = newScopeStarts;
+        table->scopesCapacity *= 2;
+    }
+
+    table->scopeStarts[table->scopesCount++] = table->size;
+
+    return ScopeTableErrors::NO_ERR;
+}
+
+ScopeTableErrors ScopeTablePopScope(ScopeTable* table)
+{
+    assert(table);
+
+    if (table->scopesCount <= 1)
+        return ScopeTableErrors::NO_SCOPE_ERR;
+
+    const size_t scopeStart = table->scopeStarts[--table->scopesCount];
+
+    // declarations are undone in reverse order, so the hidden ones are restored right
+    while (table->size > scopeStart)
+    {
+        const ScopeTableEntry* entry = &table->entries[--table->size];
+
+        ScopeTableSlot* slot = ScopeTableGetSlot(table, entry->symbol);
+        assert(slot->symbol == entry->symbol);
+        assert(slot->entry  == table->size);
+
+        slot->entry = entry->hidden;
+    }
+
+    return ScopeTableErrors::NO_ERR;
+}
+
+//---------------------------------------------------------------------------------------
+
+ScopeTableErrors ScopeTableDeclare(ScopeTable* table, const SymbolId symbol, const int nameId)
+{
+    assert(table);
+    assert(symbol != SYMBOL_ID_POISON);
+
+    if (table->size == table->capacity)
+    {
+        ScopeTableEntry* newEntries = (ScopeTableEntry*)realloc(table->entries,
+                                                    2 * table->capacity * sizeof(*newEntries));
+        if (newEntries == nullptr)
+            return ScopeTableErrors::MEM_ERR;
+
+        table->entries   = newEntries;
+        table->capacity *= 2;
+    }
+
+    if (2 * (table->indexSize + 1) > table->indexCapacity &&
+        ScopeTableIndexRealloc(table, 2 * table->indexCapacity) != ScopeTableErrors::NO_ERR)
+        return ScopeTableErrors::MEM_ERR;
+
+    ScopeTableSlot* slot = ScopeTableGetSlot(table, symbol);
+
+    if (slot->symbol == SYMBOL_ID_POISON)
+    {
+        slot->symbol = symbol;
+        slot->entry  = SCOPE_TABLE_NO_ENTRY;
+        table->indexSize++;
+    }
+
+    table->entries[table->size] = { symbol, nameId, slot->entry };
+    slot->entry = table->size++;
+
+    return ScopeTableErrors::NO_ERR;
+}
+
+bool ScopeTableFind(const ScopeTable* table, const SymbolId symbol, int* outNameId)
+{
+    assert(table);
+    assert(outNameId);
+
+    const ScopeTableSlot* slot = ScopeTableGetSlot(table, symbol);
+
+    if (slot->symbol == SYMBOL_ID_POISON || slot->entry == SCOPE_TABLE_NO_ENTRY)
+        return false;
+
+    *outNameId = table->entries[slot->entry].nameId;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+
+// Returns slot of the symbol or empty slot where it has to be put
+static ScopeTableSlot* ScopeTableGetSlot(const ScopeTable* table, const SymbolId symbol)
+{
+    assert(table);
+    assert(table->index);
+
+    const size_t mask = table->indexCapacity - 1;
+
+    size_t slot = ScopeTableSymbolHash(symbol) & mask;
+    while (table->index[slot].symbol != SYMBOL_ID_POISON && table->index[slot].symbol != symbol)
+        slot = (slot + 1) & mask;
+
+    return &table->index[slot];
+}
+
+static ScopeTableErrors ScopeTableIndexRealloc(ScopeTable* table, const size_t indexCapacity)
+{
+    assert(table);
+    assert((indexCapacity & (indexCapacity - 1)) == 0);
+
+    ScopeTableSlot* newIndex = (ScopeTableSlot*)calloc(indexCapacity, sizeof(*newIndex));
+    if (newIndex == nullptr)
+        return ScopeTableErrors::MEM_ERR;
+
+    for (size_t i = 0; i < indexCapacity; ++i)
+        newIndex[i] = { SYMBOL_ID_POISON, SCOPE_TABLE_NO_ENTRY };
+
+    ScopeTableSlot* oldIndex         = table->index;
+    const size_t    oldIndexCapacity = table->indexCapacity;
+
+    table->index         = newIndex;
+    table->indexCapacity = indexCapacity;
+
+    for (size_t i = 0; i < oldIndexCapacity; ++i)
+    {
+        if (oldIndex[i].symbol != SYMBOL_ID_POISON)
+            *ScopeTableGetSlot(table, oldIndex[i].symbol) = oldIndex[i];
+    }
+
+    free(oldIndex);
+
+    return ScopeTableErrors::NO_ERR;
+}
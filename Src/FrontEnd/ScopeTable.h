@@ -0,0 +1,74 @@
+#ifndef SCOPE_TABLE_H
+#define SCOPE_TABLE_H
+
+/// @file
+/// @brief Contains symbol table with nested scopes for the parser
+/// @details Declarations are kept on a stack, hash index gives the visible declaration
+/// of the symbol, so finding is O(1). Declaration hides the previous one of the same symbol
+/// until its scope is popped.
+
+#include <stddef.h>
+
+#include "Common/SymbolPool.h"
+
+/// @brief Declaration of the symbol in some scope
+struct ScopeTableEntry
+{
+    SymbolId symbol;
+    int      nameId;    ///< id in the allNamesTable of the tree
+    size_t   hidden;    ///< visible declaration of the symbol before this one, SCOPE_TABLE_NO_ENTRY if none
+};
+
+/// @brief Slot of the hash index. Symbols are never removed from the index,
+/// slot just has no visible declaration after its scope is popped
+struct ScopeTableSlot
+{
+    SymbolId symbol;    ///< SYMBOL_ID_POISON - empty slot
+    size_t   entry;     ///< visible declaration, SCOPE_TABLE_NO_ENTRY if none
+};
+
+static const size_t SCOPE_TABLE_NO_ENTRY = SIZE_MAX;
+
+struct ScopeTable
+{
+    ScopeTableEntry* entries;       ///< declarations stack
+    size_t           size;
+    size_t           capacity;
+
+    ScopeTableSlot*  index;         ///< open addressing hash index by symbol
+    size_t           indexSize;     ///< used slots
+    size_t           indexCapacity; ///< power of 2
+
+    size_t*          scopeStarts;   ///< entries size at the beginning of every opened scope
+    size_t           scopesCount;
+    size_t           scopesCapacity;
+};
+
+enum class ScopeTableErrors
+{
+    NO_ERR,
+
+    MEM_ERR,
+    NO_SCOPE_ERR,
+};
+
+/// @brief Constructor, table has one (global) scope that can't be popped
+ScopeTableErrors ScopeTableCtor(ScopeTable* table);
+void             ScopeTableDtor(ScopeTable* table);
+
+/// @brief Opens new scope, its declarations hide the outer ones
+ScopeTableErrors ScopeTablePushScope(ScopeTable* table);
+
+/// @brief Closes the last scope, declarations hidden by it become visible again
+ScopeTableErrors ScopeTablePopScope(ScopeTable* table);
+
+/// @brief Declares symbol in the last scope
+/// @param [in]nameId id that is returned by ScopeTableFind while declaration is visible
+ScopeTableErrors ScopeTableDeclare(ScopeTable* table, const SymbolId symbol, const int nameId);
+
+/// @brief Finds visible declaration of the symbol
+/// @param [out]outNameId nameId of the declaration
+/// @return true if symbol is declared otherwise false
+bool ScopeTableFind(const ScopeTable* table, const SymbolId symbol, int* outNameId);
+
+#endif
@@ -1,12 +1,16 @@
 #include <ctype.h>
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
+#include <thread>
 
 #include "LexicalParser.h"
 #include "Tree/DSL.h"
 #include "Tree/Tree.h"
+#include "Tree/TreeVisitor.h"
 #include "Tree/NameTable/NameTable.h"
 #include "SyntaxParser.h"
+#include "ScopeTable.h"
 #include "Common/StringFuncs.h"
 #include "TokensArr/TokensArr.h"
 #include "Common/Colors.h"
@@ -15,16 +19,22 @@
 
 struct DescentState
 {
-    TokensArr tokens;
+    TokenStream tokens;
 
     size_t tokenPos;
 
-    NameTableType* globalTable; 
-    NameTableType* currentLocalTable;
+    ScopeTable     scopes;          ///< declarations visible at the current token
 
-    NameTableType* allNamesTable;
+    NameTableType* allNamesTable;   ///< every name once, string literals are always new
 
     const char* codeString;
+
+    bool quiet;                     ///< syntax errors aren't printed
+
+    bool      externalNamesAllowed; ///< undeclared names are collected to externalNames
+    SymbolId* externalNames;        ///< have to be declared before the code (e.g. in previous chunks)
+    size_t    externalNamesSize;
+    size_t    externalNamesCapacity;
 };
 
 static void DescentStateCtor(DescentState* state, const char* codeString);
@@ -50,6 +60,7 @@ static void DescentStateDtor(DescentState* state);
 // ADD_SUB          ::= MUL_DIV {[+, -] MUL_DIV}*
 // MUL_DIV          ::= POW {[*, /] POW}*
 // POW              ::= FUNC_CALL {['^'] FUNC_CALL}*
+// (OR - POW levels are parsed by one precedence climbing loop, see BINARY_OPS_TABLE)
 // FUNC_CALL        ::= IN_BUILD_FUNCS | CREATED_FUNCS | EXPR
 // IN_BUILT_FUNCS   ::= [sin/cos/tan/cot/sqrt] EXPR '57' | READ
 // MADE_FUNC_CALL   ::= VAR '{' FUNC_VARS_CALL '57' 
@@ -63,7 +74,6 @@ static void DescentStateDtor(DescentState* state);
 static TreeNode* GetVar              (DescentState* state, bool* outErr);
 static TreeNode* CreateVar           (DescentState* state, bool* outErr);
 static TreeNode* GetGrammar          (DescentState* state, bool* outErr);
-static TreeNode* GetAddSub           (DescentState* state, bool* outErr);
 static TreeNode* GetType             (DescentState* state, bool* outErr);
 static TreeNode* GetFuncDef          (DescentState* state, bool* outErr);
 static TreeNode* GetFunc             (DescentState* state, bool* outErr);
@@ -77,11 +87,8 @@ static TreeNode* GetWhile            (DescentState* state, bool* outErr);
 static TreeNode* GetIf               (DescentState* state, bool* outErr);
 static TreeNode* GetOp               (DescentState* state, bool* outErr);
 static TreeNode* GetAssign           (DescentState* state, bool* outErr);
-static TreeNode* GetAnd              (DescentState* state, bool* outErr);
 static TreeNode* GetOr               (DescentState* state, bool* outErr);
-static TreeNode* GetCmp              (DescentState* state, bool* outErr);
-static TreeNode* GetMulDiv           (DescentState* state, bool* outErr);
-static TreeNode* GetPow              (DescentState* state, bool* outErr);
+static TreeNode* GetBinaryOps        (DescentState* state, const int minBindingPower, bool* outErr);
 static TreeNode* GetMadeFuncCall     (DescentState* state, bool* outErr);
 static TreeNode* GetBuiltInFuncCall  (DescentState* state, bool* outErr);
 static TreeNode* GetExpr             (DescentState* state, bool* outErr);
@@ -90,11 +97,78 @@ static TreeNode* GetNum              (DescentState* state, bool* outErr);
 static TreeNode* GetReturn           (DescentState* state, bool* outErr);
 static TreeNode* GetConstString      (DescentState* state, bool* outErr);
 
-static inline Token* GetLastToken(DescentState* state)
+static const size_t EXTERNAL_NAMES_STANDARD_CAPACITY = 64;
+
+static int  GetNameId       (DescentState* state, const SymbolId symbol, bool* outErr);
+static void AddExternalName (DescentState* state, const SymbolId symbol, bool* outErr);
+static void PushScope       (DescentState* state, bool* outErr);
+static void PopScope        (DescentState* state, bool* outErr);
+
+/// @brief Binary operation that is parsed by GetBinaryOps
+struct BinaryOp
+{
+    int             bindingPower;   ///< bigger binds tighter, BINARY_OPS_NO_BINDING - not a binary op
+    TreeOperationId operation;
+};
+
+struct BinaryOpsTable
+{
+    BinaryOp ops[256];      ///< indexed by TokenKind
+};
+
+static const int BINARY_OPS_NO_BINDING       = -1;
+static const int BINARY_OPS_MIN_BINDING_POWER = 1;
+
+static constexpr BinaryOpsTable BinaryOpsTableCreate()
+{
+    BinaryOpsTable table = {};
+
+    for (size_t i = 0; i < 256; ++i)
+        table.ops[i] = { BINARY_OPS_NO_BINDING, TreeOperationId::ADD };
+
+    struct { LangOpId langOpId; int bindingPower; TreeOperationId operation; } binaryOps[] =
+    {
+        { LangOpId::OR,         1, TreeOperationId::OR         },
+        { LangOpId::AND,        2, TreeOperationId::AND        },
+
+        { LangOpId::LESS,       3, TreeOperationId::LESS       },
+        { LangOpId::LESS_EQ,    3, TreeOperationId::LESS_EQ    },
+        { LangOpId::GREATER,    3, TreeOperationId::GREATER    },
+        { LangOpId::GREATER_EQ, 3, TreeOperationId::GREATER_EQ },
+        { LangOpId::EQ,         3, TreeOperationId::EQ         },
+        { LangOpId::NOT_EQ,     3, TreeOperationId::NOT_EQ     },
+
+        { LangOpId::ADD,        4, TreeOperationId::ADD        },
+        { LangOpId::SUB,        4, TreeOperationId::SUB        },
+
+        { LangOpId::MUL,        5, TreeOperationId::MUL        },
+        { LangOpId::DIV,        5, TreeOperationId::DIV        },
+
+        { LangOpId::POW,        6, TreeOperationId::POW        },
+    };
+
+    for (size_t i = 0; i < sizeof(binaryOps) / sizeof(*binaryOps); ++i)
+        table.ops[(uint8_t)TokenKindCreate(binaryOps[i].langOpId)] = { binaryOps[i].bindingPower,
+                                                                       binaryOps[i].operation };
+
+    return table;
+}
+
+static constexpr BinaryOpsTable BINARY_OPS_TABLE = BinaryOpsTableCreate();
+
+// Tokens are pulled from the stream on demand, positions are in the whole stream
+static inline TokenKind GetTokenKind(DescentState* state, const size_t pos)
+{
+    assert(state);
+
+    return TokensArrGetKind(&state->tokens.window, TokenStreamFetch(&state->tokens, pos));
+}
+
+static inline TokenValue GetLastTokenValue(DescentState* state)
 {
     assert(state);
 
-    return &state->tokens.data[POS(state)];
+    return TokensArrGetValue(&state->tokens.window, TokenStreamFetch(&state->tokens, POS(state)));
 }
 
 #define SynAssert(state, statement, outErr)                 \
@@ -102,9 +176,7 @@ do                                                          \
 {                                                           \
     assert(outErr);                                         \
     SYN_ASSERT(state, statement, outErr);                   \
-    LOG_BEGIN();                                            \
-    Log("func - %s, line - %d\n", __func__, __LINE__);      \
-    LOG_END();                                              \
+    LOG_TRACE("func - %s, line - %d\n", __func__, __LINE__);\
 } while (0)
 
 #define IF_ERR_RET(outErr, node1, node2)                \
@@ -126,40 +198,36 @@ static inline void SYN_ASSERT(DescentState* state, bool statement, bool* outErr)
     if (statement)
         return;
 
-    printf(RED_TEXT("Syntax error in line %zu, string - %s\n"), 
-           GetLastToken(state)->line, state->codeString + GetLastToken(state)->pos);
     *outErr = true;
+
+    if (state->quiet)
+        return;
+
+    printf(RED_TEXT("Syntax error in line %zu, string - %s\n"), 
+           TokensArrGetLine(&state->tokens.window, TokenStreamFetch(&state->tokens, POS(state))),
+           state->codeString + TokensArrGetPos(&state->tokens.window,
+                                               TokenStreamFetch(&state->tokens, POS(state))));
 }
 
 static inline bool PickToken(DescentState* state, LangOpId langOpId)
 {
     assert(state);
 
-    if (state->tokens.data[POS(state)].valueType      == TokenValueType::LANG_OP &&
-        state->tokens.data[POS(state)].value.langOpId == langOpId)
-        return true;
-    
-    return false;
+    return GetTokenKind(state, POS(state)) == TokenKindCreate(langOpId);
 }
 
 static inline bool PickNum(DescentState* state)
 {
     assert(state);
 
-    if (state->tokens.data[POS(state)].valueType == TokenValueType::NUM)
-        return true;
-
-    return false;
+    return TokenKindGetValueType(GetTokenKind(state, POS(state))) == TokenValueType::NUM;
 }
 
 static inline bool PickName(DescentState* state)
 {
     assert(state);
 
-    if (state->tokens.data[POS(state)].valueType == TokenValueType::NAME)
-        return true;
-
-    return false;
+    return GetTokenKind(state, POS(state)) == TokenKind::NAME;
 }
 
 static inline bool ConsumeToken(DescentState* state, LangOpId langOpId, bool* outErr)
@@ -210,22 +278,18 @@ static inline bool PickTokenOnPos(DescentState* state, const size_t pos, LangOpI
 {
     assert(state);
 
-    if (state->tokens.data[pos].valueType     == TokenValueType::LANG_OP &&
-        state->tokens.data[pos].value.langOpId == langOpId)
-        return true;
-    
-    return false;
+    return GetTokenKind(state, pos) == TokenKindCreate(langOpId);
 }
 
 static inline LangOpId GetLastTokenId(DescentState* state)
 {
     assert(state);
-    assert(state->tokens.data[POS(state)].valueType == TokenValueType::LANG_OP);
+    assert(TokenKindGetValueType(GetTokenKind(state, POS(state))) == TokenValueType::LANG_OP);
 
-    return state->tokens.data[POS(state)].value.langOpId;
+    return (LangOpId)GetTokenKind(state, POS(state));
 }
 
-Tree CodeParse(const char* code, SyntaxParserErrors* outErr)
+Tree CodeParse(const char* code, SyntaxParserErrors* outErr, const size_t lexThreadsCount)
 {
     assert(code);
 
@@ -234,15 +298,14 @@ Tree CodeParse(const char* code, SyntaxParserErrors* outErr)
 
     DescentState state = {};
     DescentStateCtor(&state, code);
-
-    ParseOnTokens(code, &state.tokens);
+    TokenStreamCtor(&state.tokens, code, lexThreadsCount);
 
     bool err = false;
 
     tree.root          = GetGrammar(&state, &err);
     tree.allNamesTable = state.allNamesTable;
 
-    if (err)
+    if (err || state.tokens.error != LexicalParserErrors::NO_ERR)
         *outErr = SyntaxParserErrors::SYNTAX_ERR; 
 
     DescentStateDtor(&state);
@@ -250,6 +313,287 @@ Tree CodeParse(const char* code, SyntaxParserErrors* outErr)
     return tree;
 }
 
+//---------------------------------------------------------------------------------------
+
+// Code is cut at the same lines as for the parallel lexing, every chunk is parsed on its
+// own thread into its own tree, names table and scopes. Names that aren't declared in the
+// chunk have to be functions of the previous chunks, they are checked after all chunks
+// are parsed. If any chunk can't be parsed by itself (e.g. the cut isn't between functions) the code
+// is parsed again sequentially, so errors are printed the same way.
+
+static const size_t PARSE_MAX_THREADS_COUNT = 64;
+
+struct SyntaxChunk
+{
+    size_t begin;
+    size_t end;         ///< SIZE_MAX for the last chunk
+
+    Tree         tree;  ///< chunk functions, their nodes and names
+    DescentState state;
+
+    int* namesRemap;    ///< ids of the chunk names in the merged allNamesTable
+    bool err;
+};
+
+static void SyntaxChunkParse(const char* code, SyntaxChunk* chunk);
+static void SyntaxChunkLink (SyntaxChunk* chunks, const size_t chunkPos);
+
+static NameTableType* SyntaxChunksMergeNames(SyntaxChunk* chunks, const size_t chunksCount);
+static TreeNode*      SyntaxChunkAppendFuncs(TreeNode* root, TreeNode* chunkRoot);
+static TreeErrors     RemapNameIds(TreeNode** root, const int* namesRemap);
+static TreeVisitAction RemapNameId (TreeNode** link, TreeVisitState* state, void* context);
+
+Tree CodeParseParallel(const char* code, SyntaxParserErrors* outErr, const size_t threadsCount)
+{
+    assert(code);
+    assert(outErr);
+    assert(threadsCount > 0);
+
+    const size_t chunksCountMax = threadsCount < PARSE_MAX_THREADS_COUNT ? threadsCount :
+                                                                           PARSE_MAX_THREADS_COUNT;
+
+    size_t splitPoints[PARSE_MAX_THREADS_COUNT + 1] = {};
+    size_t chunksCount = LexFindSplitPoints(code, strlen(code), splitPoints, chunksCountMax);
+
+    if (chunksCount == 1)
+        return CodeParse(code, outErr);
+
+    SyntaxChunk* chunks = (SyntaxChunk*)calloc(chunksCount, sizeof(*chunks));
+    if (chunks == nullptr)
+        return CodeParse(code, outErr);
+
+    for (size_t i = 0; i < chunksCount; ++i)
+    {
+        chunks[i].begin = splitPoints[i];
+        chunks[i].end   = i + 1 < chunksCount ? splitPoints[i + 1] : SIZE_MAX;
+    }
+
+    // the first chunk is parsed by this thread
+    std::thread workers[PARSE_MAX_THREADS_COUNT];
+
+    for (size_t i = 1; i < chunksCount; ++i)
+        workers[i] = std::thread(SyntaxChunkParse, code, &chunks[i]);
+
+    SyntaxChunkParse(code, &chunks[0]);
+
+    for (size_t i = 1; i < chunksCount; ++i)
+        workers[i].join();
+
+    bool err = false;
+    for (size_t i = 0; i < chunksCount; ++i)
+        err = err || chunks[i].err;
+
+    NameTableType* allNamesTable = err ? nullptr : SyntaxChunksMergeNames(chunks, chunksCount);
+    err = allNamesTable == nullptr;
+
+    if (!err)
+    {
+        for (size_t i = 1; i < chunksCount; ++i)
+            workers[i] = std::thread(SyntaxChunkLink, chunks, i);
+
+        SyntaxChunkLink(chunks, 0);
+
+        for (size_t i = 1; i < chunksCount; ++i)
+            workers[i].join();
+
+        for (size_t i = 0; i < chunksCount; ++i)
+            err = err || chunks[i].err;
+    }
+
+    Tree tree = {};
+
+    if (!err)
+    {
+        TreeCtor(&tree);
+        tree.allNamesTable = allNamesTable;
+
+        for (size_t i = 0; i < chunksCount; ++i)
+        {
+            TreeAbsorbNodes(&tree, &chunks[i].tree);
+            tree.root = SyntaxChunkAppendFuncs(tree.root, chunks[i].tree.root);
+        }
+    }
+    else if (allNamesTable)
+        NameTableDtor(allNamesTable);
+
+    for (size_t i = 0; i < chunksCount; ++i)
+    {
+        DescentStateDtor(&chunks[i].state);
+        TreeDtor(&chunks[i].tree);
+        free(chunks[i].namesRemap);
+    }
+
+    free(chunks);
+
+    if (err)
+        return CodeParse(code, outErr);
+
+    return tree;
+}
+
+static void SyntaxChunkParse(const char* code, SyntaxChunk* chunk)
+{
+    assert(code);
+    assert(chunk);
+
+    // nodes are created in the arena of the chunk tree, it is current only for this thread
+    TreeCtor(&chunk->tree);
+
+    DescentStateCtor(&chunk->state, code);
+    TokenStreamCtor(&chunk->state.tokens, code, chunk->begin, chunk->end);
+
+    chunk->state.quiet                = true;
+    chunk->state.externalNamesAllowed = true;
+
+    chunk->tree.root          = GetGrammar(&chunk->state, &chunk->err);
+    chunk->tree.allNamesTable = chunk->state.allNamesTable;
+
+    if (chunk->state.tokens.error != LexicalParserErrors::NO_ERR)
+        chunk->err = true;
+}
+
+// Ids are remapped to the merged allNamesTable. Undeclared names are the calls of the
+// functions that have to be declared in the previous chunks. Their scopes are read only
+// now, so chunks are linked in parallel.
+static void SyntaxChunkLink(SyntaxChunk* chunks, const size_t chunkPos)
+{
+    assert(chunks);
+
+    SyntaxChunk* chunk = &chunks[chunkPos];
+
+    if (RemapNameIds(&chunk->tree.root, chunk->namesRemap) != TreeErrors::NO_ERR)
+    {
+        chunk->err = true;
+        return;
+    }
+
+    for (size_t i = 0; i < chunk->state.externalNamesSize; ++i)
+    {
+        bool isDeclared = false;
+
+        for (size_t prevPos = 0; prevPos < chunkPos && !isDeclared; ++prevPos)
+        {
+            int nameId = 0;
+            isDeclared = ScopeTableFind(&chunks[prevPos].state.scopes,
+                                        chunk->state.externalNames[i], &nameId);
+        }
+
+        if (!isDeclared)
+        {
+            chunk->err = true;
+            return;
+        }
+    }
+}
+
+// Names are united the same way as GetNameId does it, string literals are always new.
+// Chunks are merged in the code order, so ids are the same as in the sequential parsing.
+static NameTableType* SyntaxChunksMergeNames(SyntaxChunk* chunks, const size_t chunksCount)
+{
+    assert(chunks);
+
+    NameTableType* allNamesTable = nullptr;
+    if (NameTableCtor(&allNamesTable) != NameTableErrors::NO_ERR)
+        return nullptr;
+
+    for (size_t i = 0; i < chunksCount; ++i)
+    {
+        const NameTableType* chunkNames = chunks[i].tree.allNamesTable;
+
+        chunks[i].namesRemap = (int*)calloc(chunkNames->size + 1, sizeof(*chunks[i].namesRemap));
+        if (chunks[i].namesRemap == nullptr)
+        {
+            NameTableDtor(allNamesTable);
+            return nullptr;
+        }
+
+        for (size_t j = 0; j < chunkNames->size; ++j)
+        {
+            Name* name = nullptr;
+            if (chunkNames->data[j].name[0] != '"')
+                NameTableFind(allNamesTable, chunkNames->data[j].symbol, &name);
+
+            if (name != nullptr)
+            {
+                chunks[i].namesRemap[j] = (int)(name - allNamesTable->data);
+                continue;
+            }
+
+            if (NameTablePush(allNamesTable, chunkNames->data[j]) != NameTableErrors::NO_ERR)
+            {
+                NameTableDtor(allNamesTable);
+                return nullptr;
+            }
+
+            chunks[i].namesRemap[j] = (int)allNamesTable->size - 1;
+        }
+    }
+
+    return allNamesTable;
+}
+
+// Functions are in the left-deep chain NEW_FUNC(NEW_FUNC(f1, f2), f3), so chunk
+// functions are hung on the previous ones through the leftmost function of the chunk
+static TreeNode* SyntaxChunkAppendFuncs(TreeNode* root, TreeNode* chunkRoot)
+{
+    assert(chunkRoot);
+
+    if (root == nullptr)
+        return chunkRoot;
+
+    TreeNode* parent = nullptr;
+    TreeNode* first  = chunkRoot;
+
+    while (first->valueType == TreeNodeValueType::OPERATION &&
+           first->value.operation == TreeOperationId::NEW_FUNC)
+    {
+        parent = first;
+        first  = first->left;
+    }
+
+    TreeNode* newFunc = CREATE_NEW_FUNC_NODE(root, first);
+
+    if (parent == nullptr)
+        return newFunc;
+
+    parent->left = newFunc;
+
+    return chunkRoot;
+}
+
+struct NamesRemap
+{
+    const int* namesRemap;
+};
+
+static TreeErrors RemapNameIds(TreeNode** root, const int* namesRemap)
+{
+    assert(root);
+    assert(namesRemap);
+
+    static const TreeVisitor remapVisitor = { RemapNameId, nullptr, nullptr, false };
+
+    NamesRemap context = { namesRemap };
+
+    return TreeVisit(root, &remapVisitor, &context);
+}
+
+static TreeVisitAction RemapNameId(TreeNode** link, TreeVisitState*, void* context)
+{
+    assert(link);
+    assert(context);
+
+    TreeNode* node = *link;
+
+    if (node->valueType == TreeNodeValueType::NAME ||
+        node->valueType == TreeNodeValueType::STRING_LITERAL)
+        node->value.nameId = ((NamesRemap*)context)->namesRemap[node->value.nameId];
+
+    return TreeVisitAction::CONTINUE;
+}
+
+//---------------------------------------------------------------------------------------
+
 static TreeNode* GetGrammar(DescentState* state, bool* outErr)
 {
     assert(state);
@@ -282,23 +626,21 @@ static TreeNode* GetFunc(DescentState* state, bool* outErr)
 
 static TreeNode* GetFuncDef(DescentState* state, bool* outErr)
 {
-    NameTableType* localNameTable = nullptr;
-    NameTableCtor(&localNameTable);
-
     TreeNode* func = nullptr;
 
     TreeNode* typeNode = GetType(state, outErr);
     IF_ERR_RET(outErr, typeNode, nullptr);
 
+    // function name is declared in the global scope before the body, so recursion works
     TreeNode* funcName = CreateVar(state, outErr);
     IF_ERR_RET(outErr, typeNode, funcName);
     
-    //TODO: create set table function
-    assert(!state->globalTable->data[funcName->value.nameId].localNameTable);
-    state->globalTable->data[funcName->value.nameId].localNameTable = (void*)localNameTable;
-    state->currentLocalTable = localNameTable;
     func = CREATE_FUNC_NODE(funcName);
 
+    // variables live until the end of the function (as in the backend), blocks don't open scopes
+    PushScope(state, outErr);
+    IF_ERR_RET(outErr, func, typeNode);
+
     TreeNode* funcVars = GetFuncVarsDef(state, outErr);
     funcName->left = funcVars;
     IF_ERR_RET(outErr, func, typeNode);
@@ -310,6 +652,9 @@ static TreeNode* GetFuncDef(DescentState* state, bool* outErr)
     funcName->right = funcCode;
     IF_ERR_RET(outErr, func, typeNode);
 
+    PopScope(state, outErr);
+    IF_ERR_RET(outErr, func, typeNode);
+
     func = CREATE_TYPE_NODE(typeNode, func);
 
     return func;
@@ -494,7 +839,7 @@ static TreeNode* GetPrint(DescentState* state, bool* outErr)
     IF_ERR_RET(outErr, nullptr, nullptr);
 
     TreeNode* arg = nullptr;
-    if (PickName(state) && state->tokens.data[state->tokenPos].value.name[0] == '"')
+    if (PickName(state) && SymbolGetName(GetLastTokenValue(state).symbol)[0] == '"')
         arg = GetConstString(state, outErr);
     else
         arg = GetArg(state, outErr);
@@ -565,173 +910,31 @@ static TreeNode* GetFuncVarsCall(DescentState* state, bool* outErr)
 
 static TreeNode* GetOr(DescentState* state, bool* outErr)
 {
-    TreeNode* allExpr = GetAnd(state, outErr);
-    IF_ERR_RET(outErr, allExpr, nullptr);
-
-    while (PickToken(state, LangOpId::OR))
-    {
-        ConsumeToken(state, LangOpId::OR, outErr);
-        IF_ERR_RET(outErr, allExpr, nullptr);
-
-        TreeNode* tmpExpr = GetAnd(state, outErr);
-        IF_ERR_RET(outErr, tmpExpr, allExpr);
-
-        allExpr = CREATE_OR_NODE(allExpr, tmpExpr);
-    }
-
-    return allExpr;
+    return GetBinaryOps(state, BINARY_OPS_MIN_BINDING_POWER, outErr);
 }
 
-static TreeNode* GetAnd(DescentState* state, bool* outErr)
+// Precedence climbing: operand is parsed and then operations that bind at least as tight
+// as minBindingPower are taken. All operations are left associative, so the right operand
+// takes only tighter operations. Trees are the same as with the level per priority grammar.
+static TreeNode* GetBinaryOps(DescentState* state, const int minBindingPower, bool* outErr)
 {
-    TreeNode* allExpr = GetCmp(state, outErr);
-    IF_ERR_RET(outErr, allExpr, nullptr);
-
-    while (PickToken(state, LangOpId::AND))
-    {
-        ConsumeToken(state, LangOpId::AND, outErr);
-        IF_ERR_RET(outErr, allExpr, nullptr);
-
-        TreeNode* tmpExpr = GetCmp(state, outErr);
-        IF_ERR_RET(outErr, tmpExpr, allExpr);
-
-        allExpr = CREATE_AND_NODE(allExpr, tmpExpr);
-    }
-
-    return allExpr;
-}
-
-static TreeNode* GetCmp(DescentState* state, bool* outErr)
-{
-    TreeNode* allExpr = GetAddSub(state, outErr);
-    IF_ERR_RET(outErr, allExpr, nullptr);
-
-    while (PickToken(state, LangOpId::LESS)    || PickToken(state, LangOpId::LESS_EQ)     ||
-           PickToken(state, LangOpId::GREATER) || PickToken(state, LangOpId::GREATER_EQ)  ||
-           PickToken(state, LangOpId::EQ)      || PickToken(state, LangOpId::NOT_EQ))
-    {
-        LangOpId langOpId = GetLastTokenId(state);
-        POS(state)++;
-
-        TreeNode* newExpr = GetAddSub(state, outErr);
-        IF_ERR_RET(outErr, allExpr, newExpr);
-
-        switch (langOpId)
-        {
-            case LangOpId::LESS:
-                allExpr = CREATE_LESS_NODE(allExpr, newExpr);
-                break;
-
-            case LangOpId::LESS_EQ:
-                allExpr = CREATE_LESS_EQ_NODE(allExpr, newExpr);
-                break;
-            
-            case LangOpId::GREATER:
-                allExpr = CREATE_GREATER_NODE(allExpr, newExpr);
-                break;
-
-            case LangOpId::GREATER_EQ:
-                allExpr = CREATE_GREATER_EQ_NODE(allExpr, newExpr);
-                break;
-
-            case LangOpId::EQ:
-                allExpr = CREATE_EQ_NODE(allExpr, newExpr);
-                break;
-
-            case LangOpId::NOT_EQ:
-                allExpr = CREATE_NOT_EQ_NODE(allExpr, newExpr);
-                break;
-            default:
-                SynAssert(state, false, outErr);
-                IF_ERR_RET(outErr, allExpr, newExpr);
-                break;
-        }
-    }
-
-    return allExpr;
-}
-
-static TreeNode* GetAddSub(DescentState* state, bool* outErr)
-{
-    TreeNode* allExpr = GetMulDiv(state, outErr);
+    TreeNode* allExpr = GetFuncCall(state, outErr);
     IF_ERR_RET(outErr, allExpr, nullptr);
 
-    while (PickToken(state, LangOpId::ADD) || PickToken(state, LangOpId::SUB))
+    while (true)
     {
-        LangOpId langOpId = GetLastTokenId(state);
-        POS(state)++;
-
-        TreeNode* newExpr = GetMulDiv(state, outErr);
-        IF_ERR_RET(outErr, allExpr, newExpr);
-
-        switch (langOpId)
-        {
-            case LangOpId::ADD:
-                allExpr = CREATE_ADD_NODE(allExpr, newExpr);
-                break;
-            
-            case LangOpId::SUB:
-                allExpr = CREATE_SUB_NODE(allExpr, newExpr);
-                break;
-
-            default:
-                SynAssert(state, false, outErr);
-                IF_ERR_RET(outErr, allExpr, newExpr);
-                break;
-        }
-    }
-
-    return allExpr;
-}
+        const BinaryOp binaryOp = BINARY_OPS_TABLE.ops[(uint8_t)GetTokenKind(state, POS(state))];
 
-static TreeNode* GetMulDiv(DescentState* state, bool* outErr)
-{
-    TreeNode* allExpr = GetPow(state, outErr);
-    IF_ERR_RET(outErr, allExpr, nullptr);
+        if (binaryOp.bindingPower < minBindingPower)
+            break;
 
-    while (PickToken(state, LangOpId::MUL) || PickToken(state, LangOpId::DIV))
-    {
-        LangOpId langOpId = GetLastTokenId(state);
         POS(state)++;
 
-        TreeNode* newExpr = GetPow(state, outErr);
+        TreeNode* newExpr = GetBinaryOps(state, binaryOp.bindingPower + 1, outErr);
         IF_ERR_RET(outErr, allExpr, newExpr);
 
-        switch (langOpId)
-        {
-            case LangOpId::MUL:
-                allExpr = CREATE_MUL_NODE(allExpr, newExpr);
-                break;
-            
-            case LangOpId::DIV:
-                allExpr = CREATE_DIV_NODE(allExpr, newExpr);
-                break;
-
-            default:
-                SynAssert(state, false, outErr);
-                IF_ERR_RET(outErr, allExpr, newExpr);
-                break;
-        }
-    }
-
-    return allExpr;
-}
-
-static TreeNode* GetPow(DescentState* state, bool* outErr)
-{
-    TreeNode* allExpr = GetFuncCall(state, outErr);
-    IF_ERR_RET(outErr, allExpr, nullptr);
-
-    while (PickToken(state, LangOpId::POW))
-    {
-        LangOpId langOpId = GetLastTokenId(state);
-        POS(state)++;
-
-        TreeNode* newExpr = GetFuncCall(state, outErr);
-        IF_ERR_RET(outErr, allExpr, newExpr);
-        
-        assert(langOpId == LangOpId::POW);
-        allExpr = CREATE_POW_NODE(allExpr, newExpr);
+        allExpr = TreeNodeCreate(TreeCreateOpVal(binaryOp.operation), TreeNodeValueType::OPERATION,
+                                 allExpr, newExpr);
     }
 
     return allExpr;
@@ -822,7 +1025,7 @@ static TreeNode* GetNum(DescentState* state, bool* outErr)
     SynAssert(state, PickNum(state), outErr);
     IF_ERR_RET(outErr, nullptr, nullptr);
 
-    TreeNode* num = CREATE_NUM(state->tokens.data[POS(state)].value.num);
+    TreeNode* num = CREATE_NUM(GetLastTokenValue(state).num);
     POS(state)++;
 
     return num;
@@ -833,16 +1036,16 @@ static TreeNode* CreateVar(DescentState* state, bool* outErr)
     SynAssert(state, PickName(state), outErr);
     IF_ERR_RET(outErr, nullptr, nullptr);
 
-    Name pushLocalName      = {};
-    Name pushToAllNamesName = {};
-    NameCtor(&pushLocalName,      state->tokens.data[POS(state)].value.name, nullptr, 0);
-    NameCtor(&pushToAllNamesName, state->tokens.data[POS(state)].value.name, nullptr, 0);
+    const SymbolId symbol = GetLastTokenValue(state).symbol;
 
-    TreeNode* varNode = nullptr;
+    int nameId = GetNameId(state, symbol, outErr);
+    IF_ERR_RET(outErr, nullptr, nullptr);
+
+    if (ScopeTableDeclare(&state->scopes, symbol, nameId) != ScopeTableErrors::NO_ERR)
+        *outErr = true;
+    IF_ERR_RET(outErr, nullptr, nullptr);
 
-    NameTablePush(state->currentLocalTable, pushLocalName);
-    NameTablePush(state->allNamesTable, pushToAllNamesName);
-    varNode = CREATE_VAR(state->allNamesTable->size - 1);
+    TreeNode* varNode = CREATE_VAR(nameId);
     
     POS(state)++;
 
@@ -851,35 +1054,102 @@ static TreeNode* CreateVar(DescentState* state, bool* outErr)
 
 static TreeNode* GetVar(DescentState* state, bool* outErr)
 {
-    SynAssert(state, state->tokens.data[POS(state)].value.name, outErr);
+    SynAssert(state, PickName(state), outErr);
     IF_ERR_RET(outErr, nullptr, nullptr);
 
-    assert(state->tokens.data);
-    assert(state->tokens.data[POS(state)].value.name);
+    const SymbolId symbol = GetLastTokenValue(state).symbol;
 
-    Name pushName = {};
-    NameCtor(&pushName, state->tokens.data[POS(state)].value.name, nullptr, 0);
+    int nameId = 0;
+    if (!ScopeTableFind(&state->scopes, symbol, &nameId))
+    {
+        SynAssert(state, state->externalNamesAllowed, outErr);
+        IF_ERR_RET(outErr, nullptr, nullptr);
 
-    TreeNode* varNode = nullptr;
+        AddExternalName(state, symbol, outErr);
+        IF_ERR_RET(outErr, nullptr, nullptr);
 
-    Name* outName = nullptr;
-    NameTableFind(state->allNamesTable, pushName.name, &outName);
+        nameId = GetNameId(state, symbol, outErr);
+        IF_ERR_RET(outErr, nullptr, nullptr);
+    }
 
-    SynAssert(state, outName != nullptr, outErr);
-    IF_ERR_RET(outErr, varNode, nullptr);
-    
-    //TODO: здесь пройтись по локали + глобали, проверить на существование переменную типо
-    varNode = CREATE_VAR(outName - state->allNamesTable->data);
+    TreeNode* varNode = CREATE_VAR(nameId);
     
     POS(state)++;
 
     return varNode;
 }
 
+// Names are united by symbol, so variables of different functions share the name,
+// but not the declaration (it is in ScopeTable)
+static int GetNameId(DescentState* state, const SymbolId symbol, bool* outErr)
+{
+    assert(state);
+    assert(outErr);
+
+    Name* name = nullptr;
+    NameTableFind(state->allNamesTable, symbol, &name);
+
+    if (name != nullptr)
+        return (int)(name - state->allNamesTable->data);
+
+    Name pushName = {};
+    NameCtor(&pushName, symbol, nullptr, 0);
+
+    if (NameTablePush(state->allNamesTable, pushName) != NameTableErrors::NO_ERR)
+    {
+        *outErr = true;
+        return 0;
+    }
+
+    return (int)state->allNamesTable->size - 1;
+}
+
+static void AddExternalName(DescentState* state, const SymbolId symbol, bool* outErr)
+{
+    assert(state);
+    assert(outErr);
+
+    if (state->externalNamesSize == state->externalNamesCapacity)
+    {
+        size_t newCapacity = state->externalNamesCapacity > 0 ? 2 * state->externalNamesCapacity :
+                                                                 EXTERNAL_NAMES_STANDARD_CAPACITY;
+
+        SymbolId* newNames = (SymbolId*)realloc(state->externalNames, newCapacity * sizeof(*newNames));
+        if (newNames == nullptr)
+        {
+            *outErr = true;
+            return;
+        }
+
+        state->externalNames         = newNames;
+        state->externalNamesCapacity = newCapacity;
+    }
+
+    state->externalNames[state->externalNamesSize++] = symbol;
+}
+
+static void PushScope(DescentState* state, bool* outErr)
+{
+    assert(state);
+    assert(outErr);
+
+    if (ScopeTablePushScope(&state->scopes) != ScopeTableErrors::NO_ERR)
+        *outErr = true;
+}
+
+static void PopScope(DescentState* state, bool* outErr)
+{
+    assert(state);
+    assert(outErr);
+
+    if (ScopeTablePopScope(&state->scopes) != ScopeTableErrors::NO_ERR)
+        *outErr = true;
+}
+
 static TreeNode* GetConstString(DescentState* state, bool* outErr)
 {
     Name pushName = {};
-    NameCtor(&pushName, state->tokens.data[POS(state)].value.name, nullptr, 0);
+    NameCtor(&pushName, GetLastTokenValue(state).symbol, nullptr, 0);
 
     //TODO: здесь проверки на то, что мы пушим (в плане того, чтобы не было конфликтов имен и т.д
     TreeNode* varNode = nullptr;
@@ -894,22 +1164,25 @@ static TreeNode* GetConstString(DescentState* state, bool* outErr)
     return varNode;
 }
 
+// tokens stream is constructed by the caller
 static void DescentStateCtor(DescentState* state, const char* str)
 {
-    TokensArrCtor(&state->tokens);
-    NameTableCtor(&state->globalTable);
+    ScopeTableCtor(&state->scopes);
     NameTableCtor(&state->allNamesTable);
 
-    state->currentLocalTable = state->globalTable;
-
     state->codeString       = str;
     state->tokenPos  = 0;
 }
 
 static void DescentStateDtor(DescentState* state)
 {    
-    NameTableDtor(state->globalTable);
+    ScopeTableDtor(&state->scopes);
 
-    TokensArrDtor(&state->tokens);
+    TokenStreamDtor(&state->tokens);
     state->tokenPos = 0;
+
+    free(state->externalNames);
+    state->externalNames         = nullptr;
+    state->externalNamesSize     = 0;
+    state->externalNamesCapacity = 0;
 }
@@ -10,6 +10,20 @@ enum class SyntaxParserErrors
     SYNTAX_ERR,
 };
 
-Tree CodeParse(const char* code, SyntaxParserErrors* outErr);
+/// @brief Parses code into AST
+/// @param [in]code code to parse
+/// @param [out]outErr error
+/// @param [in]lexThreadsCount 0 - tokens are lexed on demand while parsing,
+/// otherwise code is lexed beforehand on so many threads
+Tree CodeParse(const char* code, SyntaxParserErrors* outErr, const size_t lexThreadsCount = 0);
+
+/// @brief Parses function definitions on several threads and merges them into one AST
+/// @details Code is cut into chunks between function definitions (as for parallel lexing),
+/// every chunk is parsed with its own names tables and nodes arena. Tree is the same as
+/// CodeParse builds. If some chunk can't be parsed by itself code is parsed by CodeParse.
+/// @param [in]code code to parse
+/// @param [out]outErr error
+/// @param [in]threadsCount max count of the threads (and chunks)
+Tree CodeParseParallel(const char* code, SyntaxParserErrors* outErr, const size_t threadsCount);
 
 #endif
\ No newline at end of file
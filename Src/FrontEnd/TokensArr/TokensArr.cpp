@@ -1,81 +1,40 @@
-#include <math.h>
-#include <execinfo.h> 
+#include <stdlib.h>
 #include <string.h>
 
-#include "ArrayFuncs.h"
 #include "TokensArr.h"
 #include "Common/Log.h"
-#include "../../Common/Log.h"
 
 //----------static functions------------
 
-static TokensArrErrors TokensArrRealloc(TokensArr* tokensArr, bool increase);
+static TokensArrErrors TokensArrRealloc(TokensArr* tokensArr);
 
-static inline ElemType* MovePtr(ElemType* const data, const size_t moveSz, const int times);
+static TokensArrErrors TokensArrPushBigNum(TokensArr* tokensArr, const int value, uint32_t* outPos);
 
-static inline size_t TokensArrGetSizeForCalloc(TokensArr* const tokensArr);
-
-static void TokensArrDataFill(TokensArr* const tokensArr);
+static TokensArrErrors TokensArrBuildLineStarts(TokensArr* tokensArr);
 
 static inline bool TokensArrIsFull(TokensArr* tokensArr);
 
-static inline bool TokensArrIsTooBig(TokensArr* tokensArr);
-
-//--------CANARY PROTECTION----------
-
-#ifdef TOKENS_ARR_CANARY_PROTECTION
-
-    #define CanaryTypeFormat "%#0llx"
-    const CanaryType Canary = 0xDEADBABE;
-
-    const size_t Aligning = 8;
-
-    static inline void CanaryCtor(void* storage)
-    {
-        assert(storage);
-        CanaryType* strg = (CanaryType*) (storage);
-
-        *strg = Canary;
-    }
-
-    static inline ElemType* GetAfterFirstCanaryAdr(const TokensArr* const tokensArr)
-    {
-        return MovePtr(tokensArr->data, sizeof(CanaryType), 1);
-    }
-
-    static inline ElemType* GetFirstCanaryAdr(const TokensArr* const tokensArr)
-    {
-        return MovePtr(tokensArr->data, sizeof(CanaryType), -1);
-    }
-
-    static inline ElemType* GetSecondCanaryAdr(const TokensArr* const tokensArr)
-    {
-        return (ElemType*)((char*)(tokensArr->data + tokensArr->capacity) +
-                           Aligning - (tokensArr->capacity * sizeof(ElemType)) % Aligning);
-    }
-
-#endif
-
 //-----------HASH PROTECTION---------------
 
 #ifdef TOKENS_ARR_HASH_PROTECTION
 
     static inline HashType CalcDataHash(const TokensArr* tokensArr)
     {
-        return tokensArr->HashFunc(tokensArr->data, tokensArr->capacity * sizeof(ElemType), 0);        
+        HashType hash = tokensArr->HashFunc(tokensArr->kinds,
+                                            tokensArr->capacity * sizeof(*tokensArr->kinds), 0);
+        hash = tokensArr->HashFunc(tokensArr->payloads,
+                                   tokensArr->capacity * sizeof(*tokensArr->payloads), hash);
+        hash = tokensArr->HashFunc(tokensArr->positions,
+                                   tokensArr->capacity * sizeof(*tokensArr->positions), hash);
+
+        return hash;
     }
 
     static inline void UpdateDataHash(TokensArr* tokensArr)
     {
-        tokensArr->dataHash = CalcDataHash(tokensArr);      
+        tokensArr->dataHash = CalcDataHash(tokensArr);
     }
 
-    static inline void UpdateStructHash(TokensArr* tokensArr)
-    {
-        tokensArr->structHash = 0;                                  
-        tokensArr->structHash = TokensArrMurmurHash(tokensArr, sizeof(*tokensArr));        
-    }
-    
 #endif
 
 //--------------Consts-----------------
@@ -86,199 +45,293 @@ static const size_t STANDARD_CAPACITY = 64;
 
 #ifndef NDEBUG
 
-    #define TOKENS_ARR_CHECK(tokensArr)                    \
-    do                                          \
-    {                                           \
-        TokensArrErrors tokensArrErr = TokensArrVerify(tokensArr); \
-                                                \
-        if (tokensArrErr != TokensArrErrors::NO_ERR)                      \
-        {                                       \
-            TOKENS_ARR_DUMP(tokensArr);                    \
-            return tokensArrErr;                    \
-        }                                       \
+    #define TOKENS_ARR_CHECK(tokensArr)                                     \
+    do                                                                      \
+    {                                                                       \
+        TokensArrErrors tokensArrErr = TokensArrVerify(tokensArr);          \
+                                                                            \
+        if (tokensArrErr != TokensArrErrors::NO_ERR)                        \
+        {                                                                   \
+            TOKENS_ARR_DUMP(tokensArr);                                     \
+            return tokensArrErr;                                            \
+        }                                                                   \
     } while (0)
 
-    #define TOKENS_ARR_CHECK_NO_RETURN(tokensArr)         \
-    do                                         \
-    {                                          \
-        TokensArrErrors tokensArrErr = TokensArrVerify(tokensArr);     \
-                                                        \
-        if (tokensArrErr != TokensArrErrors::NO_ERR)   \
-        {                                               \
-            TOKENS_ARR_DUMP(tokensArr);                   \
-        }                                      \
+    #define TOKENS_ARR_CHECK_NO_RETURN(tokensArr)                           \
+    do                                                                      \
+    {                                                                       \
+        TokensArrErrors tokensArrErr = TokensArrVerify(tokensArr);          \
+                                                                            \
+        if (tokensArrErr != TokensArrErrors::NO_ERR)                        \
+        {                                                                   \
+            TOKENS_ARR_DUMP(tokensArr);                                     \
+        }                                                                   \
     } while (0)
 
 #else
 
-    #define TOKENS_ARR_CHECK(tokensArr)           
-    #define TOKENS_ARR_CHECK_NO_RETURN(tokensArr) 
+    #define TOKENS_ARR_CHECK(tokensArr)
+    #define TOKENS_ARR_CHECK_NO_RETURN(tokensArr)
 
 #endif
 
 //---------------
 
-#define IF_ERR_RETURN(ERR)              \
-do                                      \
-{                                       \
-    if (ERR != TokensArrErrors::NO_ERR)                            \
-        return ERR;                     \
+#define IF_ERR_RETURN(ERR)                          \
+do                                                  \
+{                                                   \
+    if (ERR != TokensArrErrors::NO_ERR)             \
+        return ERR;                                 \
 } while (0)
 
 //---------------
 
 #ifdef TOKENS_ARR_HASH_PROTECTION
-TokensArrErrors TokensArrCtor(TokensArr* const tokensArr, const size_t capacity, 
-                          const HashFuncType HashFunc)
+TokensArrErrors TokensArrCtor(TokensArr* const tokensArr, const char* code, const size_t capacity,
+                              const HashFuncType HashFunc)
+#else
+TokensArrErrors TokensArrCtor(TokensArr* const tokensArr, const char* code, const size_t capacity)
+#endif
 {
     assert(tokensArr);
+    assert(code);
+
+    *tokensArr = {};
 
     ON_HASH
     (
         tokensArr->HashFunc = HashFunc;
     )
 
-    //--------SET STRUCT CANARY-------
-    ON_CANARY
-    (
-        tokensArr->structCanaryLeft  = Canary;
-        tokensArr->structCanaryRight = Canary;
-    )
-
-    TokensArrErrors errors = TokensArrErrors::NO_ERR;
-    tokensArr->size = 0;
+    tokensArr->code = code;
 
-    if (capacity > 0) tokensArr->capacity = capacity;
-    else              tokensArr->capacity = STANDARD_CAPACITY;
+    TokensArrErrors err = TokensArrErrors::NO_ERR;
 
-    //----Callocing Memory-------
+    // Realloc doubles capacity
+    tokensArr->capacity = (capacity > 0 ? capacity : STANDARD_CAPACITY) / 2;
+    if (tokensArr->capacity == 0)
+        tokensArr->capacity = 1;
 
-    tokensArr->data = (ElemType*) calloc(TokensArrGetSizeForCalloc(tokensArr), sizeof(*tokensArr->data));
+    err = TokensArrRealloc(tokensArr);
 
-    if (tokensArr->data == nullptr)
+    if (err != TokensArrErrors::NO_ERR)
     {
-        TokensArrPrintError(TokensArrErrors::MEMORY_ALLOCATION_ERROR);  
-        return TokensArrErrors::MEMORY_ALLOCATION_ERROR;   
+        TokensArrPrintError(err);
+        return err;
     }
 
-    //-----------------------
-
-    TokensArrDataFill(tokensArr);
+    TOKENS_ARR_CHECK(tokensArr);
 
-    ON_CANARY
-    (
-        tokensArr->data = GetAfterFirstCanaryAdr(tokensArr);
-    )
+    return err;
+}
 
-    ON_HASH
-    (
-        UpdateDataHash(tokensArr);
-        UpdateStructHash(tokensArr);
-    )
+TokensArrErrors TokensArrDtor(TokensArr* const tokensArr)
+{
+    assert(tokensArr);
 
     TOKENS_ARR_CHECK(tokensArr);
 
-    return errors;
+    // names are interned in the global symbol pool, so tokens don't own them
+    free(tokensArr->kinds);
+    free(tokensArr->payloads);
+    free(tokensArr->positions);
+    free(tokensArr->bigNums);
+    free(tokensArr->lineStarts);
+
+    *tokensArr = {};
+
+    return TokensArrErrors::NO_ERR;
 }
-#else 
-TokensArrErrors TokensArrCtor(TokensArr* const tokensArr, const size_t capacity)
+
+TokensArrErrors TokensArrPush(TokensArr* tokensArr, const TokenValue value,
+                              const TokenValueType valueType, const size_t pos)
 {
     assert(tokensArr);
+    assert(pos <= UINT32_MAX);
 
-    //--------SET STRUCT CANARY-------
-    ON_CANARY
-    (
-        tokensArr->structCanaryLeft  = Canary;
-        tokensArr->structCanaryRight = Canary;
-    )
-
-    TokensArrErrors errors = TokensArrErrors::NO_ERR;
-    tokensArr->size = 0;
+    TOKENS_ARR_CHECK(tokensArr);
 
-    if (capacity > 0) tokensArr->capacity = capacity;
-    else              tokensArr->capacity = STANDARD_CAPACITY;
+    TokensArrErrors err = TokensArrErrors::NO_ERR;
+    if (TokensArrIsFull(tokensArr)) err = TokensArrRealloc(tokensArr);
 
-    //----Callocing Memory-------
+    IF_ERR_RETURN(err);
 
-    tokensArr->data = (ElemType*) calloc(TokensArrGetSizeForCalloc(tokensArr), sizeof(*tokensArr->data));
+    TokenKind kind    = TokenKind::NAME;
+    uint32_t  payload = 0;
 
-    if (tokensArr->data == nullptr)
+    switch (valueType)
     {
-        TokensArrPrintError(TokensArrErrors::MEMORY_ALLOCATION_ERROR);  
-        return TokensArrErrors::MEMORY_ALLOCATION_ERROR;   
-    }
+        case TokenValueType::LANG_OP:
+            kind = TokenKindCreate(value.langOpId);
+            break;
+
+        case TokenValueType::NAME:
+            if (value.symbol > TOKEN_PAYLOAD_MAX)
+            {
+                TokensArrPrintError(TokensArrErrors::TOKEN_OUT_OF_RANGE);
+                return TokensArrErrors::TOKEN_OUT_OF_RANGE;
+            }
+
+            kind    = TokenKind::NAME;
+            payload = value.symbol;
+            break;
+
+        case TokenValueType::NUM:
+        {
+            // num is stored in payload if it fits into it as signed number
+            const int payloadNumMax = (int)(TOKEN_PAYLOAD_MAX >> 1);
+
+            if (-payloadNumMax - 1 <= value.num && value.num <= payloadNumMax)
+            {
+                kind    = TokenKind::NUM;
+                payload = (uint32_t)value.num & TOKEN_PAYLOAD_MAX;
+            }
+            else
+            {
+                kind = TokenKind::BIG_NUM;
+                err  = TokensArrPushBigNum(tokensArr, value.num, &payload);
+
+                IF_ERR_RETURN(err);
+            }
+            break;
+        }
 
-    //-----------------------
+        default:
+            assert(false);
+            break;
+    }
 
-    TokensArrDataFill(tokensArr);
+    tokensArr->kinds    [tokensArr->size] = kind;
+    tokensArr->payloads [tokensArr->size] = payload;
+    tokensArr->positions[tokensArr->size] = (uint32_t)pos;
+    tokensArr->size++;
 
-    ON_CANARY
+    ON_HASH
     (
-        tokensArr->data = GetAfterFirstCanaryAdr(tokensArr);
+        UpdateDataHash(tokensArr);
     )
 
     TOKENS_ARR_CHECK(tokensArr);
 
-    return errors;    
+    return TokensArrErrors::NO_ERR;
 }
-#endif
 
-TokensArrErrors TokensArrDtor(TokensArr* const tokensArr)
+static TokensArrErrors TokensArrPushBigNum(TokensArr* tokensArr, const int value, uint32_t* outPos)
+{
+    assert(tokensArr);
+    assert(outPos);
+
+    if (tokensArr->bigNumsSize > TOKEN_PAYLOAD_MAX)
+    {
+        TokensArrPrintError(TokensArrErrors::TOKEN_OUT_OF_RANGE);
+        return TokensArrErrors::TOKEN_OUT_OF_RANGE;
+    }
+
+    if (tokensArr->bigNumsSize == tokensArr->bigNumsCapacity)
+    {
+        size_t capacity = tokensArr->bigNumsCapacity > 0 ? tokensArr->bigNumsCapacity * 2 :
+                                                           STANDARD_CAPACITY;
+
+        int* bigNums = (int*)realloc(tokensArr->bigNums, capacity * sizeof(*bigNums));
+
+        if (bigNums == nullptr)
+        {
+            TokensArrPrintError(TokensArrErrors::MEMORY_ALLOCATION_ERROR);
+            return TokensArrErrors::MEMORY_ALLOCATION_ERROR;
+        }
+
+        tokensArr->bigNums         = bigNums;
+        tokensArr->bigNumsCapacity = capacity;
+    }
+
+    *outPos = (uint32_t)tokensArr->bigNumsSize;
+    tokensArr->bigNums[tokensArr->bigNumsSize++] = value;
+
+    return TokensArrErrors::NO_ERR;
+}
+
+TokensArrErrors TokensArrAppend(TokensArr* tokensArr, const TokensArr* source)
 {
     assert(tokensArr);
+    assert(source);
+    assert(tokensArr->code == source->code);
 
     TOKENS_ARR_CHECK(tokensArr);
-    
-    for (size_t i = 0; i < tokensArr->size; ++i)
+
+    TokensArrErrors err = TokensArrErrors::NO_ERR;
+
+    while (tokensArr->size + source->size > tokensArr->capacity)
+    {
+        err = TokensArrRealloc(tokensArr);
+        IF_ERR_RETURN(err);
+    }
+
+    const size_t bigNumsShift = tokensArr->bigNumsSize;
+
+    for (size_t i = 0; i < source->bigNumsSize; ++i)
     {
-        if (tokensArr->data[i].valueType == TokenValueType::NAME && tokensArr->data[i].value.name)
-            free(tokensArr->data[i].value.name);
+        uint32_t bigNumPos = 0;
 
-        tokensArr->data[i] = TOKENS_ARR_POISON;
+        err = TokensArrPushBigNum(tokensArr, source->bigNums[i], &bigNumPos);
+        IF_ERR_RETURN(err);
     }
 
-    ON_CANARY
-    (
-        tokensArr->data = GetFirstCanaryAdr(tokensArr);
-    )
+    memcpy(tokensArr->kinds     + tokensArr->size, source->kinds,
+           source->size * sizeof(*tokensArr->kinds));
+    memcpy(tokensArr->payloads  + tokensArr->size, source->payloads,
+           source->size * sizeof(*tokensArr->payloads));
+    memcpy(tokensArr->positions + tokensArr->size, source->positions,
+           source->size * sizeof(*tokensArr->positions));
 
-    free(tokensArr->data);
-    tokensArr->data = nullptr;
+    for (size_t i = tokensArr->size; i < tokensArr->size + source->size; ++i)
+        if (tokensArr->kinds[i] == TokenKind::BIG_NUM)
+            tokensArr->payloads[i] += (uint32_t)bigNumsShift;
 
-    tokensArr->size     = 0;
-    tokensArr->capacity = 0;
+    tokensArr->size += source->size;
 
     ON_HASH
     (
-        tokensArr->dataHash = 0;
+        UpdateDataHash(tokensArr);
     )
 
-    ON_CANARY
-    (
-        tokensArr->structCanaryLeft  = 0;
-        tokensArr->structCanaryRight = 0;
-    )
+    TOKENS_ARR_CHECK(tokensArr);
 
     return TokensArrErrors::NO_ERR;
 }
 
-TokensArrErrors TokensArrPush(TokensArr* tokensArr, const ElemType val)
+TokensArrErrors TokensArrDropFront(TokensArr* tokensArr, const size_t count)
 {
     assert(tokensArr);
-    
+    assert(count <= tokensArr->size);
+
     TOKENS_ARR_CHECK(tokensArr);
 
-    TokensArrErrors tokensArrReallocErr = TokensArrErrors::NO_ERR;
-    if (TokensArrIsFull(tokensArr)) tokensArrReallocErr = TokensArrRealloc(tokensArr, true);
+    // big nums are pushed in the order of their tokens, so they are moved to the front too
+    size_t bigNumsSize = 0;
 
-    IF_ERR_RETURN(tokensArrReallocErr);
+    for (size_t i = count; i < tokensArr->size; ++i)
+    {
+        tokensArr->kinds    [i - count] = tokensArr->kinds    [i];
+        tokensArr->payloads [i - count] = tokensArr->payloads [i];
+        tokensArr->positions[i - count] = tokensArr->positions[i];
+
+        if (tokensArr->kinds[i - count] == TokenKind::BIG_NUM)
+        {
+            tokensArr->bigNums[bigNumsSize] = tokensArr->bigNums[tokensArr->payloads[i - count]];
+            tokensArr->payloads[i - count]  = (uint32_t)bigNumsSize++;
+        }
+    }
 
-    tokensArr->data[tokensArr->size++] = val;
+    tokensArr->size       -= count;
+    tokensArr->bigNumsSize = bigNumsSize;
 
     ON_HASH
     (
+        memset(tokensArr->kinds     + tokensArr->size, 0, count * sizeof(*tokensArr->kinds));
+        memset(tokensArr->payloads  + tokensArr->size, 0, count * sizeof(*tokensArr->payloads));
+        memset(tokensArr->positions + tokensArr->size, 0, count * sizeof(*tokensArr->positions));
+
         UpdateDataHash(tokensArr);
-        UpdateStructHash(tokensArr);
     )
 
     TOKENS_ARR_CHECK(tokensArr);
@@ -286,18 +339,130 @@ TokensArrErrors TokensArrPush(TokensArr* tokensArr, const ElemType val)
     return TokensArrErrors::NO_ERR;
 }
 
+//---------------------------------------------------------------------------------------
+
+Token TokensArrGetToken(const TokensArr* tokensArr, const size_t tokenPos)
+{
+    assert(tokensArr);
+    assert(tokenPos < tokensArr->size);
+
+    Token token = {};
+
+    token.kind    = (uint8_t)tokensArr->kinds[tokenPos] & 0xFF;
+    token.payload = tokensArr->payloads [tokenPos] & TOKEN_PAYLOAD_MAX;
+    token.pos     = tokensArr->positions[tokenPos];
+
+    return token;
+}
+
+TokenValue TokensArrGetValue(const TokensArr* tokensArr, const size_t tokenPos)
+{
+    assert(tokensArr);
+    assert(tokenPos < tokensArr->size);
+
+    TokenValue value   = {};
+    uint32_t   payload = tokensArr->payloads[tokenPos];
+
+    switch (tokensArr->kinds[tokenPos])
+    {
+        case TokenKind::NAME:
+            value.symbol = payload;
+            break;
+
+        case TokenKind::NUM:
+            // sign extension of TOKEN_PAYLOAD_BITS bits number
+            value.num = (int)(payload ^ (1u << (TOKEN_PAYLOAD_BITS - 1))) -
+                        (int)(1u << (TOKEN_PAYLOAD_BITS - 1));
+            break;
+
+        case TokenKind::BIG_NUM:
+            assert(payload < tokensArr->bigNumsSize);
+
+            value.num = tokensArr->bigNums[payload];
+            break;
+
+        default:
+            value.langOpId = (LangOpId)tokensArr->kinds[tokenPos];
+            break;
+    }
+
+    return value;
+}
+
+//---------------------------------------------------------------------------------------
+
+size_t TokensArrGetLine(TokensArr* tokensArr, const size_t tokenPos)
+{
+    assert(tokensArr);
+    assert(tokenPos < tokensArr->size);
+
+    if (tokensArr->lineStarts == nullptr &&
+        TokensArrBuildLineStarts(tokensArr) != TokensArrErrors::NO_ERR)
+        return 0;
+
+    uint32_t pos = tokensArr->positions[tokenPos];
+
+    // last line start that is <= pos, lineStarts[0] is always 0
+    size_t left  = 0;
+    size_t right = tokensArr->linesCount;
+
+    while (right - left > 1)
+    {
+        size_t middle = left + (right - left) / 2;
+
+        if (tokensArr->lineStarts[middle] <= pos)
+            left  = middle;
+        else
+            right = middle;
+    }
+
+    return left;
+}
+
+static TokensArrErrors TokensArrBuildLineStarts(TokensArr* tokensArr)
+{
+    assert(tokensArr);
+    assert(tokensArr->code);
+
+    size_t linesCount = 1;
+    for (const char* newLine = strchr(tokensArr->code, '\n'); newLine != nullptr;
+                     newLine = strchr(newLine + 1,     '\n'))
+        linesCount++;
+
+    uint32_t* lineStarts = (uint32_t*)calloc(linesCount, sizeof(*lineStarts));
+
+    if (lineStarts == nullptr)
+    {
+        TokensArrPrintError(TokensArrErrors::MEMORY_ALLOCATION_ERROR);
+        return TokensArrErrors::MEMORY_ALLOCATION_ERROR;
+    }
+
+    size_t line = 1;
+    for (const char* newLine = strchr(tokensArr->code, '\n'); newLine != nullptr;
+                     newLine = strchr(newLine + 1,     '\n'))
+        lineStarts[line++] = (uint32_t)(newLine + 1 - tokensArr->code);
+
+    tokensArr->lineStarts = lineStarts;
+    tokensArr->linesCount = linesCount;
+
+    return TokensArrErrors::NO_ERR;
+}
+
+//---------------------------------------------------------------------------------------
+
 TokensArrErrors TokensArrVerify(TokensArr* tokensArr)
 {
     assert(tokensArr);
 
-    if (tokensArr->data == nullptr)
+    if (tokensArr->kinds == nullptr || tokensArr->payloads == nullptr ||
+        tokensArr->positions == nullptr)
     {
         TokensArrPrintError(TokensArrErrors::TOKENS_ARR_IS_NULLPTR);
         return TokensArrErrors::TOKENS_ARR_IS_NULLPTR;
     }
 
     if (tokensArr->capacity <= 0)
-    {  
+    {
         TokensArrPrintError(TokensArrErrors::CAPACITY_OUT_OF_RANGE);
         return TokensArrErrors::CAPACITY_OUT_OF_RANGE;
     }
@@ -308,35 +473,11 @@ TokensArrErrors TokensArrVerify(TokensArr* tokensArr)
         return TokensArrErrors::SIZE_OUT_OF_RANGE;
     }
 
-    //-----------Canary checking----------
-
-    ON_CANARY
-    (
-        if (*(CanaryType*)(GetFirstCanaryAdr(tokensArr)) != Canary)
-        {
-            TokensArrPrintError(TokensArrErrors::INVALID_CANARY);
-            return TokensArrErrors::INVALID_CANARY;
-        }
-
-        if (*(CanaryType*)(GetSecondCanaryAdr(tokensArr)) != Canary)
-        {
-            TokensArrPrintError(TokensArrErrors::INVALID_CANARY);
-            return TokensArrErrors::INVALID_CANARY;
-        }
-
-        if (tokensArr->structCanaryLeft != Canary)
-        {
-            TokensArrPrintError(TokensArrErrors::INVALID_CANARY);
-            return TokensArrErrors::INVALID_CANARY;
-        }
-
-        if (tokensArr->structCanaryRight != Canary)
-        {
-            TokensArrPrintError(TokensArrErrors::INVALID_CANARY);
-            return TokensArrErrors::INVALID_CANARY;
-        }
-
-    )
+    if (tokensArr->bigNumsSize > tokensArr->bigNumsCapacity)
+    {
+        TokensArrPrintError(TokensArrErrors::SIZE_OUT_OF_RANGE);
+        return TokensArrErrors::SIZE_OUT_OF_RANGE;
+    }
 
     //------------Hash checking----------
 
@@ -349,155 +490,81 @@ TokensArrErrors TokensArrVerify(TokensArr* tokensArr)
         }
     )
 
-    ON_HASH
-    (
-        if (CalcDataHash(tokensArr) != tokensArr->dataHash)
-        {
-            TokensArrPrintError(TokensArrErrors::INVALID_DATA_HASH);
-            return TokensArrErrors::INVALID_DATA_HASH;
-        }
-
-        HashType prevStructHash = tokensArr->structHash;
-        UpdateStructHash(tokensArr);
-
-        if (prevStructHash != tokensArr->structHash)
-        {
-            TokensArrPrintError(TokensArrErrors::INVALID_STRUCT_HASH);
-            tokensArr->structHash = prevStructHash;
-            return TokensArrErrors::INVALID_STRUCT_HASH;
-        }
-    )
-
-
     return TokensArrErrors::NO_ERR;
 }
 
-void TokensArrDump(const TokensArr* tokensArr, const char* const fileName, 
-                                     const char* const funcName,
-                                     const int lineNumber)
+void TokensArrDump(const TokensArr* tokensArr, const char* const fileName,
+                                               const char* const funcName,
+                                               const int lineNumber)
 {
     assert(tokensArr);
     assert(fileName);
     assert(funcName);
     assert(lineNumber > 0);
-    
+
     LOG_BEGIN();
 
     Log("TokensArrDump was called in file %s, function %s, line %d\n", fileName, funcName, lineNumber);
     Log("tokensArr[%p]\n{\n", tokensArr);
     Log("\ttokensArr capacity: %zu, \n"
-        "\ttokensArr size    : %zu,\n",
-        tokensArr->capacity, tokensArr->size);
-    
-    ON_CANARY
-    (
-        Log("\tLeft struct canary : " CanaryTypeFormat ",\n", 
-            tokensArr->structCanaryLeft);
-        Log("\tRight struct canary: " CanaryTypeFormat ",\n", 
-            tokensArr->structCanaryRight);
-
-        Log("\tLeft data canary : " CanaryTypeFormat ",\n", 
-            *(CanaryType*)(GetFirstCanaryAdr(tokensArr)));
-        Log("\tRight data canary: " CanaryTypeFormat ",\n", 
-            *(CanaryType*)(GetSecondCanaryAdr(tokensArr)));
-    )
+        "\ttokensArr size    : %zu,\n"
+        "\tbig nums size     : %zu,\n",
+        tokensArr->capacity, tokensArr->size, tokensArr->bigNumsSize);
 
     ON_HASH
     (
         Log("\tData hash  : %llu\n", tokensArr->dataHash);
-        Log("\tStruct hash: %llu\n", tokensArr->structHash);
     )
 
-    Log("\tdata data[%p]\n\t{\n", tokensArr->data);
+    Log("\tkinds[%p], payloads[%p], positions[%p]\n\t{\n",
+        tokensArr->kinds, tokensArr->payloads, tokensArr->positions);
 
-    /*
-    if (tokensArr->data != nullptr)
+    if (tokensArr->kinds != nullptr && tokensArr->payloads != nullptr &&
+        tokensArr->positions != nullptr)
     {
-        for (size_t i = 0; i < (tokensArr->size < tokensArr->capacity ? tokensArr->size : tokensArr->capacity); ++i)
-        {
-            //Log("\t\t*[%zu] = " ElemTypeFormat, i, tokensArr->data[i]);
-
-            if (Equal(&tokensArr->data[i], &TOKENS_ARR_POISON)) Log(" (TOKENS_ARR_POISON)");
-
-            Log("\n");
-        }
-
-        Log("\t\tNot used values:\n");
-
-        for(size_t i = tokensArr->size; i < tokensArr->capacity; ++i)
-        {
-            //Log("\t\t*[%zu] = " ElemTypeFormat, i, tokensArr->data[i]);
-            
-            //if (Equal(&tokensArr->data[i], &TOKENS_ARR_POISON)) Log(" (TOKENS_ARR_POISON)");
-
-            Log("\n");
-        }
+        for (size_t i = 0; i < (tokensArr->size < tokensArr->capacity ? tokensArr->size :
+                                                                        tokensArr->capacity); ++i)
+            Log("\t\t*[%zu] = kind %d, payload %u, pos %u\n", i, (int)tokensArr->kinds[i],
+                tokensArr->payloads[i], tokensArr->positions[i]);
     }
-    */
 
     Log("\t}\n}\n");
 
     LOG_END();
 }
 
-TokensArrErrors TokensArrRealloc(TokensArr* tokensArr, bool increase)
+static TokensArrErrors TokensArrRealloc(TokensArr* tokensArr)
 {
     assert(tokensArr);
+    assert(tokensArr->capacity > 0);
 
-    TOKENS_ARR_CHECK(tokensArr);
-    
-    if (increase) tokensArr->capacity <<= 1;
-    else          tokensArr->capacity >>= 1;
-
-    if (!increase) 
-        TokensArrFillArray(tokensArr->data + tokensArr->capacity, tokensArr->data + tokensArr->size, TOKENS_ARR_POISON);
-
-    //--------Moves data to the first canary-------
-    ON_CANARY
-    (
-        tokensArr->data = GetFirstCanaryAdr(tokensArr);
-    )
-
-    ElemType* tmpTokensArr = (ElemType*) realloc(tokensArr->data, 
-                                             TokensArrGetSizeForCalloc(tokensArr) * sizeof(*tokensArr->data));
-
-    if (tmpTokensArr == nullptr)
-    {
-        TokensArrPrintError(TokensArrErrors::MEMORY_ALLOCATION_ERROR);
-
-        assert(tokensArr);
-        if (increase) tokensArr->capacity >>= 1;
-        else          tokensArr->capacity <<= 1;
-
-        TOKENS_ARR_CHECK(tokensArr);
-
-        return TokensArrErrors::NO_ERR;
-    }
+    size_t capacity = tokensArr->capacity << 1;
 
-    tokensArr->data = tmpTokensArr;
+    TokenKind* kinds     = (TokenKind*)realloc(tokensArr->kinds,     capacity * sizeof(*kinds));
+    if (kinds     == nullptr) return TokensArrErrors::MEMORY_ALLOCATION_ERROR;
+    tokensArr->kinds = kinds;
 
-    // -------Moving forward after reallocing-------
-    ON_CANARY
-    (
-        tokensArr->data = GetAfterFirstCanaryAdr(tokensArr);
-    )
+    uint32_t*  payloads  = (uint32_t*) realloc(tokensArr->payloads,  capacity * sizeof(*payloads));
+    if (payloads  == nullptr) return TokensArrErrors::MEMORY_ALLOCATION_ERROR;
+    tokensArr->payloads = payloads;
 
-    if (increase)
-        TokensArrFillArray(tokensArr->data + tokensArr->size, tokensArr->data + tokensArr->capacity, TOKENS_ARR_POISON);
+    uint32_t*  positions = (uint32_t*) realloc(tokensArr->positions, capacity * sizeof(*positions));
+    if (positions == nullptr) return TokensArrErrors::MEMORY_ALLOCATION_ERROR;
+    tokensArr->positions = positions;
 
-    // -------Putting canary at the end-----------
-    ON_CANARY
-    (
-        CanaryCtor(GetSecondCanaryAdr(tokensArr));
-    )
+    tokensArr->capacity = capacity;
 
     ON_HASH
     (
+        memset(tokensArr->kinds     + tokensArr->size, 0,
+               (capacity - tokensArr->size) * sizeof(*tokensArr->kinds));
+        memset(tokensArr->payloads  + tokensArr->size, 0,
+               (capacity - tokensArr->size) * sizeof(*tokensArr->payloads));
+        memset(tokensArr->positions + tokensArr->size, 0,
+               (capacity - tokensArr->size) * sizeof(*tokensArr->positions));
+
         UpdateDataHash(tokensArr);
-        UpdateStructHash(tokensArr);
     )
-    
-    TOKENS_ARR_CHECK(tokensArr);
 
     return TokensArrErrors::NO_ERR;
 }
@@ -511,66 +578,9 @@ static inline bool TokensArrIsFull(TokensArr* tokensArr)
     return tokensArr->size >= tokensArr->capacity;
 }
 
-static inline bool TokensArrIsTooBig(TokensArr* tokensArr)
-{
-    assert(tokensArr);
-
-    TOKENS_ARR_CHECK_NO_RETURN(tokensArr);
-
-    return (tokensArr->size * 4 <= tokensArr->capacity) & (tokensArr->capacity > STANDARD_CAPACITY);
-}
-
-static inline ElemType* MovePtr(ElemType* const data, const size_t moveSz, const int times)
-{
-    assert(data);
-    assert(moveSz > 0);
-    
-    return (ElemType*)((char*)data + times * (long long)moveSz);
-}
-
-// NO tokensArr check because doesn't fill hashes
-static void TokensArrDataFill(TokensArr* const tokensArr)
-{
-    assert(tokensArr);
-    assert(tokensArr->data);
-    assert(tokensArr->capacity > 0);
-
-    ON_CANARY
-    (
-        CanaryCtor(tokensArr->data);
-        tokensArr->data = GetAfterFirstCanaryAdr(tokensArr);
-    )
-
-    TokensArrFillArray(tokensArr->data, tokensArr->data + tokensArr->capacity, TOKENS_ARR_POISON);
-
-    ON_CANARY
-    (
-        CanaryCtor(GetSecondCanaryAdr(tokensArr));
-        tokensArr->data = GetFirstCanaryAdr(tokensArr);
-    )
-
-    // No tokensArr check because doesn't fill hashes
-}
-
-// no TOKENS_ARR_CHECK because can be used for callocing memory (data could be nullptr at this moment)
-static inline size_t TokensArrGetSizeForCalloc(TokensArr* const tokensArr)
-{
-    assert(tokensArr);
-    assert(tokensArr->capacity > 0);
-
-    ON_CANARY
-    (
-        return tokensArr->capacity + 3 * sizeof(CanaryType) / sizeof(*tokensArr->data);
-    )
-
-    return tokensArr->capacity;
-}
-
 #undef TOKENS_ARR_CHECK
+#undef TOKENS_ARR_CHECK_NO_RETURN
 #undef IF_ERR_RETURN
-#undef GetAfterFirstCanaryAdr
-#undef GetFirstCanaryAdr
-#undef GetSecondCanaryAdr
 
 #define LOG_ERR(X) Log(HTML_RED_HEAD_BEGIN "\n" X "\n" HTML_HEAD_END "\n")
 void TokensArrPrintError(TokensArrErrors error)
@@ -585,23 +595,18 @@ void TokensArrPrintError(TokensArrErrors error)
         case TokensArrErrors::TOKENS_ARR_IS_NULLPTR:
             LOG_ERR("TokensArr is nullptr.\n");
             break;
-        case TokensArrErrors::TOKENS_ARR_EMPTY_ERR:
-            LOG_ERR("Trying to pop from empty tokensArr.\n");
-            break;
         case TokensArrErrors::SIZE_OUT_OF_RANGE:
             LOG_ERR("TokensArr size is out of range.\n");
             break;
+        case TokensArrErrors::TOKEN_OUT_OF_RANGE:
+            LOG_ERR("Token value doesn't fit into the payload.\n");
+            break;
         case TokensArrErrors::MEMORY_ALLOCATION_ERROR:
             LOG_ERR("Couldn't allocate more memory for tokensArr.\n");
             break;
-        case TokensArrErrors::INVALID_CANARY:
-            LOG_ERR("TokensArr canary is invalid.\n");
-            break;
         case TokensArrErrors::INVALID_DATA_HASH:
             LOG_ERR("TokensArr data hash is invalid.\n");
             break;
-        case TokensArrErrors::INVALID_STRUCT_HASH:
-            LOG_ERR("TokensArr struct hash is invalid.\n");
 
         case TokensArrErrors::NO_ERR:
         default:
@@ -610,4 +615,4 @@ void TokensArrPrintError(TokensArrErrors error)
 
     LOG_END();
 }
-#undef PRINT_ERR
+#undef LOG_ERR
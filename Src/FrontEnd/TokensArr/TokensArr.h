@@ -3,33 +3,25 @@
 
 /// @file
 /// @brief Contains functions to work with tokensArr
+/// @details Tokens are stored in structure of arrays form: kinds, payloads and positions
+/// are in separate arrays, so the parser that checks kinds reads dense bytes.
+/// Line numbers aren't stored, they are found by position when needed.
 
 #include <assert.h>
+#include <stdint.h>
 
-#include "TokenTypes.h"
+#include "FrontEnd/LexicalParserTokenType.h"
 #include "HashFuncs.h"
 
-//#define TOKENS_ARR_CANARY_PROTECTION
 //#define TOKENS_ARR_HASH_PROTECTION
 
-#ifdef TOKENS_ARR_CANARY_PROTECTION
-
-    #define ON_CANARY(...) __VA_ARGS__
-    typedef unsigned long long CanaryType;
-
-#else
-    
-    #define ON_CANARY(...)
-
-#endif
-
 #ifdef TOKENS_ARR_HASH_PROTECTION
 
     #define ON_HASH(...) __VA_ARGS__
 
 #else
 
-    #define ON_HASH(...) 
+    #define ON_HASH(...)
 
 #endif
 
@@ -42,104 +34,144 @@ ON_HASH
     typedef HashType HashFuncType(const void* hashingArr, const size_t length, const uint64_t seed);
 )
 
-/// @brief Contains all info about data to use it 
+/// @brief Contains all info about data to use it
 struct TokensArr
 {
-    ON_CANARY
-    (
-        CanaryType structCanaryLeft; ///< left canary for the struct
-    )
+    TokenKind* kinds;       ///< kinds of the tokens
+    uint32_t*  payloads;    ///< Token::payload of the tokens
+    uint32_t*  positions;   ///< Token::pos of the tokens
+
+    size_t size;            ///< pos to push values (actual size of the data at this moment).
+    size_t capacity;        ///< REAL size of the arrays at this moment.
+
+    int*   bigNums;         ///< nums that don't fit into payload
+    size_t bigNumsSize;
+    size_t bigNumsCapacity;
+
+    const char* code;       ///< code the tokens are taken from, is needed to find lines
+    uint32_t*   lineStarts; ///< positions of the lines beginnings, built on the first line request
+    size_t      linesCount;
 
-    ElemType* data;       ///< data with values. Have to be a dynamic array.
-    size_t size;          ///< pos to push/pop values (actual size of the data at this moment).
-    
     ON_HASH
     (
-        
         HashType dataHash;      ///< hash of all elements in data.
 
         HashFuncType* HashFunc; ///< hashing function
-
-        HashType structHash;    ///< hash of all elements in struct.
-    )
-
-    size_t capacity;     ///< REAL size of the data at this moment (calloced more than need at this moment).
-
-    ON_CANARY
-    (
-        CanaryType structCanaryRight; ///< right canary for the struct
     )
 };
 
-/// @brief Errors that can occure while tokensArr is working. 
+/// @brief Errors that can occure while tokensArr is working.
 enum class TokensArrErrors
 {
     NO_ERR,
 
     MEMORY_ALLOCATION_ERROR,
-    TOKENS_ARR_EMPTY_ERR, 
     TOKENS_ARR_IS_NULLPTR,
     CAPACITY_OUT_OF_RANGE,
     SIZE_OUT_OF_RANGE,
-    INVALID_CANARY, 
+    TOKEN_OUT_OF_RANGE,
     INVALID_DATA_HASH,
-    INVALID_STRUCT_HASH,
 };
 
 #ifdef TOKENS_ARR_HASH_PROTECTION
     /// @brief Constructor
-    /// @param [out]stk tokensArr to fill
+    /// @param [out]tokensArr tokensArr to fill
+    /// @param [in]code code the tokens are taken from
     /// @param [in]capacity size to reserve for the tokensArr
     /// @param [in]HashFunc hash function for calculating hash
     /// @return errors that occurred
-    TokensArrErrors TokensArrCtor(TokensArr* const stk, const size_t capacity = 0, 
-                        const HashFuncType HashFunc = TokensArrMurmurHash);
+    TokensArrErrors TokensArrCtor(TokensArr* const tokensArr, const char* code,
+                                  const size_t capacity = 0,
+                                  const HashFuncType HashFunc = TokensArrMurmurHash);
 #else
     /// @brief Constructor
-    /// @param [out]stk tokensArr to fill
+    /// @param [out]tokensArr tokensArr to fill
+    /// @param [in]code code the tokens are taken from
     /// @param [in]capacity size to reserve for the tokensArr
     /// @return errors that occurred
-    TokensArrErrors TokensArrCtor(TokensArr* const stk, const size_t capacity = 0);
+    TokensArrErrors TokensArrCtor(TokensArr* const tokensArr, const char* code,
+                                  const size_t capacity = 0);
 #endif
 
 /// @brief Destructor
-/// @param [out]stk tokensArr to destruct
+/// @param [out]tokensArr tokensArr to destruct
 /// @return errors that occurred
-TokensArrErrors TokensArrDtor(TokensArr* const stk);
+TokensArrErrors TokensArrDtor(TokensArr* const tokensArr);
 
-/// @brief Pushing value to the tokensArr
-/// @param [out]stk tokensArr to push in
-/// @param [in]val  value to push
+/// @brief Packs token and pushes it to the tokensArr
+/// @param [out]tokensArr tokensArr to push in
+/// @param [in]value value of the token
+/// @param [in]valueType type of the value
+/// @param [in]pos position of the token in the code
 /// @return errors that occurred
-TokensArrErrors TokensArrPush(TokensArr* stk, const ElemType val);
+TokensArrErrors TokensArrPush(TokensArr* tokensArr, const TokenValue value,
+                              const TokenValueType valueType, const size_t pos);
+
+/// @brief Appends all tokens of source to the end of tokensArr
+/// @details Both arrays have to be made from the same code
+TokensArrErrors TokensArrAppend(TokensArr* tokensArr, const TokensArr* source);
+
+/// @brief Removes count tokens from the beginning, is used to keep only a window of tokens
+TokensArrErrors TokensArrDropFront(TokensArr* tokensArr, const size_t count);
+
+/// @brief Returns packed token
+Token TokensArrGetToken(const TokensArr* tokensArr, const size_t tokenPos);
+
+/// @brief Unpacks value of the token
+TokenValue TokensArrGetValue(const TokensArr* tokensArr, const size_t tokenPos);
+
+/// @brief Finds line of the token. Line index is built on the first call
+/// @return line number (from 0) or 0 if index couldn't be built
+size_t TokensArrGetLine(TokensArr* tokensArr, const size_t tokenPos);
 
 /// @brief Verifies if tokensArr is used right
-/// @param [in]stk tokensArr to verify
+/// @param [in]tokensArr tokensArr to verify
 /// @return TokensArrErrors in tokensArr
-TokensArrErrors TokensArrVerify(TokensArr* stk);
+TokensArrErrors TokensArrVerify(TokensArr* tokensArr);
 
-/// @brief Prints tokensArr to log-file 
-/// @param [in]stk tokensArr to print out
+/// @brief Prints tokensArr to log-file
+/// @param [in]tokensArr tokensArr to print out
 /// @param [in]fileName __FILE__
 /// @param [in]funcName __func__
 /// @param [in]lineNumber __LINE__
-void TokensArrDump(const TokensArr* stk, const char* const fileName, 
-                                     const char* const funcName,
-                                     const int lineNumber);
+void TokensArrDump(const TokensArr* tokensArr, const char* const fileName,
+                                               const char* const funcName,
+                                               const int lineNumber);
 
 /// @brief Checks if tokensArr is empty
-/// @param [in]stk tokensArr to check 
+/// @param [in]tokensArr tokensArr to check
 /// @return true if tokensArr is empty otherwise false
-static inline bool TokensArrIsEmpty(const TokensArr* stk)
+static inline bool TokensArrIsEmpty(const TokensArr* tokensArr)
+{
+    assert(tokensArr);
+    assert(tokensArr->kinds);
+
+    return tokensArr->size == 0;
+}
+
+static inline TokenKind TokensArrGetKind(const TokensArr* tokensArr, const size_t tokenPos)
 {
-    assert(stk);
-    assert(stk->data);
-    
-    return stk->size == 0;
+    assert(tokensArr);
+    assert(tokenPos < tokensArr->size);
+
+    return tokensArr->kinds[tokenPos];
+}
+
+static inline TokenValueType TokensArrGetValueType(const TokensArr* tokensArr, const size_t tokenPos)
+{
+    return TokenKindGetValueType(TokensArrGetKind(tokensArr, tokenPos));
+}
+
+static inline size_t TokensArrGetPos(const TokensArr* tokensArr, const size_t tokenPos)
+{
+    assert(tokensArr);
+    assert(tokenPos < tokensArr->size);
+
+    return tokensArr->positions[tokenPos];
 }
 
 /// @brief Prints tokensArr error to log file
 /// @param [in]error error to print
 void TokensArrPrintError(TokensArrErrors error);
 
-#endif // TOKENS_ARR_H
\ No newline at end of file
+#endif // TOKENS_ARR_H
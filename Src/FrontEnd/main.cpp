@@ -5,27 +5,44 @@
 #include "Common/Log.h"
 #include "SyntaxParser.h"
 #include "FastInput/InputOutput.h"
+#include "Common/CommandLineArgs.h"
 
 int main(int argc, char* argv[])
 {
     assert(argc > 2);
     LogOpen(argv[0]);
+    TreeDumpPolicyInit(ArgsGetOption(argc, argv, "--dump="));
     setbuf(stdout, nullptr);
 
     FILE* inStream  = fopen(argv[1], "r");
     FILE* outStream = fopen(argv[2], "w");
 
-    char* inputTxt = ReadText(inStream);
+    MappedText inputTxt = {};
+    MappedTextCtor(&inputTxt, inStream);
     
+    // --lex-threads=N lexes the code beforehand on N threads
+    const char* lexThreadsOption = ArgsGetOption(argc, argv, "--lex-threads=");
+    size_t      lexThreadsCount  = lexThreadsOption ? strtoul(lexThreadsOption, nullptr, 10) : 0;
+
+    // --parse-threads=N parses function definitions on N threads
+    const char* parseThreadsOption = ArgsGetOption(argc, argv, "--parse-threads=");
+    size_t      parseThreadsCount  = parseThreadsOption ? strtoul(parseThreadsOption, nullptr, 10) : 0;
+
     SyntaxParserErrors err = SyntaxParserErrors::NO_ERR;
-    Tree ast = CodeParse(inputTxt, &err);
+    Tree ast = parseThreadsCount > 0 ? CodeParseParallel(inputTxt.text, &err, parseThreadsCount) :
+                                       CodeParse        (inputTxt.text, &err, lexThreadsCount);
 
     if (err == SyntaxParserErrors::NO_ERR)
-        TreePrintPrefixFormat(&ast, outStream);
+    {
+        TreeFileFormat outFormat = ArgsHasFlag(argc, argv, "--binary") ? TreeFileFormat::BINARY :
+                                                                          TreeFileFormat::PREFIX;
+        TreePrint(&ast, outStream, outFormat);
+    }
 
-    // TreeGraphicDump(&ast, true);
+    if (err == SyntaxParserErrors::NO_ERR)
+        TreeGraphicDump(&ast, true);
 
-    free(inputTxt);
+    MappedTextDtor(&inputTxt);
     TreeDtor(&ast);
 
     fclose(inStream);
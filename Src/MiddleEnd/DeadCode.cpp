@@ -0,0 +1,501 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "Optimizations.h"
+#include "Tree/DSL.h"
+#include "Tree/TreeVisitor.h"
+
+//---------------------------------------------------------------------------------------
+
+/// @brief Variable of the current function, stale ones (other function stamp) are zeroes
+struct DeadCodeVar
+{
+    size_t function;        ///< stamp of the function the fields are counted for
+    size_t readsCount;      ///< reads outside of the own assignments
+    size_t firstAssign;     ///< list of the assignments, DEAD_CODE_NO_ASSIGN if none
+    bool   hasImpureAssign; ///< assignments are kept, the value is needed for the side effects
+    bool   isQueued;
+};
+
+/// @brief Assignment statement, it is removed by freeing the statement and nulling the link
+struct DeadCodeAssign
+{
+    TreeNode** statementLink;   ///< link to TYPE or ASSIGN in the parent
+    TreeNode*  assign;
+    size_t     next;            ///< next assignment of the same variable
+};
+
+struct DeadCodeState
+{
+    DeadCodeVar*    vars;           ///< indexed by nameId
+    size_t          varsCount;
+    size_t          function;
+
+    DeadCodeAssign* assigns;
+    size_t          assignsSize;
+    size_t          assignsCapacity;
+
+    int*            queue;          ///< variables that are never read
+    size_t          queueSize;
+    size_t          queueCapacity;
+
+    TreeNode**      statementLink;  ///< statement that is visited now
+    int             assignedId;     ///< variable that is assigned now, -1 outside of assignment
+
+    TreeErrors      err;
+};
+
+static const size_t DEAD_CODE_NO_ASSIGN         = SIZE_MAX;
+static const size_t DEAD_CODE_STANDARD_CAPACITY = 64;
+
+static TreeVisitAction DeadCodeRemoveInFunction(TreeNode** link, TreeVisitState* visitState,
+                                                void* context);
+
+static void DeadCodeSweepChain    (TreeNode** link);
+static void DeadCodeSweepStatement(TreeNode** link);
+
+static TreeErrors DeadCodeRemoveStores(TreeNode** body, DeadCodeState* state);
+static void       DeadCodeKillAssign  (DeadCodeState* state, DeadCodeAssign* assign);
+
+static TreeVisitAction DeadCodeCountPre (TreeNode** link, TreeVisitState* visitState,
+                                         void* context);
+static TreeVisitAction DeadCodeCountPost(TreeNode** link, TreeVisitState* visitState,
+                                         void* context);
+static TreeVisitAction DeadCodeForgetRead(const TreeNode* node, TreeConstVisitState* visitState,
+                                          void* context);
+
+static DeadCodeVar* DeadCodeGetVar (DeadCodeState* state, const int nameId);
+static TreeErrors   DeadCodeEnqueue(DeadCodeState* state, const int nameId);
+
+static TreeErrors DeadCodeReserve(void** data, size_t* capacity, const size_t size,
+                                  const size_t elemSize);
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors TreeRemoveDeadCode(Tree* tree)
+{
+    assert(tree);
+    assert(tree->allNamesTable);
+    assert(TreeIsCurrent(tree));
+
+    DeadCodeState state = {};
+    state.varsCount = tree->allNamesTable->size;
+    state.vars      = (DeadCodeVar*)calloc(state.varsCount + 1, sizeof(*state.vars));
+
+    if (state.vars == nullptr)
+        return TreeErrors::MEM_ERR;
+
+    static const TreeVisitor funcsVisitor = { DeadCodeRemoveInFunction, nullptr, nullptr, false };
+
+    TreeErrors err = TreeVisit(&tree->root, &funcsVisitor, &state);
+
+    free(state.vars);
+    free(state.assigns);
+    free(state.queue);
+
+    return err != TreeErrors::NO_ERR ? err : state.err;
+}
+
+// Unreachable code is removed before the reads are counted, so it doesn't keep variables alive.
+// Removed stores leave empty statements and blocks, they are swept after that
+static TreeVisitAction DeadCodeRemoveInFunction(TreeNode** link, TreeVisitState*, void* context)
+{
+    assert(link);
+    assert(context);
+
+    DeadCodeState* state = (DeadCodeState*)context;
+    TreeNode*      node  = *link;
+
+    if (!TreeNodeIsOperation(node, TreeOperationId::FUNC))
+        return TreeVisitAction::CONTINUE;
+
+    assert(IS_NAME(L(node)));
+
+    TreeNode** body = &L(node)->right;
+
+    DeadCodeSweepChain(body);
+
+    state->err = DeadCodeRemoveStores(body, state);
+
+    DeadCodeSweepChain(body);
+
+    return state->err == TreeErrors::NO_ERR ? TreeVisitAction::SKIP_CHILDREN :
+                                              TreeVisitAction::STOP;
+}
+
+//---------------------------------------------------------------------------------------
+
+// Link points to the LINE_END chain, to the single statement (body of IF or WHILE) or to nil.
+// Statement that becomes a chain is spliced into the parent chain
+static void DeadCodeSweepChain(TreeNode** link)
+{
+    assert(link);
+
+    if (*link != nullptr && !TreeNodeIsOperation(*link, TreeOperationId::LINE_END))
+    {
+        DeadCodeSweepStatement(link);
+        return;
+    }
+
+    TreeNode** lineLink = link;
+
+    while (*lineLink != nullptr)
+    {
+        TreeNode* line = *lineLink;
+        assert(TreeNodeIsOperation(line, TreeOperationId::LINE_END));
+
+        DeadCodeSweepStatement(&L(line));
+
+        TreeNode* statement = L(line);
+
+        if (statement == nullptr)
+        {
+            *lineLink = R(line);
+            TreeNodeDtor(line);
+            continue;
+        }
+
+        if (TreeNodeIsOperation(statement, TreeOperationId::LINE_END))
+        {
+            // statements of the block are already swept, only the last one can be RETURN
+            TreeNode* last = statement;
+            while (R(last) != nullptr)
+                last = R(last);
+
+            R(last)   = R(line);
+            *lineLink = statement;
+            TreeNodeDtor(line);
+
+            line = last;
+        }
+
+        // nothing after RETURN is ever run
+        if (TreeNodeIsOperation(L(line), TreeOperationId::RETURN) && R(line) != nullptr)
+        {
+            TreeNodeDeepDtor(R(line));
+            R(line) = nullptr;
+        }
+
+        lineLink = &R(line);
+    }
+}
+
+// Statement can be replaced with nil (removed) or with its body
+static void DeadCodeSweepStatement(TreeNode** link)
+{
+    assert(link);
+
+    TreeNode* node = *link;
+
+    if (node == nullptr || !IS_OP(node))
+        return;
+
+    switch (node->value.operation)
+    {
+        case TreeOperationId::LINE_END:
+        {
+            DeadCodeSweepChain(link);
+            break;
+        }
+
+        case TreeOperationId::IF:
+        {
+            DeadCodeSweepChain(&R(node));
+
+            if (IS_NUM(L(node)))
+            {
+                TreeNode* body = R(node);
+
+                if (L(node)->value.num == 0 && body != nullptr)
+                {
+                    TreeNodeDeepDtor(body);
+                    body = nullptr;
+                }
+
+                *link = body;
+
+                TreeNodeDtor(L(node));
+                TreeNodeDtor(node);
+            }
+            else if (R(node) == nullptr && TreeSubtreeIsPure(L(node)))
+            {
+                *link = nullptr;
+                TreeNodeDeepDtor(node);
+            }
+
+            break;
+        }
+
+        case TreeOperationId::WHILE:
+        {
+            DeadCodeSweepChain(&R(node));
+
+            // loop with constant true condition never ends, it is kept
+            if (IS_NUM(L(node)) && L(node)->value.num == 0)
+            {
+                *link = nullptr;
+                TreeNodeDeepDtor(node);
+            }
+
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+// Reads are counted for the whole function. Variables that are never read are queued,
+// their assignments are removed, reads in the removed values are forgotten and the
+// variables whose reads are gone are queued too
+static TreeErrors DeadCodeRemoveStores(TreeNode** body, DeadCodeState* state)
+{
+    assert(body);
+    assert(state);
+
+    static const TreeVisitor countVisitor = { DeadCodeCountPre, nullptr, DeadCodeCountPost, false };
+
+    state->function++;
+    state->assignsSize   = 0;
+    state->queueSize     = 0;
+    state->statementLink = body;
+    state->assignedId    = -1;
+
+    TreeErrors err = TreeVisit(body, &countVisitor, state);
+    if (err != TreeErrors::NO_ERR || state->err != TreeErrors::NO_ERR)
+        return err != TreeErrors::NO_ERR ? err : state->err;
+
+    for (size_t i = 0; i < state->assignsSize; ++i)
+    {
+        const int nameId = L(state->assigns[i].assign)->value.nameId;
+
+        if (DeadCodeGetVar(state, nameId)->readsCount == 0)
+        {
+            err = DeadCodeEnqueue(state, nameId);
+            if (err != TreeErrors::NO_ERR)
+                return err;
+        }
+    }
+
+    // queue grows while it is processed, so it is walked by index
+    for (size_t i = 0; i < state->queueSize && state->err == TreeErrors::NO_ERR; ++i)
+    {
+        DeadCodeVar* var = DeadCodeGetVar(state, state->queue[i]);
+
+        if (var->hasImpureAssign)
+            continue;
+
+        for (size_t assign = var->firstAssign; assign != DEAD_CODE_NO_ASSIGN;
+             assign = state->assigns[assign].next)
+            DeadCodeKillAssign(state, &state->assigns[assign]);
+    }
+
+    return state->err;
+}
+
+static void DeadCodeKillAssign(DeadCodeState* state, DeadCodeAssign* assign)
+{
+    assert(state);
+    assert(assign);
+
+    static const TreeConstVisitor forgetVisitor = { DeadCodeForgetRead, nullptr, nullptr, false };
+
+    state->assignedId = L(assign->assign)->value.nameId;
+
+    TreeErrors err = TreeVisit(R(assign->assign), &forgetVisitor, state);
+    if (err != TreeErrors::NO_ERR)
+        state->err = err;
+
+    state->assignedId = -1;
+
+    TreeNodeDeepDtor(*assign->statementLink);
+    *assign->statementLink = nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+
+static TreeVisitAction DeadCodeCountPre(TreeNode** link, TreeVisitState* visitState,
+                                        void* context)
+{
+    assert(link);
+    assert(visitState);
+    assert(context);
+
+    DeadCodeState* state = (DeadCodeState*)context;
+    TreeNode*      node  = *link;
+
+    if (IS_NAME(node))
+    {
+        // variable isn't kept alive by its own assignments like x == x - 1
+        if (node->value.nameId != state->assignedId)
+            DeadCodeGetVar(state, node->value.nameId)->readsCount++;
+
+        return TreeVisitAction::SKIP_CHILDREN;
+    }
+
+    if (!IS_OP(node))
+        return TreeVisitAction::SKIP_CHILDREN;
+
+    switch (node->value.operation)
+    {
+        case TreeOperationId::LINE_END:
+        {
+            state->statementLink = &L(node);
+            break;
+        }
+
+        case TreeOperationId::IF:
+        case TreeOperationId::WHILE:
+        {
+            state->statementLink = &R(node);
+            break;
+        }
+
+        case TreeOperationId::FUNC_CALL:
+        {
+            TreeVisitSetChildren(visitState, &L(node)->left, nullptr);
+            break;
+        }
+
+        case TreeOperationId::ASSIGN:
+        {
+            assert(IS_NAME(L(node)));
+            assert(*state->statementLink == node ||
+                   (TreeNodeIsOperation(*state->statementLink, TreeOperationId::TYPE) &&
+                    (*state->statementLink)->right == node));
+
+            const int    nameId = L(node)->value.nameId;
+            DeadCodeVar* var    = DeadCodeGetVar(state, nameId);
+
+            if (var == nullptr)
+                return TreeVisitAction::SKIP_CHILDREN;
+
+            state->err = DeadCodeReserve((void**)&state->assigns, &state->assignsCapacity,
+                                         state->assignsSize + 1, sizeof(*state->assigns));
+            if (state->err != TreeErrors::NO_ERR)
+                return TreeVisitAction::STOP;
+
+            state->assigns[state->assignsSize] = { state->statementLink, node, var->firstAssign };
+            var->firstAssign = state->assignsSize++;
+
+            if (!TreeSubtreeIsPure(R(node)))
+                var->hasImpureAssign = true;
+
+            state->assignedId = nameId;
+
+            TreeVisitSetChildren(visitState, nullptr, &R(node));
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return TreeVisitAction::CONTINUE;
+}
+
+static TreeVisitAction DeadCodeCountPost(TreeNode** link, TreeVisitState*, void* context)
+{
+    assert(link);
+    assert(context);
+
+    if (TreeNodeIsOperation(*link, TreeOperationId::ASSIGN))
+        ((DeadCodeState*)context)->assignedId = -1;
+
+    return TreeVisitAction::CONTINUE;
+}
+
+static TreeVisitAction DeadCodeForgetRead(const TreeNode* node, TreeConstVisitState* visitState,
+                                          void* context)
+{
+    assert(node);
+    assert(visitState);
+    assert(context);
+
+    DeadCodeState* state = (DeadCodeState*)context;
+
+    if (TreeNodeIsOperation(node, TreeOperationId::FUNC_CALL))
+        TreeVisitSetChildren(visitState, L(node)->left, nullptr);
+
+    if (!IS_NAME(node) || node->value.nameId == state->assignedId)
+        return TreeVisitAction::CONTINUE;
+
+    DeadCodeVar* var = DeadCodeGetVar(state, node->value.nameId);
+
+    if (var == nullptr)
+        return TreeVisitAction::SKIP_CHILDREN;
+
+    assert(var->readsCount > 0);
+
+    if (--var->readsCount == 0 && var->firstAssign != DEAD_CODE_NO_ASSIGN)
+    {
+        state->err = DeadCodeEnqueue(state, node->value.nameId);
+        if (state->err != TreeErrors::NO_ERR)
+            return TreeVisitAction::STOP;
+    }
+
+    return TreeVisitAction::SKIP_CHILDREN;
+}
+
+//---------------------------------------------------------------------------------------
+
+static DeadCodeVar* DeadCodeGetVar(DeadCodeState* state, const int nameId)
+{
+    assert(state);
+
+    if (nameId < 0 || (size_t)nameId >= state->varsCount)
+        return nullptr;
+
+    DeadCodeVar* var = &state->vars[nameId];
+
+    if (var->function != state->function)
+        *var = { state->function, 0, DEAD_CODE_NO_ASSIGN, false, false };
+
+    return var;
+}
+
+static TreeErrors DeadCodeEnqueue(DeadCodeState* state, const int nameId)
+{
+    assert(state);
+
+    DeadCodeVar* var = DeadCodeGetVar(state, nameId);
+
+    if (var == nullptr || var->isQueued)
+        return TreeErrors::NO_ERR;
+
+    TreeErrors err = DeadCodeReserve((void**)&state->queue, &state->queueCapacity,
+                                     state->queueSize + 1, sizeof(*state->queue));
+    if (err != TreeErrors::NO_ERR)
+        return err;
+
+    var->isQueued = true;
+    state->queue[state->queueSize++] = nameId;
+
+    return TreeErrors::NO_ERR;
+}
+
+static TreeErrors DeadCodeReserve(void** data, size_t* capacity, const size_t size,
+                                  const size_t elemSize)
+{
+    assert(data);
+    assert(capacity);
+
+    if (size <= *capacity)
+        return TreeErrors::NO_ERR;
+
+    size_t newCapacity = *capacity > 0 ? 2 * *capacity : DEAD_CODE_STANDARD_CAPACITY;
+    while (newCapacity < size)
+        newCapacity *= 2;
+
+    void* newData = realloc(*data, newCapacity * elemSize);
+    if (newData == nullptr)
+        return TreeErrors::MEM_ERR;
+
+    *data     = newData;
+    *capacity = newCapacity;
+
+    return TreeErrors::NO_ERR;
+}
@@ -0,0 +1,706 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "Optimizations.h"
+#include "Tree/DSL.h"
+#include "Tree/TreeVisitor.h"
+
+//---------------------------------------------------------------------------------------
+
+/// @brief New name of the callee variable in the current copy, stale ones (other stamp) are unset
+struct InlineRename
+{
+    size_t stamp;
+    int    nameId;
+};
+
+/// @brief What is known about the callee body, counting stops as soon as it can't be inlined
+struct InlineCallee
+{
+    int    nameId;
+    size_t sizeLimit;
+
+    size_t size;
+    size_t returnsCount;
+    size_t loopsDepth;
+
+    bool   canBeInlined;
+};
+
+/// @brief Variables that take the place of RETURNs in the copy of the callee
+struct InlineResult
+{
+    int resultId;
+    int doneId;     ///< is set when the callee has returned, -1 if there is only one RETURN
+};
+
+struct InlineState
+{
+    Tree*         tree;
+    size_t        sizeLimit;
+
+    TreeNode**    funcs;            ///< FUNC nodes indexed by nameId of the function
+    size_t        funcsCount;
+
+    InlineRename* renames;          ///< indexed by nameId, grows with the names table
+    size_t        renamesCount;
+    size_t        stamp;
+    const char*   calleeName;
+
+    TreeUniqueNames uniqueNames;
+
+    bool*         impureBefore;     ///< side effects before the calls that are being visited
+    size_t        impureBeforeSize;
+    size_t        impureBeforeCapacity;
+    bool          impureSeen;       ///< side effects in the statement so far
+
+    TreeNode*     hoisted;          ///< copies of the callees to put before the statement
+    TreeNode**    hoistedEnd;
+
+    TreeErrors    err;
+};
+
+static const size_t INLINE_STANDARD_CAPACITY = 64;
+
+// constant argument is folded into the copy, so the callee may be bigger
+static const size_t INLINE_CONST_ARG_BONUS   = 8;
+
+static TreeVisitAction InlineCollectFunction(TreeNode** link, TreeVisitState* visitState,
+                                             void* context);
+static TreeVisitAction InlineInFunction     (TreeNode** link, TreeVisitState* visitState,
+                                             void* context);
+
+static TreeErrors InlineInChain     (TreeNode** link, InlineState* state);
+static TreeErrors InlineInLine      (TreeNode** lineLink, InlineState* state);
+static TreeErrors InlineInExpression(TreeNode** link, InlineState* state);
+
+static TreeVisitAction InlineVisitPre (TreeNode** link, TreeVisitState* visitState,
+                                       void* context);
+static TreeVisitAction InlineVisitPost(TreeNode** link, TreeVisitState* visitState,
+                                       void* context);
+
+static TreeErrors InlineCall(TreeNode** link, InlineState* state, bool* isInlined);
+
+static bool            InlineCalleeCheck    (const TreeNode* calleeName, InlineCallee* callee);
+static TreeVisitAction InlineCalleeVisitPre (const TreeNode* node,
+                                             TreeConstVisitState* visitState, void* context);
+static TreeVisitAction InlineCalleeVisitPost(const TreeNode* node,
+                                             TreeConstVisitState* visitState, void* context);
+
+static int             InlineRenameGet  (InlineState* state, const int nameId);
+static TreeVisitAction InlineRenameVisit(TreeNode** link, TreeVisitState* visitState,
+                                         void* context);
+
+static bool InlineReturns(TreeNode** link, const InlineResult* result, const bool isFollowed);
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors TreeInlineCalls(Tree* tree, const size_t sizeLimit)
+{
+    assert(tree);
+    assert(tree->allNamesTable);
+    assert(TreeIsCurrent(tree));
+
+    if (sizeLimit == 0)
+        return TreeErrors::NO_ERR;
+
+    InlineState state = {};
+    state.tree        = tree;
+    state.sizeLimit   = sizeLimit;
+    state.funcsCount  = tree->allNamesTable->size;
+    state.funcs       = (TreeNode**)calloc(state.funcsCount + 1, sizeof(*state.funcs));
+
+    if (state.funcs == nullptr)
+        return TreeErrors::MEM_ERR;
+
+    static const TreeVisitor collectVisitor = { InlineCollectFunction, nullptr, nullptr, false };
+    static const TreeVisitor funcsVisitor   = { InlineInFunction,      nullptr, nullptr, false };
+
+    TreeErrors err = TreeVisit(&tree->root, &collectVisitor, &state);
+
+    if (err == TreeErrors::NO_ERR)
+        err = TreeVisit(&tree->root, &funcsVisitor, &state);
+
+    free(state.funcs);
+    free(state.renames);
+    free(state.impureBefore);
+    TreeUniqueNamesDtor(&state.uniqueNames);
+
+    return err != TreeErrors::NO_ERR ? err : state.err;
+}
+
+static TreeVisitAction InlineCollectFunction(TreeNode** link, TreeVisitState*, void* context)
+{
+    assert(link);
+    assert(context);
+
+    InlineState* state = (InlineState*)context;
+    TreeNode*    node  = *link;
+
+    if (!TreeNodeIsOperation(node, TreeOperationId::FUNC))
+        return TreeVisitAction::CONTINUE;
+
+    assert(IS_NAME(L(node)));
+
+    const int nameId = L(node)->value.nameId;
+
+    assert(nameId >= 0 && (size_t)nameId < state->funcsCount);
+    state->funcs[nameId] = node;
+
+    return TreeVisitAction::SKIP_CHILDREN;
+}
+
+// Functions are handled in the order of the tree, so the callee may already have its own
+// calls inlined. Copies are never looked at again, mutually recursive functions can't
+// be unrolled endlessly
+static TreeVisitAction InlineInFunction(TreeNode** link, TreeVisitState*, void* context)
+{
+    assert(link);
+    assert(context);
+
+    InlineState* state = (InlineState*)context;
+    TreeNode*    node  = *link;
+
+    if (!TreeNodeIsOperation(node, TreeOperationId::FUNC))
+        return TreeVisitAction::CONTINUE;
+
+    assert(IS_NAME(L(node)));
+
+    state->err = InlineInChain(&L(node)->right, state);
+
+    return state->err == TreeErrors::NO_ERR ? TreeVisitAction::SKIP_CHILDREN :
+                                              TreeVisitAction::STOP;
+}
+
+//---------------------------------------------------------------------------------------
+
+static TreeErrors InlineInChain(TreeNode** link, InlineState* state)
+{
+    assert(link);
+    assert(state);
+
+    if (*link == nullptr)
+        return TreeErrors::NO_ERR;
+
+    // copies are put before the statement, so the single statement becomes the chain
+    if (!TreeNodeIsOperation(*link, TreeOperationId::LINE_END))
+        *link = CREATE_LINE_END_NODE(*link);
+
+    TreeNode** lineLink = link;
+
+    while (*lineLink != nullptr)
+    {
+        TreeNode* line = *lineLink;
+        assert(TreeNodeIsOperation(line, TreeOperationId::LINE_END));
+
+        TreeErrors err = InlineInLine(lineLink, state);
+        if (err != TreeErrors::NO_ERR)
+            return err;
+
+        lineLink = &line->right;
+    }
+
+    return TreeErrors::NO_ERR;
+}
+
+// Calls are replaced in the expression of the statement, copies of their callees are put
+// before it. Condition of WHILE is evaluated on every iteration, so calls in it are kept
+static TreeErrors InlineInLine(TreeNode** lineLink, InlineState* state)
+{
+    assert(lineLink);
+    assert(state);
+
+    TreeNode* line      = *lineLink;
+    TreeNode* statement = L(line);
+
+    if (statement == nullptr)
+        return TreeErrors::NO_ERR;
+
+    if (TreeNodeIsOperation(statement, TreeOperationId::TYPE))
+        statement = R(statement);
+
+    TreeNode** expression = nullptr;
+    TreeNode** body       = nullptr;
+
+    if (TreeNodeIsOperation(statement, TreeOperationId::ASSIGN))
+        expression = &statement->right;
+    else if (TreeNodeIsOperation(statement, TreeOperationId::RETURN))
+        expression = &statement->left;
+    else if (TreeNodeIsOperation(statement, TreeOperationId::IF))
+    {
+        expression = &statement->left;
+        body       = &statement->right;
+    }
+    else if (TreeNodeIsOperation(statement, TreeOperationId::WHILE))
+        body = &statement->right;
+    else if (TreeNodeIsOperation(statement, TreeOperationId::LINE_END))
+        body = &line->left;
+
+    TreeErrors err = TreeErrors::NO_ERR;
+
+    if (expression != nullptr)
+    {
+        state->hoisted          = nullptr;
+        state->hoistedEnd       = &state->hoisted;
+        state->impureSeen       = false;
+        state->impureBeforeSize = 0;
+
+        err = InlineInExpression(expression, state);
+
+        // calls are replaced already, so the copies are put even on the error
+        if (state->hoisted != nullptr)
+        {
+            *state->hoistedEnd = line;
+            *lineLink          = state->hoisted;
+        }
+    }
+
+    if (err == TreeErrors::NO_ERR && body != nullptr)
+        err = InlineInChain(body, state);
+
+    return err;
+}
+
+static TreeErrors InlineInExpression(TreeNode** link, InlineState* state)
+{
+    assert(link);
+    assert(state);
+
+    static const TreeVisitor callsVisitor = { InlineVisitPre, nullptr, InlineVisitPost, false };
+
+    state->err = TreeErrors::NO_ERR;
+
+    TreeErrors err = TreeVisit(link, &callsVisitor, state);
+
+    return err != TreeErrors::NO_ERR ? err : state->err;
+}
+
+// Calls are visited in the order of evaluation: arguments before the call, left operand
+// before the right one, but the last argument before the first one, as the backend pushes
+// them. Copy of the callee runs before the whole statement, so the call is inlined only if
+// nothing before it has side effects
+static TreeVisitAction InlineVisitPre(TreeNode** link, TreeVisitState* visitState, void* context)
+{
+    assert(link);
+    assert(context);
+
+    InlineState* state = (InlineState*)context;
+    TreeNode*    node  = *link;
+
+    if (TreeNodeIsOperation(node, TreeOperationId::COMMA))
+        return TreeVisitAction::REVERSE_CHILDREN;
+
+    if (!TreeNodeIsOperation(node, TreeOperationId::FUNC_CALL))
+        return TreeVisitAction::CONTINUE;
+
+    if (state->impureBeforeSize == state->impureBeforeCapacity)
+    {
+        const size_t newCapacity = state->impureBeforeCapacity > 0 ?
+                                   2 * state->impureBeforeCapacity : INLINE_STANDARD_CAPACITY;
+
+        bool* newImpureBefore = (bool*)realloc(state->impureBefore,
+                                               newCapacity * sizeof(*newImpureBefore));
+        if (newImpureBefore == nullptr)
+        {
+            state->err = TreeErrors::MEM_ERR;
+            return TreeVisitAction::STOP;
+        }
+
+        state->impureBefore         = newImpureBefore;
+        state->impureBeforeCapacity = newCapacity;
+    }
+
+    state->impureBefore[state->impureBeforeSize++] = state->impureSeen;
+
+    TreeVisitSetChildren(visitState, &L(node)->left, nullptr);
+
+    return TreeVisitAction::CONTINUE;
+}
+
+static TreeVisitAction InlineVisitPost(TreeNode** link, TreeVisitState*, void* context)
+{
+    assert(link);
+    assert(context);
+
+    InlineState* state = (InlineState*)context;
+    TreeNode*    node  = *link;
+
+    if (TreeNodeIsOperation(node, TreeOperationId::READ))
+        state->impureSeen = true;
+
+    if (!TreeNodeIsOperation(node, TreeOperationId::FUNC_CALL))
+        return TreeVisitAction::CONTINUE;
+
+    assert(state->impureBeforeSize > 0);
+
+    const bool impureBefore = state->impureBefore[--state->impureBeforeSize];
+    bool       isInlined    = false;
+
+    if (!impureBefore)
+        state->err = InlineCall(link, state, &isInlined);
+
+    // arguments of the inlined call are evaluated in the copy, before the rest of the statement
+    state->impureSeen = !isInlined;
+
+    return state->err == TreeErrors::NO_ERR ? TreeVisitAction::CONTINUE :
+                                              TreeVisitAction::STOP;
+}
+
+//---------------------------------------------------------------------------------------
+
+// Everything that can fail is done before the tree is changed, the call is left as is on
+// the error. The copy is the parameters declared with the arguments and the renamed body,
+// its RETURNs assign the result variable that replaces the call
+static TreeErrors InlineCall(TreeNode** link, InlineState* state, bool* isInlined)
+{
+    assert(link);
+    assert(state);
+    assert(isInlined);
+
+    TreeNode* call     = *link;
+    TreeNode* callName = L(call);
+    assert(IS_NAME(callName));
+
+    const int calleeId = callName->value.nameId;
+
+    if (calleeId < 0 || (size_t)calleeId >= state->funcsCount ||
+        state->funcs[calleeId] == nullptr)
+        return TreeErrors::NO_ERR;
+
+    TreeNode*    calleeName = L(state->funcs[calleeId]);
+    TreeNodeList params     = {};
+    TreeNodeList args       = {};
+
+    TreeErrors err = TreeCommaChainGather(&calleeName->left, &params);
+
+    if (err == TreeErrors::NO_ERR)
+        err = TreeCommaChainGather(&callName->left, &args);
+
+    InlineCallee callee = {};
+    callee.nameId       = calleeId;
+    callee.sizeLimit    = state->sizeLimit;
+
+    for (size_t i = 0; err == TreeErrors::NO_ERR && i < args.size; ++i)
+    {
+        if (IS_NUM(args.data[i]))
+            callee.sizeLimit += INLINE_CONST_ARG_BONUS;
+    }
+
+    if (err != TreeErrors::NO_ERR || params.size != args.size ||
+        !InlineCalleeCheck(calleeName, &callee))
+    {
+        TreeNodeListDtor(&params);
+        TreeNodeListDtor(&args);
+        return err;
+    }
+
+    state->stamp++;
+    state->calleeName = state->tree->allNamesTable->data[calleeId].name;
+
+    InlineResult result = { -1, -1 };
+    TreeNode*    body   = TreeNodeCopy(calleeName->right);
+
+    if (body == nullptr)
+        err = TreeErrors::MEM_ERR;
+
+    for (size_t i = 0; err == TreeErrors::NO_ERR && i < params.size; ++i)
+    {
+        if (InlineRenameGet(state, TreeParamNameId(params.data[i])) < 0)
+            err = TreeErrors::MEM_ERR;
+    }
+
+    if (err == TreeErrors::NO_ERR)
+    {
+        static const TreeVisitor renameVisitor = { InlineRenameVisit, nullptr, nullptr, false };
+
+        state->err = TreeErrors::NO_ERR;
+
+        err = TreeVisit(&body, &renameVisitor, state);
+        if (err == TreeErrors::NO_ERR)
+            err = state->err;
+    }
+
+    if (err == TreeErrors::NO_ERR)
+    {
+        result.resultId = TreeCreateUniqueName(state->tree, &state->uniqueNames,
+                                               state->calleeName, "result");
+
+        if (callee.returnsCount > 1)
+            result.doneId = TreeCreateUniqueName(state->tree, &state->uniqueNames,
+                                                 state->calleeName, "done");
+
+        if (result.resultId < 0 || (callee.returnsCount > 1 && result.doneId < 0))
+            err = TreeErrors::MEM_ERR;
+    }
+
+    if (err != TreeErrors::NO_ERR)
+    {
+        if (body != nullptr)
+            TreeNodeDeepDtor(body);
+
+        TreeNodeListDtor(&params);
+        TreeNodeListDtor(&args);
+        return err;
+    }
+
+    InlineReturns(&body, &result, false);
+
+    TreeNode** hoistedEnd = state->hoistedEnd;
+
+    // arguments are evaluated in the same order as the call does, from the last one
+    for (size_t i = params.size; i-- > 0; )
+    {
+        const int paramId = InlineRenameGet(state, TreeParamNameId(params.data[i]));
+
+        hoistedEnd = TreeChainAppend(hoistedEnd,
+                            CREATE_TYPE_NODE(CREATE_TYPE_INT_NODE(nullptr),
+                                             CREATE_ASSIGN_NODE(CREATE_VAR(paramId),
+                                                                args.data[i])));
+    }
+
+    if (result.doneId >= 0)
+    {
+        hoistedEnd = TreeChainAppend(hoistedEnd,
+                            CREATE_TYPE_NODE(CREATE_TYPE_INT_NODE(nullptr),
+                                             CREATE_ASSIGN_NODE(CREATE_VAR(result.resultId),
+                                                                CREATE_NUM(0))));
+        hoistedEnd = TreeChainAppend(hoistedEnd,
+                            CREATE_TYPE_NODE(CREATE_TYPE_INT_NODE(nullptr),
+                                             CREATE_ASSIGN_NODE(CREATE_VAR(result.doneId),
+                                                                CREATE_NUM(0))));
+    }
+
+    *hoistedEnd = body;
+    while (*hoistedEnd != nullptr)
+        hoistedEnd = &(*hoistedEnd)->right;
+
+    state->hoistedEnd = hoistedEnd;
+
+    err = TreeCommaChainDtor(&callName->left);
+
+    TreeNodeDtor(callName);
+    TreeNodeDtor(call);
+
+    *link      = CREATE_VAR(result.resultId);
+    *isInlined = true;
+
+    TreeNodeListDtor(&params);
+    TreeNodeListDtor(&args);
+
+    return err;
+}
+
+//---------------------------------------------------------------------------------------
+
+// Callee is inlined if it is small, doesn't call itself and returns at the end of the body.
+// RETURNs in the loops can't be turned into the assignments without breaking the loop
+static bool InlineCalleeCheck(const TreeNode* calleeName, InlineCallee* callee)
+{
+    assert(calleeName);
+    assert(callee);
+
+    const TreeNode* line = calleeName->right;
+
+    while (TreeNodeIsOperation(line, TreeOperationId::LINE_END) &&
+           !TreeNodeIsOperation(line->left, TreeOperationId::RETURN))
+        line = line->right;
+
+    if (!TreeNodeIsOperation(line, TreeOperationId::LINE_END))
+        return false;
+
+    static const TreeConstVisitor calleeVisitor = { InlineCalleeVisitPre, nullptr,
+                                                    InlineCalleeVisitPost, false };
+
+    callee->canBeInlined = true;
+
+    if (TreeVisit(calleeName->right, &calleeVisitor, callee) != TreeErrors::NO_ERR)
+        return false;
+
+    return callee->canBeInlined;
+}
+
+static TreeVisitAction InlineCalleeVisitPre(const TreeNode* node, TreeConstVisitState*,
+                                            void* context)
+{
+    assert(node);
+    assert(context);
+
+    InlineCallee* callee = (InlineCallee*)context;
+
+    callee->size++;
+
+    if (TreeNodeIsOperation(node, TreeOperationId::WHILE))
+        callee->loopsDepth++;
+    else if (TreeNodeIsOperation(node, TreeOperationId::RETURN))
+        callee->returnsCount++;
+
+    if (callee->size > callee->sizeLimit ||
+        (TreeNodeIsOperation(node, TreeOperationId::RETURN) && callee->loopsDepth > 0) ||
+        (TreeNodeIsOperation(node, TreeOperationId::FUNC_CALL) &&
+         node->left->value.nameId == callee->nameId))
+    {
+        callee->canBeInlined = false;
+        return TreeVisitAction::STOP;
+    }
+
+    return TreeVisitAction::CONTINUE;
+}
+
+static TreeVisitAction InlineCalleeVisitPost(const TreeNode* node, TreeConstVisitState*,
+                                             void* context)
+{
+    assert(node);
+    assert(context);
+
+    InlineCallee* callee = (InlineCallee*)context;
+
+    if (TreeNodeIsOperation(node, TreeOperationId::WHILE))
+        callee->loopsDepth--;
+
+    return TreeVisitAction::CONTINUE;
+}
+
+//---------------------------------------------------------------------------------------
+
+// Every variable of the callee gets the new name in every copy, so the copy can't capture
+// the variables of the caller or of the other copies
+static int InlineRenameGet(InlineState* state, const int nameId)
+{
+    assert(state);
+    assert(nameId >= 0);
+
+    if ((size_t)nameId >= state->renamesCount)
+    {
+        const size_t newCount = state->tree->allNamesTable->size + INLINE_STANDARD_CAPACITY;
+
+        InlineRename* newRenames = (InlineRename*)realloc(state->renames,
+                                                          newCount * sizeof(*newRenames));
+        if (newRenames == nullptr)
+            return -1;
+
+        for (size_t i = state->renamesCount; i < newCount; ++i)
+            newRenames[i] = {};
+
+        state->renames      = newRenames;
+        state->renamesCount = newCount;
+    }
+
+    InlineRename* rename = &state->renames[nameId];
+
+    if (rename->stamp != state->stamp)
+    {
+        const int newNameId = TreeCreateUniqueName(state->tree, &state->uniqueNames,
+                                                   state->calleeName,
+                                                   state->tree->allNamesTable->data[nameId].name);
+        if (newNameId < 0)
+            return -1;
+
+        rename->stamp  = state->stamp;
+        rename->nameId = newNameId;
+    }
+
+    return rename->nameId;
+}
+
+static TreeVisitAction InlineRenameVisit(TreeNode** link, TreeVisitState* visitState,
+                                         void* context)
+{
+    assert(link);
+    assert(context);
+
+    InlineState* state = (InlineState*)context;
+    TreeNode*    node  = *link;
+
+    if (TreeNodeIsOperation(node, TreeOperationId::FUNC_CALL))
+    {
+        TreeVisitSetChildren(visitState, &L(node)->left, nullptr);
+        return TreeVisitAction::CONTINUE;
+    }
+
+    if (!IS_NAME(node))
+        return TreeVisitAction::CONTINUE;
+
+    const int newNameId = InlineRenameGet(state, node->value.nameId);
+
+    if (newNameId < 0)
+    {
+        state->err = TreeErrors::MEM_ERR;
+        return TreeVisitAction::STOP;
+    }
+
+    node->value.nameId = newNameId;
+
+    return TreeVisitAction::CONTINUE;
+}
+
+//---------------------------------------------------------------------------------------
+
+// RETURN becomes the assignment of the result, statements after it in its block are cut off.
+// Statements after the block that has returned are put under IF (done == 0). Done is set
+// only if something follows the RETURN
+static bool InlineReturns(TreeNode** link, const InlineResult* result, const bool isFollowed)
+{
+    assert(link);
+    assert(result);
+
+    if (*link == nullptr)
+        return false;
+
+    if (!TreeNodeIsOperation(*link, TreeOperationId::LINE_END))
+        *link = CREATE_LINE_END_NODE(*link);
+
+    for (TreeNode* line = *link; line != nullptr; line = R(line))
+    {
+        TreeNode* statement = L(line);
+
+        if (TreeNodeIsOperation(statement, TreeOperationId::RETURN))
+        {
+            if (R(line) != nullptr)
+            {
+                TreeNodeDeepDtor(R(line));
+                R(line) = nullptr;
+            }
+
+            TreeNode* assign = CREATE_ASSIGN_NODE(CREATE_VAR(result->resultId), L(statement));
+            TreeNodeDtor(statement);
+
+            if (result->doneId < 0)
+            {
+                L(line) = CREATE_TYPE_NODE(CREATE_TYPE_INT_NODE(nullptr), assign);
+                return true;
+            }
+
+            L(line) = assign;
+
+            if (isFollowed)
+                R(line) = CREATE_LINE_END_NODE(CREATE_ASSIGN_NODE(CREATE_VAR(result->doneId),
+                                                                  CREATE_NUM(1)));
+            return true;
+        }
+
+        const bool isBlockFollowed = isFollowed || R(line) != nullptr;
+        bool       hasReturned     = false;
+
+        if (TreeNodeIsOperation(statement, TreeOperationId::IF))
+            hasReturned = InlineReturns(&statement->right, result, isBlockFollowed);
+        else if (TreeNodeIsOperation(statement, TreeOperationId::LINE_END))
+            hasReturned = InlineReturns(&line->left, result, isBlockFollowed);
+
+        if (!hasReturned)
+            continue;
+
+        if (R(line) != nullptr)
+        {
+            TreeNode* guard = CREATE_IF_NODE(CREATE_EQ_NODE(CREATE_VAR(result->doneId),
+                                                            CREATE_NUM(0)),
+                                             R(line));
+            R(line) = CREATE_LINE_END_NODE(guard);
+
+            InlineReturns(&guard->right, result, isFollowed);
+        }
+
+        return true;
+    }
+
+    return false;
+}
@@ -1,7 +1,13 @@
 #include <assert.h>
 #include <math.h>
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "Tree/Tree.h"
+#include "Optimizations.h"
+#include "Tree/TreeVisitor.h"
 #include "Common/DoubleFuncs.h"
 #include "Tree/DSL.h"
 #include "Common/Log.h"
@@ -9,27 +15,55 @@
 //---------------Calculation-------------------
 
 static int TreeCalculate(const TreeNode* node);
+static TreeVisitAction TreeCalculateNode(const TreeNode* node, TreeConstVisitState* state,
+                                         void* context);
 
 static int CalculateUsingOperation(const TreeOperationId operation, 
                                    const int val1, const int val2 = 0);
 
 //--------------------------------Simplify-------------------------------------------
 
-static TreeNode* TreeSimplifyConstants          (TreeNode* node, int* simplifiesCount);
-static TreeNode* TreeSimplifyNeutralNodes       (TreeNode* node, int* simplifiesCount);
-static inline TreeNode* TreeSimplifyAdd         (TreeNode* node, int* simplifiesCount);
-static inline TreeNode* TreeSimplifySub         (TreeNode* node, int* simplifiesCount);
-static inline TreeNode* TreeSimplifyMul         (TreeNode* node, int* simplifiesCount);
-static inline TreeNode* TreeSimplifyDiv         (TreeNode* node, int* simplifiesCount);
-static inline TreeNode* TreeSimplifyPow         (TreeNode* node, int* simplifiesCount);
+static TreeVisitAction TreeSimplifyNode(TreeNode** link, TreeVisitState* state, void* context);
+
+static TreeNode* TreeSimplifyNeutralNode(TreeNode* node, const bool operandsArePure);
+static inline TreeNode* TreeSimplifyAdd (TreeNode* node);
+static inline TreeNode* TreeSimplifySub (TreeNode* node);
+static inline TreeNode* TreeSimplifyMul (TreeNode* node, const bool operandsArePure);
+static inline TreeNode* TreeSimplifyDiv (TreeNode* node, const bool operandsArePure);
+static inline TreeNode* TreeSimplifyPow (TreeNode* node, const bool operandsArePure);
 
 static inline TreeNode* TreeSimplifyReturnLeftNode (TreeNode* node);
 static inline TreeNode* TreeSimplifyReturnRightNode(TreeNode* node);
 static inline TreeNode* TreeSimplifyReturnNumNode(TreeNode* node, int val);
+static inline void      TreeSimplifyDtorOperand  (TreeNode* operand);
+
+//---------------------------------------------------------------------------------------
+
+static inline bool TreeOperationCanBeCalculated(const TreeOperationId operation);
+static inline bool TreeOperationIsDefined      (const TreeOperationId operation,
+                                                const int val1, const int val2);
+static inline bool TreeOperationIsPure         (const TreeOperationId operation);
+static inline bool TreeNodeIsPure              (const TreeNode* node);
+
+static TreeVisitAction TreeNodeCheckPurity(const TreeNode* node, TreeConstVisitState* state,
+                                           void* isPure);
 
 //---------------------------------------------------------------------------------------
 
-static bool TreeNodeCanBeCalculated(const TreeNode* node);
+struct CommaChainGatherContext
+{
+    TreeNodeList* list;
+    TreeErrors    err;
+};
+
+static const size_t NODE_LIST_STANDARD_CAPACITY = 8;
+
+static TreeVisitAction CommaChainGatherItem(TreeNode** link, TreeVisitState* state,
+                                            void* context);
+static TreeVisitAction CommaChainSkipItem  (TreeNode** link, TreeVisitState* state,
+                                            void* context);
+static TreeVisitAction CommaChainDtorComma (TreeNode** link, TreeVisitState* state,
+                                            void* context);
 
 //---------------------------------------------------------------------------------------
 
@@ -41,20 +75,77 @@ int TreeCalculate(const Tree* tree)
     return TreeCalculate(tree->root);
 }
 
+// Values of the calculated subtrees, node takes the values of its children from the top
+struct CalculationStack
+{
+    int*   values;
+    size_t size;
+    size_t capacity;
+};
+
+static const size_t CALCULATION_STACK_STANDARD_CAPACITY = 64;
+
 static int TreeCalculate(const TreeNode* node)
 {
     if (node == nullptr)
         return 0;
-    
+
+    static const TreeConstVisitor calculateVisitor = { nullptr, nullptr, TreeCalculateNode, false };
+
+    CalculationStack stack = {};
+
+    TreeErrors err = TreeVisit(node, &calculateVisitor, &stack);
+
+    int value = 0;
+
+    if (err != TreeErrors::NO_ERR || stack.size != 1)
+        LogError("Can't calculate the tree, not enough memory\n");
+    else
+        value = stack.values[0];
+
+    free(stack.values);
+
+    return value;
+}
+
+static TreeVisitAction TreeCalculateNode(const TreeNode* node, TreeConstVisitState*,
+                                         void* context)
+{
+    assert(node);
+    assert(context);
+
+    CalculationStack* stack = (CalculationStack*)context;
+
+    int value = 0;
+
     if (IS_NUM(node))
-        return node->value.num;
+        value = node->value.num;
+    else
+    {
+        assert(!IS_NAME(node));
 
-    assert(!IS_NAME(node));
+        int secondVal = R(node) ? stack->values[--stack->size] : 0;
+        int firstVal  = L(node) ? stack->values[--stack->size] : 0;
 
-    int firstVal  = TreeCalculate(L(node));
-    int secondVal = TreeCalculate(R(node));
-    
-    return CalculateUsingOperation(node->value.operation, firstVal, secondVal);
+        value = CalculateUsingOperation(node->value.operation, firstVal, secondVal);
+    }
+
+    if (stack->size == stack->capacity)
+    {
+        const size_t newCapacity = stack->capacity > 0 ? 2 * stack->capacity :
+                                                         CALCULATION_STACK_STANDARD_CAPACITY;
+
+        int* newValues = (int*)realloc(stack->values, newCapacity * sizeof(*newValues));
+        if (newValues == nullptr)
+            return TreeVisitAction::STOP;
+
+        stack->values   = newValues;
+        stack->capacity = newCapacity;
+    }
+
+    stack->values[stack->size++] = value;
+
+    return TreeVisitAction::CONTINUE;
 }
 
 static int CalculateUsingOperation(const TreeOperationId operation, 
@@ -89,63 +180,122 @@ static int CalculateUsingOperation(const TreeOperationId operation,
 
 //---------------------------------------------------------------------------------------
 
-void TreeSimplify(Tree* tree)
+// Memo of the simplified subtrees: node takes the flags of its children from the top,
+// so every subtree is looked at once and the whole pass is linear
+struct SimplifyStack
+{
+    bool*  isPure;      ///< subtree has no calls, input and assignments, so it can be thrown away
+    size_t size;
+    size_t capacity;
+};
+
+static const size_t SIMPLIFY_STACK_STANDARD_CAPACITY = 64;
+
+// Expressions are folded before the propagation, so it sees the constants. Expressions that
+// it changes are folded again by it. Loops made of the recursion and inlined copies with
+// constant arguments are propagated too. Dead code is removed last, when the conditions
+// are constant and the copies are replaced. Branches it has taken out of IFs assign
+// constants unconditionally (done flags of the copies), so both run once more
+void TreeSimplify(Tree* tree, const size_t inlineSizeLimit)
 {
     assert(tree);
+    assert(TreeIsCurrent(tree));
+
+    if (TreeSimplifySubtree(&tree->root)        != TreeErrors::NO_ERR ||
+        TreeRemoveTailRecursion(tree)           != TreeErrors::NO_ERR ||
+        TreeInlineCalls(tree, inlineSizeLimit)  != TreeErrors::NO_ERR ||
+        TreePropagateConstants(tree)            != TreeErrors::NO_ERR ||
+        TreeRemoveDeadCode(tree)                != TreeErrors::NO_ERR ||
+        TreePropagateConstants(tree)            != TreeErrors::NO_ERR ||
+        TreeRemoveDeadCode(tree)                != TreeErrors::NO_ERR)
+        LogError("Tree simplification is stopped, not enough memory\n");
+}
 
-    int simplifiesCount = 0;
+TreeErrors TreeSimplifySubtree(TreeNode** link)
+{
+    assert(link);
 
-    do
-    {
-        simplifiesCount = 0;
-        tree->root = TreeSimplifyConstants   (tree->root, &simplifiesCount);
-        tree->root = TreeSimplifyNeutralNodes(tree->root, &simplifiesCount);
-    
-    } while (simplifiesCount != 0);
+    // children are simplified before their parent, so one pass is enough
+    static const TreeVisitor simplifyVisitor = { nullptr, nullptr, TreeSimplifyNode, false };
+
+    SimplifyStack stack = {};
+
+    TreeErrors err = TreeVisit(link, &simplifyVisitor, &stack);
+
+    if (err == TreeErrors::NO_ERR && *link && stack.size != 1)
+        err = TreeErrors::MEM_ERR;
+
+    free(stack.isPure);
+
+    return err;
 }
 
-static TreeNode* TreeSimplifyConstants (TreeNode* node, int* simplifiesCount)
+static TreeVisitAction TreeSimplifyNode(TreeNode** link, TreeVisitState*, void* context)
 {
-    assert(simplifiesCount);
+    assert(link);
+    assert(context);
 
-    if (node == nullptr)
-        return node;
+    SimplifyStack* stack = (SimplifyStack*)context;
+    TreeNode*      node  = *link;
+
+    bool rightIsPure = R(node) ? stack->isPure[--stack->size] : true;
+    bool leftIsPure  = L(node) ? stack->isPure[--stack->size] : true;
+
+    bool isPure = TreeNodeIsPure(node) && leftIsPure && rightIsPure;
+
+    bool canBeCalculated = IS_OP(node) && TreeOperationCanBeCalculated(node->value.operation) &&
+                           (L(node) || R(node))                   &&
+                           (L(node) == nullptr || L_IS_NUM(node)) &&
+                           (R(node) == nullptr || R_IS_NUM(node));
+
+    int firstVal  = canBeCalculated && L(node) ? L_NUM(node) : 0;
+    int secondVal = canBeCalculated && R(node) ? R_NUM(node) : 0;
 
-    if (TreeNodeCanBeCalculated(node) && !IS_NUM(node))
+    // division by zero in the code that is never reached is valid, it is left for the run time
+    if (canBeCalculated && TreeOperationIsDefined(node->value.operation, firstVal, secondVal))
     {
-        TreeNode* numNode = CREATE_NUM(TreeCalculate(node));
-        *simplifiesCount += 1;
+        *link = TreeSimplifyReturnNumNode(node,
+                        CalculateUsingOperation(node->value.operation, firstVal, secondVal));
         TreeNodeDtor(node);
-        return numNode;
     }
+    else
+    {
+        TreeNode* simplified = TreeSimplifyNeutralNode(node, leftIsPure && rightIsPure);
 
-    node->left  = TreeSimplifyConstants(L(node), simplifiesCount);
-    node->right = TreeSimplifyConstants(R(node), simplifiesCount);
+        if (simplified != node)
+        {
+            *link = simplified;
+            TreeNodeDtor(node);
+        }
+    }
 
-    return node;
+    if (stack->size == stack->capacity)
+    {
+        const size_t newCapacity = stack->capacity > 0 ? 2 * stack->capacity :
+                                                         SIMPLIFY_STACK_STANDARD_CAPACITY;
+
+        bool* newIsPure = (bool*)realloc(stack->isPure, newCapacity * sizeof(*newIsPure));
+        if (newIsPure == nullptr)
+            return TreeVisitAction::STOP;
+
+        stack->isPure   = newIsPure;
+        stack->capacity = newCapacity;
+    }
+
+    stack->isPure[stack->size++] = isPure;
+
+    return TreeVisitAction::CONTINUE;
 }
 
-static TreeNode* TreeSimplifyNeutralNodes(TreeNode* node, int* simplifiesCount)
+// Operands that aren't pure are never thrown away, so calls and input are kept
+static TreeNode* TreeSimplifyNeutralNode(TreeNode* node, const bool operandsArePure)
 {
-    if (node == nullptr || !IS_OP(node))
-        return node;
-    
-    TreeNode* left  = TreeSimplifyNeutralNodes(L(node), simplifiesCount);
-    TreeNode* right = TreeSimplifyNeutralNodes(R(node), simplifiesCount);
-    
-    if (L(node) != left)
-    {
-        TreeNodeDtor(L(node));
-        node->left = left;        
-    }
+    assert(node);
 
-    if (R(node) != right)
-    {
-        TreeNodeDtor(R(node));
-        node->right = right;
-    }
+    TreeNode* left  = L(node);
+    TreeNode* right = R(node);
 
-    if (left == nullptr || right == nullptr)
+    if (!IS_OP(node) || left == nullptr || right == nullptr)
         return node;
     
     assert(IS_OP(node));
@@ -162,16 +312,16 @@ static TreeNode* TreeSimplifyNeutralNodes(TreeNode* node, int* simplifiesCount)
     switch (node->value.operation)
     {
         case TreeOperationId::ADD:
-            return TreeSimplifyAdd(node, simplifiesCount);
+            return TreeSimplifyAdd(node);
         case TreeOperationId::SUB:
-            return TreeSimplifySub(node, simplifiesCount);
+            return TreeSimplifySub(node);
         case TreeOperationId::MUL:
-            return TreeSimplifyMul(node, simplifiesCount);
+            return TreeSimplifyMul(node, operandsArePure);
         case TreeOperationId::DIV:
-            return TreeSimplifyDiv(node, simplifiesCount);
+            return TreeSimplifyDiv(node, operandsArePure);
         
         case TreeOperationId::POW:
-            return TreeSimplifyPow(node, simplifiesCount);
+            return TreeSimplifyPow(node, operandsArePure);
 
         default:
             break;
@@ -185,122 +335,83 @@ static TreeNode* TreeSimplifyNeutralNodes(TreeNode* node, int* simplifiesCount)
 #define CHECK()                 \
 do                              \
 {                               \
-    assert(simplifiesCount);    \
     assert(node);              \
     assert(L(node));           \
     assert(R(node));           \
 } while (0)
 
 
-static inline TreeNode* TreeSimplifyAdd(TreeNode* node, int* simplifiesCount)
+static inline TreeNode* TreeSimplifyAdd(TreeNode* node)
 {
     CHECK();
 
     if (R_IS_NUM(node) && DoubleEqual(R_NUM(node), 0))
-    {
-        (*simplifiesCount)++;
         return TreeSimplifyReturnLeftNode(node);
-    }
 
     if (L_IS_NUM(node) && DoubleEqual(L_NUM(node), 0))
-    {
-        (*simplifiesCount)++;
         return TreeSimplifyReturnRightNode(node);
-    }
 
     return node;
 }
 
-static inline TreeNode* TreeSimplifySub(TreeNode* node, int* simplifiesCount)
+static inline TreeNode* TreeSimplifySub(TreeNode* node)
 {
     CHECK();
 
     if (R_IS_NUM(node) && DoubleEqual(R_NUM(node), 0))
-    {    
-        (*simplifiesCount)++;
         return TreeSimplifyReturnLeftNode(node);
-    }
 
     return node;
 }
 
-static inline TreeNode* TreeSimplifyMul(TreeNode* node, int* simplifiesCount)
+static inline TreeNode* TreeSimplifyMul(TreeNode* node, const bool operandsArePure)
 {
     CHECK();
 
-    if (R_IS_NUM(node) && DoubleEqual(R_NUM(node), 0))
-    {
-        (*simplifiesCount)++;
+    if (operandsArePure && R_IS_NUM(node) && DoubleEqual(R_NUM(node), 0))
         return TreeSimplifyReturnNumNode(node, 0);
-    }
 
-    if (L_IS_NUM(node) && DoubleEqual(L_NUM(node), 0))
-    {
-        (*simplifiesCount)++;
+    if (operandsArePure && L_IS_NUM(node) && DoubleEqual(L_NUM(node), 0))
         return TreeSimplifyReturnNumNode(node, 0);
-    }
 
     if (R_IS_NUM(node) && DoubleEqual(R_NUM(node), 1))
-    {
-        (*simplifiesCount)++;
         return TreeSimplifyReturnLeftNode(node);
-    }
 
     if (L_IS_NUM(node) && DoubleEqual(L_NUM(node), 1))
-    {
-        (*simplifiesCount)++;
         return TreeSimplifyReturnRightNode(node);
-    }
 
     return node;
 }
 
-static inline TreeNode* TreeSimplifyDiv(TreeNode* node, int* simplifiesCount)
+static inline TreeNode* TreeSimplifyDiv(TreeNode* node, const bool operandsArePure)
 {
     CHECK();
 
-    if (L_IS_NUM(node) && DoubleEqual(L_NUM(node), 0))
-    {
-        (*simplifiesCount)++;
+    if (operandsArePure && L_IS_NUM(node) && DoubleEqual(L_NUM(node), 0) &&
+        !(R_IS_NUM(node) && DoubleEqual(R_NUM(node), 0)))
         return TreeSimplifyReturnNumNode(node, 0);
-    }
 
     if (R_IS_NUM(node) && DoubleEqual(R_NUM(node), 1))
-    {
-        (*simplifiesCount)++;
         return TreeSimplifyReturnLeftNode(node);
-    }
 
     return node;
 }
 
-static inline TreeNode* TreeSimplifyPow(TreeNode* node, int* simplifiesCount)
+static inline TreeNode* TreeSimplifyPow(TreeNode* node, const bool operandsArePure)
 {
     CHECK();
 
-    if (R_IS_NUM(node) && DoubleEqual(R_NUM(node), 0))
-    {
-        (*simplifiesCount)++;
+    if (operandsArePure && R_IS_NUM(node) && DoubleEqual(R_NUM(node), 0))
         return TreeSimplifyReturnNumNode(node, 1);
-    }
 
-    if (L_IS_NUM(node) && DoubleEqual(L_NUM(node), 0))
-    {
-        (*simplifiesCount)++;
+    if (operandsArePure && L_IS_NUM(node) && DoubleEqual(L_NUM(node), 0))
         return TreeSimplifyReturnNumNode(node, 0);
-    }
 
     if (R_IS_NUM(node) && DoubleEqual(R_NUM(node), 1))
-    {
-        (*simplifiesCount)++;
         return TreeSimplifyReturnLeftNode(node);
-    }
 
-    if (L_IS_NUM(node) && DoubleEqual(L_NUM(node), 1))
-    {
-        (*simplifiesCount)++;
+    if (operandsArePure && L_IS_NUM(node) && DoubleEqual(L_NUM(node), 1))
         return TreeSimplifyReturnNumNode(node, 1);
-    }
 
     return node;
 }
@@ -313,7 +424,7 @@ static inline TreeNode* TreeSimplifyReturnLeftNode(TreeNode* node)
 {
     assert(node);
 
-    TreeNodeDtor(node->right);
+    TreeSimplifyDtorOperand(node->right);
 
     TreeNode* left = L(node);
 
@@ -327,7 +438,7 @@ static inline TreeNode* TreeSimplifyReturnRightNode(TreeNode* node)
 {
     assert(node);
 
-    TreeNodeDtor(node->left);
+    TreeSimplifyDtorOperand(node->left);
 
     TreeNode* right = R(node);
     
@@ -339,8 +450,10 @@ static inline TreeNode* TreeSimplifyReturnRightNode(TreeNode* node)
 
 static inline TreeNode* TreeSimplifyReturnNumNode(TreeNode* node, int value)
 {
-    TreeNodeDtor(R(node));
-    TreeNodeDtor(L(node));
+    assert(node);
+
+    TreeSimplifyDtorOperand(R(node));
+    TreeSimplifyDtorOperand(L(node));
 
     node->left  = nullptr;
     node->right = nullptr;
@@ -348,23 +461,23 @@ static inline TreeNode* TreeSimplifyReturnNumNode(TreeNode* node, int value)
     return CREATE_NUM(value);
 }
 
-//---------------------------------------------------------------------------------------
-
-static bool TreeNodeCanBeCalculated(const TreeNode* node)
+// Leaves are the most common operands, they are freed without the traversal
+static inline void TreeSimplifyDtorOperand(TreeNode* operand)
 {
-    if (node == nullptr)
-        return true;
-    
-    if (IS_NUM(node))
-        return true;
-    
-    if (IS_NAME(node))
-        return false;
+    if (operand == nullptr)
+        return;
 
-    if (IS_STRING_LITERAL(node))
-        return false;
+    if (L(operand) || R(operand))
+        TreeNodeDeepDtor(operand);
+    else
+        TreeNodeDtor(operand);
+}
 
-    switch (node->value.operation)
+//---------------------------------------------------------------------------------------
+
+static inline bool TreeOperationCanBeCalculated(const TreeOperationId operation)
+{
+    switch (operation)
     {
         case TreeOperationId::ADD:
         case TreeOperationId::SUB:
@@ -372,19 +485,276 @@ static bool TreeNodeCanBeCalculated(const TreeNode* node)
         case TreeOperationId::DIV:
         case TreeOperationId::POW:
         case TreeOperationId::SQRT:
-            break;
+        case TreeOperationId::GREATER:
+        case TreeOperationId::GREATER_EQ:
+        case TreeOperationId::LESS:
+        case TreeOperationId::LESS_EQ:
+        case TreeOperationId::EQ:
+        case TreeOperationId::NOT_EQ:
+        case TreeOperationId::AND:
+        case TreeOperationId::OR:
+            return true;
         
         default:
             return false;
-            break;
     }
+}
 
-    bool canBeCalculated  = TreeNodeCanBeCalculated(L(node));
+static inline bool TreeOperationIsDefined(const TreeOperationId operation,
+                                          const int val1, const int val2)
+{
+    switch (operation)
+    {
+        case TreeOperationId::DIV:
+            return val2 != 0;
+        case TreeOperationId::SQRT:
+            return val1 >= 0;
 
-    if (!canBeCalculated)
-        return canBeCalculated;
-    
-    canBeCalculated = TreeNodeCanBeCalculated(R(node));
+        default:
+            return true;
+    }
+}
+
+// Pure operation with pure operands can be thrown away without changing the program
+static inline bool TreeOperationIsPure(const TreeOperationId operation)
+{
+    switch (operation)
+    {
+        case TreeOperationId::SIN:
+        case TreeOperationId::COS:
+        case TreeOperationId::TAN:
+        case TreeOperationId::COT:
+            return true;
+
+        default:
+            return TreeOperationCanBeCalculated(operation);
+    }
+}
+
+// Node itself doesn't call, read or assign, its children aren't looked at
+static inline bool TreeNodeIsPure(const TreeNode* node)
+{
+    assert(node);
+
+    return IS_NUM(node) || IS_STRING_LITERAL(node) ||
+           (IS_NAME(node) && !L(node) && !R(node)) ||
+           (IS_OP(node) && TreeOperationIsPure(node->value.operation));
+}
+
+bool TreeSubtreeIsPure(const TreeNode* node)
+{
+    static const TreeConstVisitor purityVisitor = { TreeNodeCheckPurity, nullptr, nullptr, false };
+
+    bool isPure = true;
+
+    if (TreeVisit(node, &purityVisitor, &isPure) != TreeErrors::NO_ERR)
+        return false;
+
+    return isPure;
+}
+
+static TreeVisitAction TreeNodeCheckPurity(const TreeNode* node, TreeConstVisitState*,
+                                           void* isPure)
+{
+    assert(node);
+    assert(isPure);
+
+    if (TreeNodeIsPure(node))
+        return TreeVisitAction::CONTINUE;
+
+    *(bool*)isPure = false;
+    return TreeVisitAction::STOP;
+}
+
+//---------------------------------------------------------------------------------------
+
+int TreeCreateUniqueName(Tree* tree, TreeUniqueNames* names, const char* base,
+                         const char* suffix)
+{
+    assert(tree);
+    assert(tree->allNamesTable);
+    assert(names);
+    assert(base);
+    assert(suffix);
+
+    static const size_t NAME_NUMBER_MAX_LENGTH = 24;
+
+    const size_t nameCapacity = strlen(base) + strlen(suffix) + NAME_NUMBER_MAX_LENGTH;
+
+    char* name = (char*)calloc(nameCapacity, sizeof(*name));
+    if (name == nullptr)
+        return -1;
+
+    snprintf(name, nameCapacity, "%s_%s", base, suffix);
+
+    const SymbolId prefix = SymbolIntern(name);
+
+    if (prefix != SYMBOL_ID_POISON && prefix >= names->capacity)
+    {
+        const size_t newCapacity = 2 * ((size_t)prefix + 1);
+
+        size_t* newNext = (size_t*)realloc(names->next, newCapacity * sizeof(*newNext));
+
+        if (newNext != nullptr)
+        {
+            for (size_t i = names->capacity; i < newCapacity; ++i)
+                newNext[i] = 0;
+
+            names->next     = newNext;
+            names->capacity = newCapacity;
+        }
+    }
+
+    if (prefix == SYMBOL_ID_POISON || prefix >= names->capacity)
+    {
+        free(name);
+        return -1;
+    }
+
+    // names of the other passes or of the source may take the numbers too, so they are checked
+    Name*  existingName = nullptr;
+    size_t number       = names->next[prefix];
+
+    do
+    {
+        snprintf(name, nameCapacity, "%s_%s_%zu", base, suffix, number++);
+        NameTableFind(tree->allNamesTable, name, &existingName);
+    } while (existingName != nullptr);
+
+    names->next[prefix] = number;
+
+    const SymbolId symbol = SymbolIntern(name);
+
+    free(name);
+
+    if (symbol == SYMBOL_ID_POISON)
+        return -1;
+
+    Name pushName = {};
+    NameCtor(&pushName, symbol, nullptr, 0);
+
+    if (NameTablePush(tree->allNamesTable, pushName) != NameTableErrors::NO_ERR)
+        return -1;
+
+    return (int)tree->allNamesTable->size - 1;
+}
+
+void TreeUniqueNamesDtor(TreeUniqueNames* names)
+{
+    assert(names);
+
+    free(names->next);
+
+    names->next     = nullptr;
+    names->capacity = 0;
+}
+
+//---------------------------------------------------------------------------------------
+
+TreeNode** TreeChainAppend(TreeNode** lineLink, TreeNode* statement)
+{
+    assert(lineLink);
+    assert(*lineLink == nullptr);
+    assert(statement);
+
+    *lineLink = CREATE_LINE_END_NODE(statement);
+
+    return &(*lineLink)->right;
+}
+
+TreeErrors TreeNodeListPush(TreeNodeList* list, TreeNode* node)
+{
+    assert(list);
+    assert(node);
+
+    if (list->size == list->capacity)
+    {
+        const size_t newCapacity = list->capacity > 0 ? 2 * list->capacity :
+                                                        NODE_LIST_STANDARD_CAPACITY;
+
+        TreeNode** newData = (TreeNode**)realloc(list->data, newCapacity * sizeof(*newData));
+        if (newData == nullptr)
+            return TreeErrors::MEM_ERR;
+
+        list->data     = newData;
+        list->capacity = newCapacity;
+    }
+
+    list->data[list->size++] = node;
+
+    return TreeErrors::NO_ERR;
+}
+
+void TreeNodeListDtor(TreeNodeList* list)
+{
+    assert(list);
+
+    free(list->data);
+
+    list->data     = nullptr;
+    list->size     = 0;
+    list->capacity = 0;
+}
+
+TreeErrors TreeCommaChainGather(TreeNode** chain, TreeNodeList* list)
+{
+    assert(chain);
+    assert(list);
+
+    static const TreeVisitor gatherVisitor = { CommaChainGatherItem, nullptr, nullptr, false };
+
+    CommaChainGatherContext context = { list, TreeErrors::NO_ERR };
+
+    TreeErrors err = TreeVisit(chain, &gatherVisitor, &context);
+
+    return err != TreeErrors::NO_ERR ? err : context.err;
+}
+
+TreeErrors TreeCommaChainDtor(TreeNode** chain)
+{
+    assert(chain);
+
+    static const TreeVisitor commasVisitor = { CommaChainSkipItem, nullptr, CommaChainDtorComma,
+                                               false };
+
+    TreeErrors err = TreeVisit(chain, &commasVisitor, nullptr);
+
+    *chain = nullptr;
+
+    return err;
+}
+
+static TreeVisitAction CommaChainGatherItem(TreeNode** link, TreeVisitState*, void* context)
+{
+    assert(link);
+    assert(context);
+
+    CommaChainGatherContext* gatherContext = (CommaChainGatherContext*)context;
+
+    if (TreeNodeIsOperation(*link, TreeOperationId::COMMA))
+        return TreeVisitAction::CONTINUE;
+
+    gatherContext->err = TreeNodeListPush(gatherContext->list, *link);
+
+    return gatherContext->err == TreeErrors::NO_ERR ? TreeVisitAction::SKIP_CHILDREN :
+                                                      TreeVisitAction::STOP;
+}
+
+static TreeVisitAction CommaChainSkipItem(TreeNode** link, TreeVisitState*, void*)
+{
+    assert(link);
+
+    return TreeNodeIsOperation(*link, TreeOperationId::COMMA) ? TreeVisitAction::CONTINUE :
+                                                                 TreeVisitAction::SKIP_CHILDREN;
+}
+
+// Children are freed before their parent, so the link is still valid
+static TreeVisitAction CommaChainDtorComma(TreeNode** link, TreeVisitState*, void*)
+{
+    assert(link);
+
+    if (TreeNodeIsOperation(*link, TreeOperationId::COMMA))
+        TreeNodeDtor(*link);
 
-    return canBeCalculated;
+    return TreeVisitAction::CONTINUE;
 }
@@ -5,6 +5,11 @@
 
 int TreeCalculate(const Tree* tree);
 
-void TreeSimplify(Tree* tree);
+/// @brief Callee bodies of this number of nodes or less are inlined by default
+static const size_t TREE_INLINE_STANDARD_SIZE_LIMIT = 64;
+
+/// @brief Runs all passes of the middle end
+/// @param [in]inlineSizeLimit max callee body size to inline, 0 turns the inlining off
+void TreeSimplify(Tree* tree, const size_t inlineSizeLimit = TREE_INLINE_STANDARD_SIZE_LIMIT);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef OPTIMIZATIONS_H
+#define OPTIMIZATIONS_H
+
+/// @file
+/// @brief Contains passes of the middle end, TreeSimplify runs them one after another
+/// @details Every pass changes the tree in place and returns MEM_ERR if it couldn't finish.
+/// The tree stays valid after the error, it is just simplified less.
+
+#include <assert.h>
+
+#include "Tree/Tree.h"
+
+static inline bool TreeNodeIsOperation(const TreeNode* node, const TreeOperationId operation)
+{
+    return node != nullptr && node->valueType == TreeNodeValueType::OPERATION &&
+           node->value.operation == operation;
+}
+
+/// @brief nameId of the function parameter, it is TYPE(TYPE_INT, NAME) or NAME
+static inline int TreeParamNameId(const TreeNode* param)
+{
+    assert(param);
+
+    if (TreeNodeIsOperation(param, TreeOperationId::TYPE))
+        param = param->right;
+
+    assert(param->valueType == TreeNodeValueType::NAME);
+
+    return param->value.nameId;
+}
+
+/// @brief Puts the statement into the empty end of the LINE_END chain
+/// @return link to the new end of the chain
+TreeNode** TreeChainAppend(TreeNode** lineLink, TreeNode* statement);
+
+/// @brief Nodes gathered by the pass, the array grows on push
+struct TreeNodeList
+{
+    TreeNode** data;
+    size_t     size;
+    size_t     capacity;
+};
+
+TreeErrors TreeNodeListPush(TreeNodeList* list, TreeNode* node);
+
+void TreeNodeListDtor(TreeNodeList* list);
+
+/// @brief Pushes items of the COMMA chain (parameters or arguments) in the source order
+TreeErrors TreeCommaChainGather(TreeNode** chain, TreeNodeList* list);
+
+/// @brief Frees COMMA nodes of the chain, its items have to be moved out or freed after that
+TreeErrors TreeCommaChainDtor(TreeNode** chain);
+
+/// @brief Next numbers of the unique names, indexed by the symbol of "base_suffix"
+/// @details Pass keeps it while it creates names, so every name with the same base and suffix
+/// continues from the last number instead of trying all of them again
+struct TreeUniqueNames
+{
+    size_t* next;
+    size_t  capacity;
+};
+
+void TreeUniqueNamesDtor(TreeUniqueNames* names);
+
+/// @brief Adds the name that isn't used in the tree yet, it is "base_suffix_number"
+/// @return nameId of the new name or -1 if there is no memory
+int TreeCreateUniqueName(Tree* tree, TreeUniqueNames* names, const char* base,
+                         const char* suffix);
+
+/// @brief Folds constants and neutral elements of the subtree in one bottom-up pass
+TreeErrors TreeSimplifySubtree(TreeNode** link);
+
+/// @brief Checks that the subtree has no calls, input and assignments, so it can be thrown away
+bool TreeSubtreeIsPure(const TreeNode* node);
+
+/// @brief Turns the self recursion in the last statement of the function into the loop
+/// @details The last statement has to be RETURN of the self call (tail call) or of the self
+/// call and pure expression joined by +, * or - (call - expression). The latter ones are
+/// gathered in the new accumulator variable, other RETURNs of the function return the
+/// accumulator joined with their values. Arguments are assigned to the parameters through
+/// the new temporary variables, the body is run in WHILE with constant true condition.
+TreeErrors TreeRemoveTailRecursion(Tree* tree);
+
+/// @brief Replaces the calls of small functions with the copies of their bodies
+/// @details Callee is inlined if its body has at most sizeLimit nodes (a bit more for the
+/// constant arguments), it doesn't call itself and has no RETURN in the loops. Its variables
+/// are renamed in every copy. The copy is put before the statement with the call, RETURNs
+/// assign the result variable and the statements after them are skipped with the flag.
+/// Calls after side effects of their statement and in WHILE conditions are kept.
+/// @param [in]sizeLimit 0 turns the inlining off
+TreeErrors TreeInlineCalls(Tree* tree, const size_t sizeLimit);
+
+/// @brief Replaces uses of the variables with their known constant values or with the
+/// variables they are copies of, statement by statement inside every function
+/// @details Facts are merged after IF. Variables assigned in the WHILE body are unknown
+/// in its condition and body and after the loop. Rewritten expressions are simplified.
+TreeErrors TreePropagateConstants(Tree* tree);
+
+/// @brief Removes statements that never run or whose results are never used
+/// @details Statements after RETURN are cut off, IF and WHILE with constant conditions
+/// are replaced with their bodies or removed, assignments to the variables that are never
+/// read are removed if their values have no side effects. Nested blocks are flattened.
+TreeErrors TreeRemoveDeadCode(Tree* tree);
+
+#endif
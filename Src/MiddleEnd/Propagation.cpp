@@ -0,0 +1,479 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "Optimizations.h"
+#include "Tree/DSL.h"
+#include "Tree/TreeVisitor.h"
+
+//---------------------------------------------------------------------------------------
+
+enum class PropagationFactType
+{
+    UNKNOWN,
+    CONST,      ///< variable holds the number
+    COPY,       ///< variable holds the value of the source variable while the source isn't assigned
+};
+
+/// @brief What is known about the variable at the current statement
+struct PropagationFact
+{
+    PropagationFactType type;
+    int                 value;      ///< number for CONST, nameId of the source for COPY
+    size_t              version;    ///< version of the source for COPY
+};
+
+struct PropagationVar
+{
+    PropagationFact fact;
+    size_t          version;        ///< is increased by every assignment, so copies of the var expire
+    size_t          stamp;          ///< var is already collected by the current merge
+};
+
+/// @brief Fact before the change, so the state before the branch can be restored
+struct PropagationTrailEntry
+{
+    int             nameId;
+    PropagationFact fact;
+};
+
+struct PropagationState
+{
+    PropagationVar*        vars;            ///< indexed by nameId
+    size_t                 varsCount;
+
+    PropagationTrailEntry* trail;
+    size_t                 trailSize;
+    size_t                 trailCapacity;
+
+    PropagationTrailEntry* changes;         ///< facts at the end of the branch, is used by merge
+    size_t                 changesCapacity;
+
+    size_t                 stamp;
+
+    TreeErrors             err;
+};
+
+static const size_t PROPAGATION_TRAIL_STANDARD_CAPACITY = 64;
+
+static TreeVisitAction PropagateFunction(TreeNode** link, TreeVisitState* visitState,
+                                         void* context);
+
+static TreeErrors PropagateStatement (TreeNode** link, PropagationState* state);
+static TreeErrors PropagateAssign    (TreeNode*  node, PropagationState* state);
+static TreeErrors PropagateIf        (TreeNode*  node, PropagationState* state);
+static TreeErrors PropagateWhile     (TreeNode*  node, PropagationState* state);
+static TreeErrors PropagatePrint     (TreeNode*  node, PropagationState* state);
+static TreeErrors PropagateExpression(TreeNode** link, PropagationState* state);
+
+static TreeVisitAction PropagateUse         (TreeNode** link, TreeVisitState* visitState,
+                                             void* context);
+static TreeVisitAction PropagateKillAssigned(TreeNode** link, TreeVisitState* visitState,
+                                             void* context);
+
+static PropagationFact PropagationGetFact(const PropagationState* state, const int nameId);
+static TreeErrors      PropagationSetFact(PropagationState* state, const int nameId,
+                                          const PropagationFact fact);
+static TreeErrors      PropagationAssign (PropagationState* state, const int nameId,
+                                          const PropagationFact fact);
+static TreeErrors      PropagationMerge  (PropagationState* state, const size_t trailMark);
+static void            PropagationUndo   (PropagationState* state, const size_t trailMark);
+
+static inline bool PropagationFactsAreEqual(const PropagationFact first,
+                                            const PropagationFact second);
+
+static const PropagationFact PROPAGATION_UNKNOWN_FACT = { PropagationFactType::UNKNOWN, 0, 0 };
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors TreePropagateConstants(Tree* tree)
+{
+    assert(tree);
+    assert(tree->allNamesTable);
+    assert(TreeIsCurrent(tree));
+
+    PropagationState state = {};
+    state.varsCount = tree->allNamesTable->size;
+    state.vars      = (PropagationVar*)calloc(state.varsCount + 1, sizeof(*state.vars));
+
+    if (state.vars == nullptr)
+        return TreeErrors::MEM_ERR;
+
+    static const TreeVisitor funcsVisitor = { PropagateFunction, nullptr, nullptr, false };
+
+    TreeErrors err = TreeVisit(&tree->root, &funcsVisitor, &state);
+
+    free(state.vars);
+    free(state.trail);
+    free(state.changes);
+
+    return err != TreeErrors::NO_ERR ? err : state.err;
+}
+
+// Functions are looked at one by one, nothing is known at the beginning of the function
+static TreeVisitAction PropagateFunction(TreeNode** link, TreeVisitState*, void* context)
+{
+    assert(link);
+    assert(context);
+
+    PropagationState* state = (PropagationState*)context;
+    TreeNode*         node  = *link;
+
+    if (!IS_OP(node) || node->value.operation != TreeOperationId::FUNC)
+        return TreeVisitAction::CONTINUE;
+
+    assert(IS_NAME(L(node)));
+
+    state->err = PropagateStatement(&L(node)->right, state);
+    PropagationUndo(state, 0);
+
+    return state->err == TreeErrors::NO_ERR ? TreeVisitAction::SKIP_CHILDREN :
+                                              TreeVisitAction::STOP;
+}
+
+//---------------------------------------------------------------------------------------
+
+static TreeErrors PropagateStatement(TreeNode** link, PropagationState* state)
+{
+    assert(link);
+    assert(state);
+
+    TreeNode* node = *link;
+
+    if (node == nullptr)
+        return TreeErrors::NO_ERR;
+
+    assert(IS_OP(node));
+
+    switch (node->value.operation)
+    {
+        case TreeOperationId::LINE_END:
+        {
+            // chain is right-deep, so it is walked in the loop
+            for (TreeNode* line = node; line != nullptr; line = R(line))
+            {
+                assert(IS_OP(line) && line->value.operation == TreeOperationId::LINE_END);
+
+                TreeErrors err = PropagateStatement(&L(line), state);
+                if (err != TreeErrors::NO_ERR)
+                    return err;
+            }
+
+            return TreeErrors::NO_ERR;
+        }
+
+        case TreeOperationId::TYPE:
+            return PropagateStatement(&R(node), state);
+
+        case TreeOperationId::ASSIGN:
+            return PropagateAssign(node, state);
+        case TreeOperationId::IF:
+            return PropagateIf(node, state);
+        case TreeOperationId::WHILE:
+            return PropagateWhile(node, state);
+        case TreeOperationId::PRINT:
+            return PropagatePrint(node, state);
+
+        case TreeOperationId::RETURN:
+            return PropagateExpression(&L(node), state);
+
+        default:
+            break;
+    }
+
+    return TreeErrors::NO_ERR;
+}
+
+static TreeErrors PropagateAssign(TreeNode* node, PropagationState* state)
+{
+    assert(node);
+    assert(state);
+    assert(IS_NAME(L(node)));
+
+    TreeErrors err = PropagateExpression(&R(node), state);
+    if (err != TreeErrors::NO_ERR)
+        return err;
+
+    const int       nameId = L(node)->value.nameId;
+    const TreeNode* value  = R(node);
+    PropagationFact fact   = PROPAGATION_UNKNOWN_FACT;
+
+    if (IS_NUM(value))
+        fact = { PropagationFactType::CONST, value->value.num, 0 };
+    else if (IS_NAME(value) && value->value.nameId != nameId &&
+             (size_t)value->value.nameId < state->varsCount)
+        fact = { PropagationFactType::COPY, value->value.nameId,
+                 state->vars[value->value.nameId].version };
+
+    return PropagationAssign(state, nameId, fact);
+}
+
+// Facts that are different at the end of the body and before the IF become unknown.
+// Body under the constant condition is either never run (dead code removes it) or always run
+static TreeErrors PropagateIf(TreeNode* node, PropagationState* state)
+{
+    assert(node);
+    assert(state);
+
+    TreeErrors err = PropagateExpression(&L(node), state);
+    if (err != TreeErrors::NO_ERR)
+        return err;
+
+    if (IS_NUM(L(node)))
+        return L(node)->value.num == 0 ? TreeErrors::NO_ERR : PropagateStatement(&R(node), state);
+
+    const size_t trailMark = state->trailSize;
+
+    err = PropagateStatement(&R(node), state);
+    if (err != TreeErrors::NO_ERR)
+        return err;
+
+    return PropagationMerge(state, trailMark);
+}
+
+// Condition and body see the same facts on every iteration: variables assigned in the body
+// are unknown. Loop is left from its condition, so these facts hold after it too
+static TreeErrors PropagateWhile(TreeNode* node, PropagationState* state)
+{
+    assert(node);
+    assert(state);
+
+    static const TreeVisitor killVisitor = { PropagateKillAssigned, nullptr, nullptr, false };
+
+    TreeErrors err = TreeVisit(&R(node), &killVisitor, state);
+    if (err != TreeErrors::NO_ERR || state->err != TreeErrors::NO_ERR)
+        return err != TreeErrors::NO_ERR ? err : state->err;
+
+    const size_t trailMark = state->trailSize;
+
+    err = PropagateExpression(&L(node), state);
+
+    if (err == TreeErrors::NO_ERR)
+        err = PropagateStatement(&R(node), state);
+
+    PropagationUndo(state, trailMark);
+
+    return err;
+}
+
+// Print takes only an argument, negative numbers are printed as expressions by the
+// back front end, so they aren't put there
+static TreeErrors PropagatePrint(TreeNode* node, PropagationState* state)
+{
+    assert(node);
+    assert(state);
+
+    TreeNode* arg = L(node);
+
+    if (arg == nullptr || !IS_NAME(arg))
+        return TreeErrors::NO_ERR;
+
+    const PropagationFact fact = PropagationGetFact(state, arg->value.nameId);
+
+    if (fact.type == PropagationFactType::CONST && fact.value >= 0)
+    {
+        L(node) = CREATE_NUM(fact.value);
+        TreeNodeDtor(arg);
+    }
+    else if (fact.type == PropagationFactType::COPY)
+        arg->value.nameId = fact.value;
+
+    return TreeErrors::NO_ERR;
+}
+
+static TreeErrors PropagateExpression(TreeNode** link, PropagationState* state)
+{
+    assert(link);
+    assert(state);
+
+    static const TreeVisitor useVisitor = { PropagateUse, nullptr, nullptr, false };
+
+    TreeErrors err = TreeVisit(link, &useVisitor, state);
+    if (err != TreeErrors::NO_ERR)
+        return err;
+
+    return TreeSimplifySubtree(link);
+}
+
+//---------------------------------------------------------------------------------------
+
+static TreeVisitAction PropagateUse(TreeNode** link, TreeVisitState* visitState, void* context)
+{
+    assert(link);
+    assert(visitState);
+    assert(context);
+
+    const PropagationState* state = (const PropagationState*)context;
+    TreeNode*               node  = *link;
+
+    if (IS_NAME(node))
+    {
+        assert(!L(node) && !R(node));
+
+        const PropagationFact fact = PropagationGetFact(state, node->value.nameId);
+
+        if (fact.type == PropagationFactType::CONST)
+        {
+            *link = CREATE_NUM(fact.value);
+            TreeNodeDtor(node);
+        }
+        else if (fact.type == PropagationFactType::COPY)
+            node->value.nameId = fact.value;
+
+        return TreeVisitAction::SKIP_CHILDREN;
+    }
+
+    // name of the called function isn't a variable, only the arguments are looked at
+    if (IS_OP(node) && node->value.operation == TreeOperationId::FUNC_CALL)
+        TreeVisitSetChildren(visitState, &L(node)->left, nullptr);
+
+    return TreeVisitAction::CONTINUE;
+}
+
+static TreeVisitAction PropagateKillAssigned(TreeNode** link, TreeVisitState*, void* context)
+{
+    assert(link);
+    assert(context);
+
+    PropagationState* state = (PropagationState*)context;
+    TreeNode*         node  = *link;
+
+    if (!IS_OP(node))
+        return TreeVisitAction::SKIP_CHILDREN;
+
+    if (node->value.operation != TreeOperationId::ASSIGN)
+        return TreeVisitAction::CONTINUE;
+
+    assert(IS_NAME(L(node)));
+
+    state->err = PropagationAssign(state, L(node)->value.nameId, PROPAGATION_UNKNOWN_FACT);
+
+    return state->err == TreeErrors::NO_ERR ? TreeVisitAction::SKIP_CHILDREN :
+                                              TreeVisitAction::STOP;
+}
+
+//---------------------------------------------------------------------------------------
+
+static PropagationFact PropagationGetFact(const PropagationState* state, const int nameId)
+{
+    assert(state);
+
+    if (nameId < 0 || (size_t)nameId >= state->varsCount)
+        return PROPAGATION_UNKNOWN_FACT;
+
+    const PropagationFact fact = state->vars[nameId].fact;
+
+    if (fact.type == PropagationFactType::COPY && state->vars[fact.value].version != fact.version)
+        return PROPAGATION_UNKNOWN_FACT;
+
+    return fact;
+}
+
+static TreeErrors PropagationSetFact(PropagationState* state, const int nameId,
+                                     const PropagationFact fact)
+{
+    assert(state);
+    assert(nameId >= 0 && (size_t)nameId < state->varsCount);
+
+    if (state->trailSize == state->trailCapacity)
+    {
+        const size_t newCapacity = state->trailCapacity > 0 ? 2 * state->trailCapacity :
+                                                              PROPAGATION_TRAIL_STANDARD_CAPACITY;
+
+        PropagationTrailEntry* newTrail = (PropagationTrailEntry*)realloc(state->trail,
+                                                            newCapacity * sizeof(*newTrail));
+        if (newTrail == nullptr)
+            return TreeErrors::MEM_ERR;
+
+        state->trail         = newTrail;
+        state->trailCapacity = newCapacity;
+    }
+
+    state->trail[state->trailSize++] = { nameId, state->vars[nameId].fact };
+    state->vars[nameId].fact         = fact;
+
+    return TreeErrors::NO_ERR;
+}
+
+static TreeErrors PropagationAssign(PropagationState* state, const int nameId,
+                                    const PropagationFact fact)
+{
+    assert(state);
+
+    if (nameId < 0 || (size_t)nameId >= state->varsCount)
+        return TreeErrors::NO_ERR;
+
+    state->vars[nameId].version++;
+
+    return PropagationSetFact(state, nameId, fact);
+}
+
+static TreeErrors PropagationMerge(PropagationState* state, const size_t trailMark)
+{
+    assert(state);
+    assert(trailMark <= state->trailSize);
+
+    const size_t changesNeeded = state->trailSize - trailMark;
+
+    if (changesNeeded > state->changesCapacity)
+    {
+        PropagationTrailEntry* newChanges = (PropagationTrailEntry*)realloc(state->changes,
+                                                            changesNeeded * sizeof(*newChanges));
+        if (newChanges == nullptr)
+            return TreeErrors::MEM_ERR;
+
+        state->changes         = newChanges;
+        state->changesCapacity = changesNeeded;
+    }
+
+    state->stamp++;
+
+    size_t changesCount = 0;
+    for (size_t i = trailMark; i < state->trailSize; ++i)
+    {
+        PropagationVar* var = &state->vars[state->trail[i].nameId];
+
+        if (var->stamp == state->stamp)
+            continue;
+
+        var->stamp = state->stamp;
+        state->changes[changesCount++] = { state->trail[i].nameId, var->fact };
+    }
+
+    PropagationUndo(state, trailMark);
+
+    for (size_t i = 0; i < changesCount; ++i)
+    {
+        const int nameId = state->changes[i].nameId;
+
+        if (PropagationFactsAreEqual(state->vars[nameId].fact, state->changes[i].fact))
+            continue;
+
+        TreeErrors err = PropagationSetFact(state, nameId, PROPAGATION_UNKNOWN_FACT);
+        if (err != TreeErrors::NO_ERR)
+            return err;
+    }
+
+    return TreeErrors::NO_ERR;
+}
+
+// Versions aren't restored, so the copies made before the undone assignments stay expired
+static void PropagationUndo(PropagationState* state, const size_t trailMark)
+{
+    assert(state);
+    assert(trailMark <= state->trailSize);
+
+    while (state->trailSize > trailMark)
+    {
+        const PropagationTrailEntry* entry = &state->trail[--state->trailSize];
+
+        state->vars[entry->nameId].fact = entry->fact;
+    }
+}
+
+static inline bool PropagationFactsAreEqual(const PropagationFact first,
+                                            const PropagationFact second)
+{
+    return first.type    == second.type  &&
+           first.value   == second.value &&
+           first.version == second.version;
+}
@@ -0,0 +1,366 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "Optimizations.h"
+#include "Tree/DSL.h"
+#include "Tree/TreeVisitor.h"
+
+//---------------------------------------------------------------------------------------
+
+/// @brief Recursive statement RETURN(call) or RETURN(join(call, rest)) at the end of the body
+struct TailRecursionSite
+{
+    TreeNode*       lastLine;
+    TreeNode*       ret;
+    TreeNode*       join;       ///< nullptr for the tail call
+    TreeNode*       call;
+    TreeNode*       rest;       ///< pure operand of the join, nullptr for the tail call
+    TreeOperationId joinOperation;
+};
+
+/// @brief Other RETURNs of the function, they are joined with the accumulator
+struct TailRecursionJoin
+{
+    TreeNodeList returns;
+    int          accId;
+
+    TreeErrors   err;
+};
+
+struct TailRecursionContext
+{
+    Tree*           tree;
+    TreeUniqueNames uniqueNames;
+    TreeErrors      err;
+};
+
+static TreeVisitAction TailRecursionRemoveInFunction(TreeNode** link, TreeVisitState* visitState,
+                                                     void* context);
+
+static TreeErrors TailRecursionRewrite(TailRecursionContext* context, TreeNode* funcName,
+                                       TreeNode** lastLineLink, const TailRecursionSite* site);
+
+static bool TailRecursionFindSite(TreeNode* value, const int funcNameId,
+                                  TailRecursionSite* site);
+
+static inline bool TailRecursionIsSelfCall(const TreeNode* node, const int funcNameId);
+
+static TreeVisitAction TailRecursionGatherReturn(TreeNode** link, TreeVisitState* visitState,
+                                                 void* context);
+
+static void TailRecursionJoinReturns(const TailRecursionJoin* join, const TailRecursionSite* site);
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors TreeRemoveTailRecursion(Tree* tree)
+{
+    assert(tree);
+    assert(tree->allNamesTable);
+    assert(TreeIsCurrent(tree));
+
+    TailRecursionContext context = {};
+    context.tree = tree;
+
+    static const TreeVisitor funcsVisitor = { TailRecursionRemoveInFunction, nullptr, nullptr,
+                                              false };
+
+    TreeErrors err = TreeVisit(&tree->root, &funcsVisitor, &context);
+
+    TreeUniqueNamesDtor(&context.uniqueNames);
+
+    return err != TreeErrors::NO_ERR ? err : context.err;
+}
+
+static TreeVisitAction TailRecursionRemoveInFunction(TreeNode** link, TreeVisitState*,
+                                                     void* context)
+{
+    assert(link);
+    assert(context);
+
+    TailRecursionContext* funcContext = (TailRecursionContext*)context;
+    TreeNode*             node        = *link;
+
+    if (!TreeNodeIsOperation(node, TreeOperationId::FUNC))
+        return TreeVisitAction::CONTINUE;
+
+    TreeNode* funcName = L(node);
+    assert(IS_NAME(funcName));
+
+    if (funcName->right == nullptr)
+        return TreeVisitAction::SKIP_CHILDREN;
+
+    TreeNode** lastLineLink = &funcName->right;
+    while ((*lastLineLink)->right != nullptr)
+        lastLineLink = &(*lastLineLink)->right;
+
+    TailRecursionSite site = {};
+    site.lastLine = *lastLineLink;
+    site.ret      = L(site.lastLine);
+
+    if (!TreeNodeIsOperation(site.ret, TreeOperationId::RETURN) ||
+        !TailRecursionFindSite(L(site.ret), funcName->value.nameId, &site))
+        return TreeVisitAction::SKIP_CHILDREN;
+
+    funcContext->err = TailRecursionRewrite(funcContext, funcName, lastLineLink, &site);
+
+    return funcContext->err == TreeErrors::NO_ERR ? TreeVisitAction::SKIP_CHILDREN :
+                                                    TreeVisitAction::STOP;
+}
+
+//---------------------------------------------------------------------------------------
+
+// call + rest and call * rest are turned around freely, call - rest is the sum of rests
+// subtracted from the base value
+static bool TailRecursionFindSite(TreeNode* value, const int funcNameId,
+                                  TailRecursionSite* site)
+{
+    assert(value);
+    assert(site);
+
+    if (TailRecursionIsSelfCall(value, funcNameId))
+    {
+        site->call = value;
+        return true;
+    }
+
+    if (!IS_OP(value))
+        return false;
+
+    const TreeOperationId operation = value->value.operation;
+
+    if (operation != TreeOperationId::ADD && operation != TreeOperationId::MUL &&
+        operation != TreeOperationId::SUB)
+        return false;
+
+    site->join          = value;
+    site->joinOperation = operation;
+
+    if (TailRecursionIsSelfCall(L(value), funcNameId) && TreeSubtreeIsPure(R(value)))
+    {
+        site->call = L(value);
+        site->rest = R(value);
+        return true;
+    }
+
+    if (operation != TreeOperationId::SUB &&
+        TailRecursionIsSelfCall(R(value), funcNameId) && TreeSubtreeIsPure(L(value)))
+    {
+        site->call = R(value);
+        site->rest = L(value);
+        return true;
+    }
+
+    return false;
+}
+
+static inline bool TailRecursionIsSelfCall(const TreeNode* node, const int funcNameId)
+{
+    return TreeNodeIsOperation(node, TreeOperationId::FUNC_CALL) && IS_NAME(L(node)) &&
+           L(node)->value.nameId == funcNameId;
+}
+
+//---------------------------------------------------------------------------------------
+
+// Everything that can fail is done before the tree is changed, so the function is left as is
+// on the error. Arguments are evaluated into the temporaries when more than one parameter
+// changes, because every argument has to see the old values of the parameters
+static TreeErrors TailRecursionRewrite(TailRecursionContext* context, TreeNode* funcName,
+                                       TreeNode** lastLineLink, const TailRecursionSite* site)
+{
+    assert(context);
+    assert(funcName);
+    assert(lastLineLink);
+    assert(site);
+
+    Tree*             tree   = context->tree;
+    TreeNodeList      params = {};
+    TreeNodeList      args   = {};
+    TailRecursionJoin join   = {};
+    int*              temps  = nullptr;
+
+    TreeErrors err = TreeCommaChainGather(&funcName->left, &params);
+
+    if (err == TreeErrors::NO_ERR)
+        err = TreeCommaChainGather(&L(site->call)->left, &args);
+
+    if (err != TreeErrors::NO_ERR || params.size != args.size)
+    {
+        TreeNodeListDtor(&params);
+        TreeNodeListDtor(&args);
+        return err;
+    }
+
+    size_t changedCount = 0;
+    for (size_t i = 0; i < params.size; ++i)
+    {
+        if (!IS_NAME(args.data[i]) ||
+            args.data[i]->value.nameId != TreeParamNameId(params.data[i]))
+            changedCount++;
+    }
+
+    const char* funcNameString = tree->allNamesTable->data[funcName->value.nameId].name;
+
+    // body without other statements that calls itself with the same arguments never ends
+    bool canRewrite = site->rest != nullptr || changedCount > 0 ||
+                      site->lastLine != funcName->right;
+
+    if (canRewrite && site->rest != nullptr)
+    {
+        static const TreeVisitor returnsVisitor = { TailRecursionGatherReturn, nullptr, nullptr,
+                                                    false };
+
+        err = TreeVisit(&funcName->right, &returnsVisitor, &join);
+        if (err == TreeErrors::NO_ERR)
+            err = join.err;
+
+        join.accId = TreeCreateUniqueName(tree, &context->uniqueNames, funcNameString, "acc");
+        if (err == TreeErrors::NO_ERR && join.accId < 0)
+            err = TreeErrors::MEM_ERR;
+    }
+
+    if (canRewrite && err == TreeErrors::NO_ERR && changedCount > 1)
+    {
+        temps = (int*)calloc(params.size, sizeof(*temps));
+        if (temps == nullptr)
+            err = TreeErrors::MEM_ERR;
+
+        for (size_t i = 0; i < params.size && err == TreeErrors::NO_ERR; ++i)
+        {
+            const int paramId = TreeParamNameId(params.data[i]);
+
+            temps[i] = -1;
+            if (IS_NAME(args.data[i]) && args.data[i]->value.nameId == paramId)
+                continue;
+
+            temps[i] = TreeCreateUniqueName(tree, &context->uniqueNames, funcNameString,
+                                            tree->allNamesTable->data[paramId].name);
+            if (temps[i] < 0)
+                err = TreeErrors::MEM_ERR;
+        }
+    }
+
+    if (!canRewrite || err != TreeErrors::NO_ERR)
+    {
+        TreeNodeListDtor(&params);
+        TreeNodeListDtor(&args);
+        TreeNodeListDtor(&join.returns);
+        free(temps);
+        return err;
+    }
+
+    // the recursive statement is replaced with the updates of the accumulator and parameters
+    *lastLineLink = nullptr;
+    TreeNodeDtor(site->lastLine);
+
+    if (site->rest != nullptr)
+    {
+        TailRecursionJoinReturns(&join, site);
+
+        TreeNode* accValue = site->joinOperation == TreeOperationId::MUL ?
+                             CREATE_MUL_NODE(CREATE_VAR(join.accId), site->rest) :
+                             CREATE_ADD_NODE(CREATE_VAR(join.accId), site->rest);
+
+        lastLineLink = TreeChainAppend(lastLineLink,
+                                       CREATE_ASSIGN_NODE(CREATE_VAR(join.accId), accValue));
+    }
+
+    // chain can't be left half freed, the call is freed anyway
+    err = TreeCommaChainDtor(&L(site->call)->left);
+
+    // arguments are evaluated in the same order as the call does, from the last one
+    for (size_t i = params.size; i-- > 0; )
+    {
+        const int paramId = TreeParamNameId(params.data[i]);
+
+        if (IS_NAME(args.data[i]) && args.data[i]->value.nameId == paramId)
+        {
+            TreeNodeDtor(args.data[i]);
+            continue;
+        }
+
+        if (temps == nullptr)
+        {
+            lastLineLink = TreeChainAppend(lastLineLink,
+                                    CREATE_ASSIGN_NODE(CREATE_VAR(paramId), args.data[i]));
+            continue;
+        }
+
+        lastLineLink = TreeChainAppend(lastLineLink,
+                            CREATE_TYPE_NODE(CREATE_TYPE_INT_NODE(nullptr),
+                                             CREATE_ASSIGN_NODE(CREATE_VAR(temps[i]),
+                                                                args.data[i])));
+    }
+
+    for (size_t i = 0; temps != nullptr && i < params.size; ++i)
+    {
+        if (temps[i] >= 0)
+            lastLineLink = TreeChainAppend(lastLineLink,
+                                CREATE_ASSIGN_NODE(CREATE_VAR(TreeParamNameId(params.data[i])),
+                                                   CREATE_VAR(temps[i])));
+    }
+
+    TreeNodeDtor(L(site->call));
+    TreeNodeDtor(site->call);
+    if (site->join != nullptr)
+        TreeNodeDtor(site->join);
+    TreeNodeDtor(site->ret);
+
+    TreeNode* loop = CREATE_WHILE_NODE(CREATE_NUM(1), funcName->right);
+    funcName->right = CREATE_LINE_END_NODE(loop);
+
+    if (site->rest != nullptr)
+    {
+        const int identity = site->joinOperation == TreeOperationId::MUL ? 1 : 0;
+
+        TreeNode* accInit = CREATE_TYPE_NODE(CREATE_TYPE_INT_NODE(nullptr),
+                                             CREATE_ASSIGN_NODE(CREATE_VAR(join.accId),
+                                                                CREATE_NUM(identity)));
+        funcName->right = CREATE_LINE_END_NODE(accInit, funcName->right);
+    }
+
+    TreeNodeListDtor(&params);
+    TreeNodeListDtor(&args);
+    TreeNodeListDtor(&join.returns);
+    free(temps);
+
+    return err;
+}
+
+// The recursive RETURN is detached already, so only the other ones are left in the list
+static void TailRecursionJoinReturns(const TailRecursionJoin* join, const TailRecursionSite* site)
+{
+    assert(join);
+    assert(site);
+
+    for (size_t i = 0; i < join->returns.size; ++i)
+    {
+        TreeNode* ret = join->returns.data[i];
+        if (ret == site->ret)
+            continue;
+
+        if (site->joinOperation == TreeOperationId::MUL)
+            L(ret) = CREATE_MUL_NODE(CREATE_VAR(join->accId), L(ret));
+        else if (site->joinOperation == TreeOperationId::ADD)
+            L(ret) = CREATE_ADD_NODE(CREATE_VAR(join->accId), L(ret));
+        else
+            L(ret) = CREATE_SUB_NODE(L(ret), CREATE_VAR(join->accId));
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+static TreeVisitAction TailRecursionGatherReturn(TreeNode** link, TreeVisitState*, void* context)
+{
+    assert(link);
+    assert(context);
+
+    TailRecursionJoin* join = (TailRecursionJoin*)context;
+
+    if (!TreeNodeIsOperation(*link, TreeOperationId::RETURN))
+        return TreeVisitAction::CONTINUE;
+
+    join->err = TreeNodeListPush(&join->returns, *link);
+
+    return join->err == TreeErrors::NO_ERR ? TreeVisitAction::SKIP_CHILDREN :
+                                             TreeVisitAction::STOP;
+}
@@ -1,14 +1,17 @@
 #include <assert.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "MiddleEnd.h"
 #include "Common/Log.h"
+#include "Common/CommandLineArgs.h"
 
 int main(int argc, char* argv[])
 {
     assert(argc > 2);
     LogOpen(argv[0]);
+    TreeDumpPolicyInit(ArgsGetOption(argc, argv, "--dump="));
 
     FILE* inStream  = fopen(argv[1], "r");
     FILE* outStream = fopen(argv[2], "w");
@@ -16,14 +19,22 @@ int main(int argc, char* argv[])
     Tree tree = {};
     TreeCtor(&tree);
     
-    TreeReadPrefixFormat(&tree, inStream);
+    TreeRead(&tree, inStream);
 
     TreeGraphicDump(&tree, true);
     
-    TreeSimplify(&tree);
+    // --inline-size=N inlines callees of N nodes or less, 0 turns the inlining off
+    const char* inlineSizeOption = ArgsGetOption(argc, argv, "--inline-size=");
+    size_t      inlineSizeLimit  = inlineSizeOption ? strtoul(inlineSizeOption, nullptr, 10) :
+                                                      TREE_INLINE_STANDARD_SIZE_LIMIT;
+
+    TreeSimplify(&tree, inlineSizeLimit);
 
     TreeGraphicDump(&tree, true);
-    TreePrintPrefixFormat(&tree, outStream);
+
+    TreeFileFormat outFormat = ArgsHasFlag(argc, argv, "--binary") ? TreeFileFormat::BINARY :
+                                                                      TreeFileFormat::PREFIX;
+    TreePrint(&tree, outStream, outFormat);
 
     TreeDtor(&tree);
     fclose(inStream);
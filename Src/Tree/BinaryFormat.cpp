@@ -0,0 +1,357 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Tree.h"
+#include "CompactTree.h"
+#include "TreeVisitor.h"
+#include "NameTable/NameTable.h"
+
+// Binary format layout (host byte order):
+//
+// TreeBinaryHeader
+// names section - namesCount records: uint32_t length, length bytes of name, '\0'
+// nodes section - nodesCount TreeBinaryNode records in preorder
+//
+// Children of the node are not stored explicitly - in preorder left subtree goes right after
+// the node and right subtree goes after the left one, so it's enough to know which of them exist.
+
+static const char     TREE_BINARY_MAGIC[8]  = { 'A', 'S', 'T', '5', '7', 'B', 'I', 'N' };
+static const uint32_t TREE_BINARY_VERSION   = 1;
+
+struct TreeBinaryHeader
+{
+    char     magic[sizeof(TREE_BINARY_MAGIC)];
+    uint32_t version;
+
+    uint32_t namesCount;
+    uint32_t namesBytes;
+    uint32_t nodesCount;
+};
+
+static const uint8_t TREE_BINARY_HAS_LEFT  = 1 << 0;
+static const uint8_t TREE_BINARY_HAS_RIGHT = 1 << 1;
+
+struct TreeBinaryNode
+{
+    int32_t  value;
+    uint8_t  valueType;
+    uint8_t  children;
+    uint16_t reserved;
+};
+
+//---------------------------------------------------------------------------------------
+
+static void TreeBinaryFillNodes(const CompactTree* tree, TreeBinaryNode* nodes);
+
+struct TreeBinaryBuildContext
+{
+    const TreeBinaryNode* nodes;
+    size_t                nodesCount;
+    size_t                pos;          ///< next node to build
+
+    const int*            namesRemap;
+    size_t                namesCount;
+
+    TreeErrors            err;
+};
+
+static TreeVisitAction TreeBinaryBuildNode(TreeNode** link, TreeVisitState* state, void* context);
+
+static TreeErrors TreeBinaryReadNames(const char* names, const size_t namesBytes,
+                                      const size_t namesCount, NameTableType* allNamesTable,
+                                      int* namesRemap);
+
+static inline bool TreeBinaryIsNameValueType(const TreeNodeValueType valueType);
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors TreePrintBinaryFormat(const Tree* tree, FILE* outStream)
+{
+    assert(tree);
+    assert(tree->allNamesTable);
+    assert(outStream);
+
+    const NameTableType* allNamesTable = tree->allNamesTable;
+
+    // compact tree is already in preorder, so nodes are written with one linear pass
+    CompactTree compactTree = {};
+    TreeErrors err = CompactTreeFromTree(tree, &compactTree);
+
+    if (err != TreeErrors::NO_ERR)
+    {
+        CompactTreeDtor(&compactTree);
+        return err;
+    }
+
+    TreeBinaryHeader header = {};
+    memcpy(header.magic, TREE_BINARY_MAGIC, sizeof(TREE_BINARY_MAGIC));
+    header.version    = TREE_BINARY_VERSION;
+    header.namesCount = (uint32_t)allNamesTable->size;
+    header.nodesCount = (uint32_t)compactTree.size;
+
+    for (size_t i = 0; i < allNamesTable->size; ++i)
+        header.namesBytes += (uint32_t)(sizeof(uint32_t) + strlen(allNamesTable->data[i].name) + 1);
+
+    if (fwrite(&header, sizeof(header), 1, outStream) != 1)
+        err = TreeErrors::WRITING_ERR;
+
+    for (size_t i = 0; i < allNamesTable->size && err == TreeErrors::NO_ERR; ++i)
+    {
+        const char* name   = allNamesTable->data[i].name;
+        uint32_t    length = (uint32_t)strlen(name);
+
+        if (fwrite(&length, sizeof(length), 1, outStream) != 1 ||
+            fwrite(name, sizeof(*name), length + 1, outStream) != length + 1)
+            err = TreeErrors::WRITING_ERR;
+    }
+
+    if (err != TreeErrors::NO_ERR || header.nodesCount == 0)
+    {
+        CompactTreeDtor(&compactTree);
+        return err;
+    }
+
+    TreeBinaryNode* nodes = (TreeBinaryNode*)calloc(header.nodesCount, sizeof(*nodes));
+    if (nodes == nullptr)
+    {
+        CompactTreeDtor(&compactTree);
+        return TreeErrors::MEM_ERR;
+    }
+
+    TreeBinaryFillNodes(&compactTree, nodes);
+    CompactTreeDtor(&compactTree);
+
+    size_t nWritten = fwrite(nodes, sizeof(*nodes), header.nodesCount, outStream);
+    free(nodes);
+
+    if (nWritten != header.nodesCount)
+        return TreeErrors::WRITING_ERR;
+
+    return TreeErrors::NO_ERR;
+}
+
+//---------------------------------------------------------------------------------------
+
+static void TreeBinaryFillNodes(const CompactTree* tree, TreeBinaryNode* nodes)
+{
+    assert(tree);
+    assert(nodes);
+    assert(tree->size == 0 || tree->root == 0);
+
+    for (CompactNodeId node = 0; node < tree->size; ++node)
+    {
+        // preorder: left child is the next node, right child goes after the left subtree
+        assert(tree->left[node] == COMPACT_TREE_NO_NODE || tree->left[node] == node + 1);
+
+        TreeBinaryNode* binaryNode = nodes + node;
+
+        binaryNode->value     = tree->value[node];
+        binaryNode->valueType = tree->valueType[node];
+        binaryNode->children  = (uint8_t)((tree->left [node] != COMPACT_TREE_NO_NODE ? TREE_BINARY_HAS_LEFT  : 0) |
+                                          (tree->right[node] != COMPACT_TREE_NO_NODE ? TREE_BINARY_HAS_RIGHT : 0));
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors TreeReadBinaryFormat(Tree* tree, FILE* inStream)
+{
+    assert(tree);
+    assert(inStream);
+
+    TreeBinaryHeader header = {};
+
+    if (fread(&header, sizeof(header), 1, inStream) != 1)
+        return TreeErrors::READING_ERR;
+
+    if (memcmp(header.magic, TREE_BINARY_MAGIC, sizeof(TREE_BINARY_MAGIC)) != 0 ||
+        header.version != TREE_BINARY_VERSION)
+        return TreeErrors::READING_ERR;
+
+    char*           names      = (char*)          calloc(header.namesBytes + 1, sizeof(*names));
+    int*            namesRemap = (int*)           calloc(header.namesCount + 1, sizeof(*namesRemap));
+    TreeBinaryNode* nodes      = (TreeBinaryNode*)calloc(header.nodesCount + 1, sizeof(*nodes));
+
+    TreeErrors err = TreeErrors::NO_ERR;
+
+    if (names == nullptr || namesRemap == nullptr || nodes == nullptr)
+        err = TreeErrors::MEM_ERR;
+
+    if (err == TreeErrors::NO_ERR &&
+        (fread(names, sizeof(*names), header.namesBytes, inStream) != header.namesBytes ||
+         fread(nodes, sizeof(*nodes), header.nodesCount, inStream) != header.nodesCount))
+        err = TreeErrors::READING_ERR;
+
+    if (err == TreeErrors::NO_ERR)
+    {
+        NameTableCtor(&tree->allNamesTable);
+
+        err = TreeBinaryReadNames(names, header.namesBytes, header.namesCount,
+                                  tree->allNamesTable, namesRemap);
+    }
+
+    if (err == TreeErrors::NO_ERR && header.nodesCount > 0)
+    {
+        // nodes are in preorder, so every link is filled right when the visitor comes to it
+        static const TreeVisitor buildVisitor = { TreeBinaryBuildNode, nullptr, nullptr, true };
+
+        TreeBinaryBuildContext context = { nodes, header.nodesCount, 0, namesRemap,
+                                           header.namesCount, TreeErrors::NO_ERR };
+
+        TreeMakeCurrent(tree);
+        tree->root = nullptr;
+
+        err = TreeVisit(&tree->root, &buildVisitor, &context);
+        if (err == TreeErrors::NO_ERR)
+            err = context.err;
+    }
+
+    free(names);
+    free(namesRemap);
+    free(nodes);
+
+    return err;
+}
+
+//---------------------------------------------------------------------------------------
+
+static TreeErrors TreeBinaryReadNames(const char* names, const size_t namesBytes,
+                                      const size_t namesCount, NameTableType* allNamesTable,
+                                      int* namesRemap)
+{
+    assert(names);
+    assert(allNamesTable);
+    assert(namesRemap);
+
+    size_t pos = 0;
+    for (size_t i = 0; i < namesCount; ++i)
+    {
+        uint32_t length = 0;
+
+        if (pos + sizeof(length) > namesBytes)
+            return TreeErrors::READING_ERR;
+
+        memcpy(&length, names + pos, sizeof(length));
+        pos += sizeof(length);
+
+        if (pos + length + 1 > namesBytes || names[pos + length] != '\0')
+            return TreeErrors::READING_ERR;
+
+        const char* name = names + pos;
+        pos += length + 1;
+
+        // Same as in the prefix format: names are united, string literals are always new
+        Name* nameInTablePtr = nullptr;
+        if (name[0] != '"')
+            NameTableFind(allNamesTable, name, &nameInTablePtr);
+
+        if (nameInTablePtr != nullptr)
+        {
+            size_t nameInTablePos = 0;
+            NameTableGetPos(allNamesTable, nameInTablePtr, &nameInTablePos);
+
+            namesRemap[i] = (int)nameInTablePos;
+            continue;
+        }
+
+        Name pushName = {};
+        NameCtor(&pushName, name, nullptr, 0);
+        NameTablePush(allNamesTable, pushName);
+
+        namesRemap[i] = (int)allNamesTable->size - 1;
+    }
+
+    return TreeErrors::NO_ERR;
+}
+
+//---------------------------------------------------------------------------------------
+
+static TreeVisitAction TreeBinaryBuildNode(TreeNode** link, TreeVisitState* state, void* context)
+{
+    assert(link);
+    assert(*link == nullptr);
+    assert(state);
+    assert(context);
+
+    TreeBinaryBuildContext* buildContext = (TreeBinaryBuildContext*)context;
+
+    if (buildContext->pos >= buildContext->nodesCount)
+    {
+        buildContext->err = TreeErrors::READING_ERR;
+        return TreeVisitAction::STOP;
+    }
+
+    const TreeBinaryNode* binaryNode = buildContext->nodes + buildContext->pos;
+    buildContext->pos += 1;
+
+    TreeNodeValueType valueType = (TreeNodeValueType)binaryNode->valueType;
+    TreeNodeValue     value     = {};
+
+    if (TreeBinaryIsNameValueType(valueType))
+    {
+        if (binaryNode->value < 0 || (size_t)binaryNode->value >= buildContext->namesCount)
+        {
+            buildContext->err = TreeErrors::READING_ERR;
+            return TreeVisitAction::STOP;
+        }
+
+        value = TreeCreateNameVal(buildContext->namesRemap[binaryNode->value]);
+    }
+    else if (valueType == TreeNodeValueType::OPERATION)
+        value = TreeCreateOpVal((TreeOperationId)binaryNode->value);
+    else if (valueType == TreeNodeValueType::NUM)
+        value = TreeCreateNumVal(binaryNode->value);
+    else
+    {
+        buildContext->err = TreeErrors::READING_ERR;
+        return TreeVisitAction::STOP;
+    }
+
+    TreeNode* node = TreeNodeCreate(value, valueType);
+    *link = node;
+
+    // only stored children are read, absent ones stay nil
+    TreeVisitSetChildren(state,
+                         (binaryNode->children & TREE_BINARY_HAS_LEFT)  ? &node->left  : nullptr,
+                         (binaryNode->children & TREE_BINARY_HAS_RIGHT) ? &node->right : nullptr);
+
+    return TreeVisitAction::CONTINUE;
+}
+
+static inline bool TreeBinaryIsNameValueType(const TreeNodeValueType valueType)
+{
+    return valueType == TreeNodeValueType::NAME ||
+           valueType == TreeNodeValueType::STRING_LITERAL;
+}
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors TreePrint(const Tree* tree, FILE* outStream, TreeFileFormat format)
+{
+    assert(tree);
+    assert(outStream);
+
+    if (format == TreeFileFormat::BINARY)
+        return TreePrintBinaryFormat(tree, outStream);
+
+    return TreePrintPrefixFormat(tree, outStream);
+}
+
+TreeErrors TreeRead(Tree* tree, FILE* inStream)
+{
+    assert(tree);
+    assert(inStream);
+
+    char magic[sizeof(TREE_BINARY_MAGIC)] = {};
+    size_t nRead = fread(magic, sizeof(*magic), sizeof(magic), inStream);
+
+    if (fseek(inStream, 0, SEEK_SET) != 0)
+        return TreeErrors::READING_ERR;
+
+    if (nRead == sizeof(magic) && memcmp(magic, TREE_BINARY_MAGIC, sizeof(magic)) == 0)
+        return TreeReadBinaryFormat(tree, inStream);
+
+    return TreeReadPrefixFormat(tree, inStream);
+}
@@ -0,0 +1,373 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "CompactTree.h"
+#include "TreeVisitor.h"
+
+//---------------------------------------------------------------------------------------
+
+static const size_t COMPACT_TREE_STANDARD_CAPACITY = 64;
+
+static TreeErrors CompactTreeRealloc(CompactTree* tree, const size_t capacity);
+
+/// @brief Nodes on the way from the root to the visited one, child is linked to the top
+struct CompactTreeParent
+{
+    const TreeNode* node;
+    CompactNodeId   pos;
+};
+
+struct CompactTreeFromNodeContext
+{
+    CompactTree*       outTree;
+
+    CompactTreeParent* parents;
+    size_t             parentsSize;
+    size_t             parentsCapacity;
+
+    TreeErrors         err;
+};
+
+static const size_t COMPACT_TREE_PARENTS_STANDARD_CAPACITY = 64;
+
+static TreeVisitAction CompactTreeFromNodePre (const TreeNode* node, TreeConstVisitState* state,
+                                               void* context);
+static TreeVisitAction CompactTreeFromNodePost(const TreeNode* node, TreeConstVisitState* state,
+                                               void* context);
+
+static TreeErrors CompactTreeToNodes(const CompactTree* tree, TreeNode** outRoot);
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors CompactTreeCtor(CompactTree* tree, const size_t capacity)
+{
+    assert(tree);
+
+    *tree      = {};
+    tree->root = COMPACT_TREE_NO_NODE;
+
+    return CompactTreeRealloc(tree, capacity > 0 ? capacity : COMPACT_TREE_STANDARD_CAPACITY);
+}
+
+void CompactTreeDtor(CompactTree* tree)
+{
+    assert(tree);
+
+    free(tree->left);
+    free(tree->right);
+    free(tree->value);
+    free(tree->valueType);
+
+    *tree      = {};
+    tree->root = COMPACT_TREE_NO_NODE;
+}
+
+static TreeErrors CompactTreeRealloc(CompactTree* tree, const size_t capacity)
+{
+    assert(tree);
+    assert(capacity >= tree->size);
+
+    CompactNodeId* left      = (CompactNodeId*)realloc(tree->left,      capacity * sizeof(*left));
+    if (left == nullptr)      return TreeErrors::MEM_ERR;
+    tree->left = left;
+
+    CompactNodeId* right     = (CompactNodeId*)realloc(tree->right,     capacity * sizeof(*right));
+    if (right == nullptr)     return TreeErrors::MEM_ERR;
+    tree->right = right;
+
+    int32_t*       value     = (int32_t*)      realloc(tree->value,     capacity * sizeof(*value));
+    if (value == nullptr)     return TreeErrors::MEM_ERR;
+    tree->value = value;
+
+    uint8_t*       valueType = (uint8_t*)      realloc(tree->valueType, capacity * sizeof(*valueType));
+    if (valueType == nullptr) return TreeErrors::MEM_ERR;
+    tree->valueType = valueType;
+
+    tree->capacity = capacity;
+
+    return TreeErrors::NO_ERR;
+}
+
+//---------------------------------------------------------------------------------------
+
+CompactNodeId CompactTreeNodeCreate(CompactTree* tree, TreeNodeValue value,
+                                    TreeNodeValueType valueType,
+                                    CompactNodeId left, CompactNodeId right)
+{
+    assert(tree);
+
+    if (tree->size >= COMPACT_TREE_NO_NODE)
+        return COMPACT_TREE_NO_NODE;
+
+    if (tree->size == tree->capacity &&
+        CompactTreeRealloc(tree, tree->capacity * 2) != TreeErrors::NO_ERR)
+        return COMPACT_TREE_NO_NODE;
+
+    CompactNodeId node = (CompactNodeId)tree->size++;
+
+    tree->left     [node] = left;
+    tree->right    [node] = right;
+    tree->valueType[node] = (uint8_t)valueType;
+
+    switch (valueType)
+    {
+        case TreeNodeValueType::NUM:
+            tree->value[node] = value.num;
+            break;
+        case TreeNodeValueType::NAME:
+        case TreeNodeValueType::STRING_LITERAL:
+            tree->value[node] = value.nameId;
+            break;
+        case TreeNodeValueType::OPERATION:
+            tree->value[node] = (int32_t)value.operation;
+            break;
+        default:
+            assert(false);
+            break;
+    }
+
+    return node;
+}
+
+TreeNodeValue CompactTreeGetValue(const CompactTree* tree, const CompactNodeId node)
+{
+    assert(tree);
+    assert(node < tree->size);
+
+    switch ((TreeNodeValueType)tree->valueType[node])
+    {
+        case TreeNodeValueType::NUM:
+            return TreeCreateNumVal(tree->value[node]);
+        case TreeNodeValueType::NAME:
+        case TreeNodeValueType::STRING_LITERAL:
+            return TreeCreateNameVal(tree->value[node]);
+        case TreeNodeValueType::OPERATION:
+            return TreeCreateOpVal((TreeOperationId)tree->value[node]);
+        default:
+            assert(false);
+            break;
+    }
+
+    return TreeCreateNumVal(0);
+}
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors CompactTreeFromTree(const Tree* tree, CompactTree* outTree)
+{
+    assert(tree);
+    assert(outTree);
+
+    TreeErrors err = CompactTreeCtor(outTree);
+    if (err != TreeErrors::NO_ERR)
+        return err;
+
+    outTree->allNamesTable = tree->allNamesTable;
+
+    if (tree->root == nullptr)
+        return TreeErrors::NO_ERR;
+
+    static const TreeConstVisitor fromNodeVisitor = { CompactTreeFromNodePre, nullptr,
+                                                      CompactTreeFromNodePost, false };
+
+    CompactTreeFromNodeContext context = {};
+    context.outTree = outTree;
+
+    err = TreeVisit(tree->root, &fromNodeVisitor, &context);
+
+    free(context.parents);
+
+    if (err != TreeErrors::NO_ERR)
+        return err;
+
+    if (context.err == TreeErrors::NO_ERR)
+        outTree->root = 0;
+
+    return context.err;
+}
+
+// node is created before its children, so nodes are in preorder
+static TreeVisitAction CompactTreeFromNodePre(const TreeNode* node, TreeConstVisitState*,
+                                              void* context)
+{
+    assert(node);
+    assert(context);
+
+    CompactTreeFromNodeContext* fromNode = (CompactTreeFromNodeContext*)context;
+    CompactTree*                outTree  = fromNode->outTree;
+
+    if (fromNode->parentsSize == fromNode->parentsCapacity)
+    {
+        const size_t newCapacity = fromNode->parentsCapacity > 0 ?
+                                   2 * fromNode->parentsCapacity :
+                                   COMPACT_TREE_PARENTS_STANDARD_CAPACITY;
+
+        CompactTreeParent* newParents = (CompactTreeParent*)realloc(fromNode->parents,
+                                                            newCapacity * sizeof(*newParents));
+        if (newParents == nullptr)
+        {
+            fromNode->err = TreeErrors::MEM_ERR;
+            return TreeVisitAction::STOP;
+        }
+
+        fromNode->parents         = newParents;
+        fromNode->parentsCapacity = newCapacity;
+    }
+
+    CompactNodeId pos = CompactTreeNodeCreate(outTree, node->value, node->valueType);
+
+    if (pos == COMPACT_TREE_NO_NODE)
+    {
+        fromNode->err = TreeErrors::MEM_ERR;
+        return TreeVisitAction::STOP;
+    }
+
+    if (fromNode->parentsSize > 0)
+    {
+        const CompactTreeParent* parent = &fromNode->parents[fromNode->parentsSize - 1];
+
+        if (parent->node->left == node)
+            outTree->left [parent->pos] = pos;
+        else
+            outTree->right[parent->pos] = pos;
+    }
+
+    fromNode->parents[fromNode->parentsSize++] = { node, pos };
+
+    return TreeVisitAction::CONTINUE;
+}
+
+static TreeVisitAction CompactTreeFromNodePost(const TreeNode*, TreeConstVisitState*,
+                                               void* context)
+{
+    assert(context);
+
+    CompactTreeFromNodeContext* fromNode = (CompactTreeFromNodeContext*)context;
+
+    assert(fromNode->parentsSize > 0);
+    fromNode->parentsSize--;
+
+    return TreeVisitAction::CONTINUE;
+}
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors CompactTreeToTree(const CompactTree* tree, Tree* outTree)
+{
+    assert(tree);
+    assert(outTree);
+    assert(outTree->nodeArena);
+
+    TreeErrors err = CompactTreeVerify(tree);
+    if (err != TreeErrors::NO_ERR)
+        return err;
+
+    TreeMakeCurrent(outTree);
+
+    TreeNode* root = nullptr;
+
+    err = CompactTreeToNodes(tree, &root);
+    if (err != TreeErrors::NO_ERR)
+        return err;
+
+    outTree->root          = root;
+    outTree->allNamesTable = tree->allNamesTable;
+
+    return TreeErrors::NO_ERR;
+}
+
+// Every node is created with one pass over the arrays and its children are linked with
+// another one, so the depth of the tree doesn't matter. Node with two parents or the root
+// with a parent would turn the tree into a graph, such arrays are rejected
+static TreeErrors CompactTreeToNodes(const CompactTree* tree, TreeNode** outRoot)
+{
+    assert(tree);
+    assert(outRoot);
+
+    if (tree->root == COMPACT_TREE_NO_NODE)
+    {
+        *outRoot = nullptr;
+        return TreeErrors::NO_ERR;
+    }
+
+    TreeNode** nodes     = (TreeNode**)calloc(tree->size, sizeof(*nodes));
+    bool*      hasParent = (bool*)     calloc(tree->size, sizeof(*hasParent));
+
+    if (nodes == nullptr || hasParent == nullptr)
+    {
+        free(nodes);
+        free(hasParent);
+        return TreeErrors::MEM_ERR;
+    }
+
+    for (CompactNodeId node = 0; node < tree->size; ++node)
+        nodes[node] = TreeNodeCreate(CompactTreeGetValue(tree, node),
+                                     (TreeNodeValueType)tree->valueType[node]);
+
+    TreeErrors err = TreeErrors::NO_ERR;
+
+    for (CompactNodeId node = 0; node < tree->size && err == TreeErrors::NO_ERR; ++node)
+    {
+        const CompactNodeId children[] = { tree->left[node], tree->right[node] };
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            const CompactNodeId child = children[i];
+
+            if (child == COMPACT_TREE_NO_NODE)
+                continue;
+
+            if (hasParent[child] || child == tree->root)
+            {
+                err = TreeErrors::NODE_EDGES_ERR;
+                break;
+            }
+
+            hasParent[child] = true;
+        }
+
+        nodes[node]->left  = tree->left [node] != COMPACT_TREE_NO_NODE ?
+                             nodes[tree->left [node]] : nullptr;
+        nodes[node]->right = tree->right[node] != COMPACT_TREE_NO_NODE ?
+                             nodes[tree->right[node]] : nullptr;
+    }
+
+    *outRoot = err == TreeErrors::NO_ERR ? nodes[tree->root] : nullptr;
+
+    free(nodes);
+    free(hasParent);
+
+    return err;
+}
+
+//---------------------------------------------------------------------------------------
+
+// Same checks as TreeVerify does, but with one linear pass over the arrays
+TreeErrors CompactTreeVerify(const CompactTree* tree)
+{
+    assert(tree);
+
+    if (tree->size > tree->capacity)
+        return TreeErrors::CAPACITY_ERR;
+
+    if (tree->root != COMPACT_TREE_NO_NODE && tree->root >= tree->size)
+        return TreeErrors::NODE_EDGES_ERR;
+
+    for (CompactNodeId node = 0; node < tree->size; ++node)
+    {
+        CompactNodeId left  = tree->left [node];
+        CompactNodeId right = tree->right[node];
+
+        if ((left  != COMPACT_TREE_NO_NODE && left  >= tree->size) ||
+            (right != COMPACT_TREE_NO_NODE && right >= tree->size))
+            return TreeErrors::NODE_EDGES_ERR;
+
+        if (left == right && left != COMPACT_TREE_NO_NODE)
+            return TreeErrors::NODE_EDGES_ERR;
+
+        if (left == node || right == node)
+            return TreeErrors::NODE_EDGES_ERR;
+    }
+
+    return TreeErrors::NO_ERR;
+}
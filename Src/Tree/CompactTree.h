@@ -0,0 +1,60 @@
+#ifndef COMPACT_TREE_H
+#define COMPACT_TREE_H
+
+/// @file
+/// @brief Contains compact index-based tree representation.
+/// @details Nodes are stored contiguously in structure of arrays form and refer to
+/// their children by 32-bit indices. After CompactTreeFromTree nodes are in preorder,
+/// so the left child of the node i (if exists) is always i + 1.
+/// Passes can be moved to this representation one at a time using conversion functions.
+
+#include <stdint.h>
+
+#include "Tree.h"
+
+typedef uint32_t CompactNodeId;
+
+/// @brief Index of the absent child
+static const CompactNodeId COMPACT_TREE_NO_NODE = UINT32_MAX;
+
+struct CompactTree
+{
+    CompactNodeId* left;
+    CompactNodeId* right;
+
+    int32_t*       value;       ///< num, nameId or operation id depending on valueType
+    uint8_t*       valueType;   ///< TreeNodeValueType
+
+    size_t size;
+    size_t capacity;
+
+    CompactNodeId root;
+
+    NameTableType* allNamesTable;   ///< is not owned, belongs to the Tree it was converted from
+};
+
+TreeErrors CompactTreeCtor(CompactTree* tree, const size_t capacity = 0);
+void       CompactTreeDtor(CompactTree* tree);
+
+/// @brief Appends node to the tree
+/// @return index of the new node or COMPACT_TREE_NO_NODE if memory allocation failed
+CompactNodeId CompactTreeNodeCreate(CompactTree* tree, TreeNodeValue value,
+                                    TreeNodeValueType valueType,
+                                    CompactNodeId left  = COMPACT_TREE_NO_NODE,
+                                    CompactNodeId right = COMPACT_TREE_NO_NODE);
+
+/// @brief Converts pointer-based tree to the compact one, nodes are placed in preorder
+/// @param [in]tree tree to convert
+/// @param [out]outTree constructed compact tree (allNamesTable is shared with tree)
+TreeErrors CompactTreeFromTree(const Tree* tree, CompactTree* outTree);
+
+/// @brief Converts compact tree to the pointer-based one
+/// @param [in]tree compact tree to convert
+/// @param [out]outTree tree to fill, has to be constructed by TreeCtor
+TreeErrors CompactTreeToTree(const CompactTree* tree, Tree* outTree);
+
+TreeNodeValue CompactTreeGetValue(const CompactTree* tree, const CompactNodeId node);
+
+TreeErrors CompactTreeVerify(const CompactTree* tree);
+
+#endif
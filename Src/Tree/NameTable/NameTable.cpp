@@ -20,6 +20,10 @@ static inline bool NameTableIsFull(NameTableType* nameTable);
 
 static inline bool NameTableIsTooBig(NameTableType* nameTable);
 
+static NameTableErrors NameTableIndexRebuild(NameTableType* nameTable, const size_t indexCapacity);
+static void NameTableIndexInsert(NameTableType* nameTable, const size_t pos);
+static inline size_t NameTableSymbolHash(const SymbolId symbol);
+
 //--------CANARY PROTECTION----------
 
 #ifdef NAME_TABLE_CANARY_PROTECTION
@@ -160,6 +164,9 @@ NameTableErrors NameTableCtor(NameTableType* const nameTable, const size_t capac
         return NameTableErrors::MEMORY_ALLOCATION_ERROR;   
     }
 
+    if (NameTableIndexRebuild(nameTable, 2 * nameTable->capacity) != NameTableErrors::NO_ERR)
+        return NameTableErrors::MEMORY_ALLOCATION_ERROR;
+
     //-----------------------
 
     NameTableDataFill(nameTable);
@@ -210,6 +217,9 @@ NameTableErrors NameTableCtor(NameTableType** const outNameTable, const size_t c
         return NameTableErrors::MEMORY_ALLOCATION_ERROR;   
     }
 
+    if (NameTableIndexRebuild(nameTable, 2 * nameTable->capacity) != NameTableErrors::NO_ERR)
+        return NameTableErrors::MEMORY_ALLOCATION_ERROR;
+
     //-----------------------
 
     NameTableDataFill(nameTable);
@@ -240,7 +250,6 @@ NameTableErrors NameTableDtor(NameTableType* const nameTable)
             NameTableDtor((NameTableType*)nameTable->data[i].localNameTable);
             nameTable->data[i].localNameTable = nullptr;
         }
-        free(nameTable->data[i].name);
         nameTable->data[i] = NAME_TABLE_POISON;
     }
 
@@ -252,6 +261,10 @@ NameTableErrors NameTableDtor(NameTableType* const nameTable)
     free(nameTable->data);
     nameTable->data = nullptr;
 
+    free(nameTable->index);
+    nameTable->index         = nullptr;
+    nameTable->indexCapacity = 0;
+
     nameTable->size     = 0;
     nameTable->capacity = 0;
 
@@ -284,6 +297,8 @@ NameTableErrors NameTablePush(NameTableType* nameTable, const Name val)
 
     nameTable->data[nameTable->size++] = val;
 
+    NameTableIndexInsert(nameTable, nameTable->size - 1);
+
     ON_HASH
     (
         UpdateDataHash(nameTable);
@@ -296,17 +311,39 @@ NameTableErrors NameTablePush(NameTableType* nameTable, const Name val)
 }
 
 NameTableErrors NameTableFind(NameTableType* table, const char* name, Name** outName)
+{
+    assert(table);
+    assert(name);
+    assert(outName);
+
+    SymbolId symbol = SymbolFind(name);
+
+    // name that was never interned can't be in any nameTable
+    if (symbol == SYMBOL_ID_POISON)
+    {
+        *outName = nullptr;
+        return NameTableErrors::NO_ERR;
+    }
+
+    return NameTableFind(table, symbol, outName);
+}
+
+NameTableErrors NameTableFind(NameTableType* table, const SymbolId symbol, Name** outName)
 {
     assert(table);
     assert(outName);
 
     NAME_TABLE_CHECK(table);
 
-    for (size_t i = 0; i < table->size; ++i)
+    const size_t mask = table->indexCapacity - 1;
+
+    for (size_t slot = NameTableSymbolHash(symbol) & mask; table->index[slot] != 0; slot = (slot + 1) & mask)
     {
-        if (strcmp(table->data[i].name, name) == 0)
+        Name* tableName = table->data + table->index[slot] - 1;
+
+        if (tableName->symbol == symbol)
         {
-            *outName = table->data + i;
+            *outName = tableName;
             return NameTableErrors::NO_ERR;
         }
     }
@@ -525,6 +562,10 @@ NameTableErrors NameTableRealloc(NameTableType* nameTable, bool increase)
     if (increase)
         FillNameTable(nameTable->data + nameTable->size, nameTable->data + nameTable->capacity, NAME_TABLE_POISON);
 
+    // Index is kept twice bigger than data so its load factor is always <= 1/2
+    NameTableErrors indexErr = NameTableIndexRebuild(nameTable, 2 * nameTable->capacity);
+    IF_ERR_RETURN(indexErr);
+
     // -------Putting canary at the end-----------
     ON_CANARY
     (
@@ -568,6 +609,59 @@ static inline Name* MovePtr(Name* const data, const size_t moveSz, const int tim
     return (Name*)((char*)data + times * (long long)moveSz);
 }
 
+//---------------Hash index----------------
+
+// no NAME_TABLE_CHECK because is used in ctor (data could be not filled at this moment)
+static NameTableErrors NameTableIndexRebuild(NameTableType* nameTable, const size_t indexCapacity)
+{
+    assert(nameTable);
+    assert(indexCapacity > 0);
+    assert((indexCapacity & (indexCapacity - 1)) == 0);
+
+    size_t* index = (size_t*) calloc(indexCapacity, sizeof(*index));
+
+    if (index == nullptr)
+    {
+        NameTablePrintError(NameTableErrors::MEMORY_ALLOCATION_ERROR);
+        return NameTableErrors::MEMORY_ALLOCATION_ERROR;
+    }
+
+    free(nameTable->index);
+    nameTable->index         = index;
+    nameTable->indexCapacity = indexCapacity;
+
+    for (size_t pos = 0; pos < nameTable->size; ++pos)
+        NameTableIndexInsert(nameTable, pos);
+
+    return NameTableErrors::NO_ERR;
+}
+
+static void NameTableIndexInsert(NameTableType* nameTable, const size_t pos)
+{
+    assert(nameTable);
+    assert(nameTable->index);
+    assert(pos < nameTable->size);
+
+    const SymbolId symbol = nameTable->data[pos].symbol;
+    const size_t   mask   = nameTable->indexCapacity - 1;
+
+    size_t slot = NameTableSymbolHash(symbol) & mask;
+    for (; nameTable->index[slot] != 0; slot = (slot + 1) & mask)
+    {
+        // the first pushed name has to be found, so equal names are not indexed again
+        if (nameTable->data[nameTable->index[slot] - 1].symbol == symbol)
+            return;
+    }
+
+    nameTable->index[slot] = pos + 1;
+}
+
+// Symbol ids are dense, multiplicative hashing spreads them over the whole index
+static inline size_t NameTableSymbolHash(const SymbolId symbol)
+{
+    return (size_t)symbol * 0x9E3779B97F4A7C15ull >> 32;
+}
+
 // NO nameTable check because doesn't fill hashes
 static void NameTableDataFill(NameTableType* const nameTable)
 {
@@ -654,7 +748,19 @@ void NameTablePrintError(NameTableErrors error)
 
 void NameCtor(Name* name, const char* string, void* localNameTablePtr, size_t varRamId)
 {
-    name->name           = strdup(string);
+    assert(name);
+    assert(string);
+
+    NameCtor(name, SymbolIntern(string), localNameTablePtr, varRamId);
+}
+
+void NameCtor(Name* name, const SymbolId symbol, void* localNameTablePtr, size_t varRamId)
+{
+    assert(name);
+    assert(symbol != SYMBOL_ID_POISON);
+
+    name->name           = SymbolGetName(symbol);
+    name->symbol         = symbol;
     name->localNameTable = localNameTablePtr;
     name->varRamId       = varRamId;
 }
\ No newline at end of file
@@ -65,6 +65,9 @@ struct NameTableType
 
     size_t capacity;     ///< REAL size of the data at this moment (calloced more than need at this moment).
 
+    size_t* index;          ///< open addressing hash index by name. Contains pos in data + 1, 0 - empty slot.
+    size_t  indexCapacity;  ///< number of slots in index (power of 2, twice bigger than capacity).
+
     ON_CANARY
     (
         CanaryType structCanaryRight; ///< right canary for the struct
@@ -113,8 +116,22 @@ NameTableErrors NameTableDtor(NameTableType* const stk);
 /// @return errors that occurred
 NameTableErrors NameTablePush(NameTableType* stk, const Name val);
 
+/// @brief Finds name in the nameTable using hash index
+/// @details If there are several equal names the first pushed one is found
+/// @param [in]table nameTable to find in
+/// @param [in]name name to find
+/// @param [out]outName pointer to the found name in table->data or nullptr if not found
+/// @return errors that occurred
 NameTableErrors NameTableFind(NameTableType* table, const char* name, Name** outName);
 
+/// @brief Finds name in the nameTable by its symbol id using hash index
+/// @details If there are several equal names the first pushed one is found
+/// @param [in]table nameTable to find in
+/// @param [in]symbol symbol id of the name to find
+/// @param [out]outName pointer to the found name in table->data or nullptr if not found
+/// @return errors that occurred
+NameTableErrors NameTableFind(NameTableType* table, const SymbolId symbol, Name** outName);
+
 NameTableErrors NameTableGetPos(NameTableType* table, Name* namePtr, size_t* outPos);
 
 /// @brief Verifies if nameTable is used properly
@@ -146,6 +163,10 @@ static inline bool NameTableIsEmpty(const NameTableType* stk)
 /// @param [in]error error to print
 void NameTablePrintError(NameTableErrors error);
 
+/// @brief Name constructor, string is interned in the global symbol pool
 void NameCtor(Name* name, const char* string, void* localNameTablePtr, size_t varRamId);
 
+/// @brief Name constructor from already interned string
+void NameCtor(Name* name, const SymbolId symbol, void* localNameTablePtr, size_t varRamId);
+
 #endif // NAME_TABLE_H
\ No newline at end of file
@@ -8,9 +8,12 @@
 #include <math.h>
 #include <stdio.h>
 
+#include "Common/SymbolPool.h"
+
 struct Name
 {
-    char* name;
+    const char* name;   ///< interned string, the same as SymbolGetName(symbol)
+    SymbolId    symbol;
 
     void* localNameTable;
     size_t varRamId;
@@ -131,44 +131,68 @@ GENERATE_OPERATION_CMD(WHILE,
     return -1;
 })
 
-GENERATE_OPERATION_CMD(LESS, 
+#undef  CALC_CHECK
+#define CALC_CHECK()            \
+do                              \
+{                               \
+    assert(isfinite(val1));     \
+    assert(isfinite(val2));     \
+} while (0)
+
+GENERATE_OPERATION_CMD(LESS,
 {
+    CALC_CHECK();
 
+    return val1 < val2;
 })
 
-GENERATE_OPERATION_CMD(GREATER, 
+GENERATE_OPERATION_CMD(GREATER,
 {
+    CALC_CHECK();
 
+    return val1 > val2;
 })
 
-GENERATE_OPERATION_CMD(LESS_EQ, 
+GENERATE_OPERATION_CMD(LESS_EQ,
 {
+    CALC_CHECK();
 
+    return val1 <= val2;
 })
 
 GENERATE_OPERATION_CMD(GREATER_EQ,
 {
+    CALC_CHECK();
 
+    return val1 >= val2;
 })
 
-GENERATE_OPERATION_CMD(EQ, 
+GENERATE_OPERATION_CMD(EQ,
 {
+    CALC_CHECK();
 
+    return val1 == val2;
 })
 
 GENERATE_OPERATION_CMD(NOT_EQ,
 {
+    CALC_CHECK();
 
+    return val1 != val2;
 })
 
 GENERATE_OPERATION_CMD(AND,
 {
+    CALC_CHECK();
 
+    return val1 != 0 && val2 != 0;
 })
 
 GENERATE_OPERATION_CMD(OR,
 {
+    CALC_CHECK();
 
+    return val1 != 0 || val2 != 0;
 })
 
 //TODO: PRINT -> '{'
@@ -2,33 +2,65 @@
 #include <ctype.h>
 #include <string.h>
 #include <math.h>
+#include <stdlib.h>
+#include <strings.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include "Tree.h"
+#include "TreeVisitor.h"
 #include "Common/StringFuncs.h"
 #include "Common/Log.h"
 #include "FastInput/InputOutput.h"
 #include "Common/DoubleFuncs.h"
+#include "Common/PerfectHash.h"
 #include "NameTable/NameTable.h"
 
 //---------------------------------------------------------------------------------------
 
-static void TreeDtor     (TreeNode* node);
+static TreeNodeArena* TreeNodeArenaCtor();
+static void           TreeNodeArenaDtor(TreeNodeArena* arena);
+static TreeNode*      TreeNodeArenaAlloc(TreeNodeArena* arena);
+
 
+static TreeVisitAction TreeNodeDtorVisit(TreeNode** link, TreeVisitState* state, void* context);
+static TreeVisitAction TreeNodeCopyVisit(const TreeNode* node, TreeConstVisitState* state,
+                                         void* context);
+static TreeVisitAction TreeVerifyVisit  (const TreeNode* node, TreeConstVisitState* state,
+                                         void* context);
 
 static TreeErrors TreePrintPrefixFormat(const TreeNode* node, FILE* outStream,
                                         const NameTableType* nameTable);
+static TreeVisitAction TreePrintPrefixFormatPre (const TreeNode* node, TreeConstVisitState* state,
+                                                 void* context);
+static TreeVisitAction TreePrintPrefixFormatPost(const TreeNode* node, TreeConstVisitState* state,
+                                                 void* context);
 
-static TreeNode* TreeReadPrefixFormat(const char* const string, const char** stringEndPtr,
-                                                                    NameTableType* allNamesTable);
+static TreeVisitAction TreeReadPrefixFormatPre (TreeNode** link, TreeVisitState* state,
+                                                void* context);
+static TreeVisitAction TreeReadPrefixFormatPost(TreeNode** link, TreeVisitState* state,
+                                                void* context);
 
 static const char* TreeReadNodeValue(TreeNodeValue* value, TreeNodeValueType* valueType, 
-                                      const char* string, NameTableType* allNamesTable);
-
-static void TreeGraphicDump(const TreeNode* node, FILE* outDotFile);
-static void DotFileCreateNodes(const TreeNode* node, FILE* outDotFile,
-                                const NameTableType* nameTable);
-
-static inline void CreateImgInLogFile(const size_t imgIndex, bool openImg);
+                                      const char* string, NameTableType* allNamesTable,
+                                      TreeErrors* outErr);
+
+static inline const char* TreeReadWord(const char* string, char* outWord, const size_t maxWordSize);
+
+static TreeVisitAction DotFileCreateNode(const TreeNode* node, TreeConstVisitState* state,
+                                         void* context);
+static TreeVisitAction DotFileCreateEdgesPre(const TreeNode* node, TreeConstVisitState* state,
+                                             void* context);
+static TreeVisitAction DotFileCreateEdgesIn (const TreeNode* node, TreeConstVisitState* state,
+                                             void* context);
+
+static inline void CreateImgInLogFile(const char* dotFileName, const size_t imgIndex, 
+                                      bool openImg);
+static void TreeDumpWorkerPush(const char* dotFileName, const char* imgName, bool openImg);
+static void TreeDumpWorkerLoop();
+static void TreeDumpWorkerStop();
 static inline void DotFileBegin(FILE* outDotFile);
 static inline void DotFileEnd  (FILE* outDotFile);
 
@@ -43,6 +75,30 @@ do                                                          \
 
 //---------------------------------------------------------------------------------------
 
+// Nodes are allocated from the chunks one after another, freed nodes go to the free list
+// (linked by left) and are reused first. Chunks are freed only with the whole tree.
+
+static const size_t TREE_NODE_ARENA_CHUNK_SIZE = 1024;
+
+struct TreeNodeArenaChunk
+{
+    TreeNodeArenaChunk* prev;
+
+    TreeNode nodes[TREE_NODE_ARENA_CHUNK_SIZE];
+};
+
+struct TreeNodeArena
+{
+    TreeNodeArenaChunk* chunk;      ///< current chunk, previous ones are linked by prev
+    size_t              chunkSize;  ///< number of used nodes in the current chunk
+
+    TreeNode*           freeList;
+};
+
+static thread_local TreeNodeArena* CURRENT_NODE_ARENA = nullptr;
+
+//---------------------------------------------------------------------------------------
+
 //TODO: докинуть возможность ввода capacity
 TreeErrors TreeCtor(Tree* tree)
 {
@@ -50,6 +106,12 @@ TreeErrors TreeCtor(Tree* tree)
 
     tree->root = nullptr;
 
+    tree->nodeArena = TreeNodeArenaCtor();
+    if (tree->nodeArena == nullptr)
+        return TreeErrors::MEM_ERR;
+
+    TreeMakeCurrent(tree);
+
     TREE_CHECK(tree);
 
     return TreeErrors::NO_ERR;
@@ -61,26 +123,122 @@ void TreeDtor(Tree* tree)
 {
     assert(tree);
 
-    TreeDtor(tree->root);
-    tree->root = nullptr;
+    // nodes are owned by the arena, so there is no need to traverse the tree
+    if (tree->nodeArena == CURRENT_NODE_ARENA)
+        CURRENT_NODE_ARENA = nullptr;
+
+    TreeNodeArenaDtor(tree->nodeArena);
+    tree->nodeArena = nullptr;
+    tree->root      = nullptr;
 
     NameTableDtor(tree->allNamesTable);
     tree->allNamesTable = nullptr;
 }
 
+void TreeMakeCurrent(Tree* tree)
+{
+    assert(tree);
+    assert(tree->nodeArena);
+
+    CURRENT_NODE_ARENA = tree->nodeArena;
+}
+
+bool TreeIsCurrent(const Tree* tree)
+{
+    assert(tree);
+
+    return tree->nodeArena != nullptr && tree->nodeArena == CURRENT_NODE_ARENA;
+}
+
+void TreeAbsorbNodes(Tree* tree, Tree* source)
+{
+    assert(tree);
+    assert(source);
+    assert(tree->nodeArena);
+    assert(source->nodeArena);
+    assert(TreeIsCurrent(tree));
+
+    TreeNodeArena* arena       = tree->nodeArena;
+    TreeNodeArena* sourceArena = source->nodeArena;
+
+    // source chunks are put after the current chunk, so it stays current
+    if (sourceArena->chunk != nullptr)
+    {
+        if (arena->chunk == nullptr)
+        {
+            arena->chunk     = sourceArena->chunk;
+            arena->chunkSize = sourceArena->chunkSize;
+        }
+        else
+        {
+            TreeNodeArenaChunk* oldest = sourceArena->chunk;
+            while (oldest->prev)
+                oldest = oldest->prev;
+
+            oldest->prev       = arena->chunk->prev;
+            arena->chunk->prev = sourceArena->chunk;
+        }
+    }
+
+    if (sourceArena->freeList != nullptr)
+    {
+        TreeNode* last = sourceArena->freeList;
+        while (last->left)
+            last = last->left;
+
+        last->left      = arena->freeList;
+        arena->freeList = sourceArena->freeList;
+    }
+
+    *sourceArena = {};
+}
+
 //---------------------------------------------------------------------------------------
 
-static void TreeDtor(TreeNode* node)
+static TreeNodeArena* TreeNodeArenaCtor()
 {
-    if (node == nullptr)
+    return (TreeNodeArena*)calloc(1, sizeof(TreeNodeArena));
+}
+
+static void TreeNodeArenaDtor(TreeNodeArena* arena)
+{
+    if (arena == nullptr)
         return;
-    
-    assert(node);
 
-    TreeDtor(node->left);
-    TreeDtor(node->right);
+    while (arena->chunk)
+    {
+        TreeNodeArenaChunk* prev = arena->chunk->prev;
+        free(arena->chunk);
+        arena->chunk = prev;
+    }
 
-    TreeNodeDtor(node);
+    free(arena);
+}
+
+static TreeNode* TreeNodeArenaAlloc(TreeNodeArena* arena)
+{
+    assert(arena);
+
+    if (arena->freeList)
+    {
+        TreeNode* node  = arena->freeList;
+        arena->freeList = node->left;
+
+        return node;
+    }
+
+    if (arena->chunk == nullptr || arena->chunkSize == TREE_NODE_ARENA_CHUNK_SIZE)
+    {
+        TreeNodeArenaChunk* chunk = (TreeNodeArenaChunk*)malloc(sizeof(*chunk));
+        if (chunk == nullptr)
+            return nullptr;
+
+        chunk->prev      = arena->chunk;
+        arena->chunk     = chunk;
+        arena->chunkSize = 0;
+    }
+
+    return arena->chunk->nodes + arena->chunkSize++;
 }
 
 //---------------------------------------------------------------------------------------
@@ -88,7 +246,9 @@ static void TreeDtor(TreeNode* node)
 TreeNode* TreeNodeCreate(TreeNodeValue value, TreeNodeValueType valueType,
                          TreeNode* left, TreeNode* right)
 {   
-    TreeNode* node  = (TreeNode*)calloc(1, sizeof(*node));
+    assert(CURRENT_NODE_ARENA);
+
+    TreeNode* node  = TreeNodeArenaAlloc(CURRENT_NODE_ARENA);
     assert(node);
 
     node->left      = left;
@@ -105,16 +265,108 @@ void TreeNodeDeepDtor(TreeNode* node)
 {
     assert(node);
 
-    TreeDtor(node);
+    static const TreeVisitor dtorVisitor = { nullptr, nullptr, TreeNodeDtorVisit, false };
+
+    // children are freed before the node, so its edges are still valid while they are visited
+    TreeVisit(&node, &dtorVisitor, nullptr);
+}
+
+static TreeVisitAction TreeNodeDtorVisit(TreeNode** link, TreeVisitState*, void*)
+{
+    assert(link);
+
+    TreeNodeDtor(*link);
+
+    return TreeVisitAction::CONTINUE;
 }
 
 void TreeNodeDtor(TreeNode* node)
 {
-    node->left         = nullptr;
+    assert(node);
+    assert(CURRENT_NODE_ARENA);
+
     node->right        = nullptr;
     node->value.nameId  =      -1;
 
-    free(node);
+    node->left                   = CURRENT_NODE_ARENA->freeList;
+    CURRENT_NODE_ARENA->freeList = node;
+}
+
+//---------------------------------------------------------------------------------------
+
+/// @brief Copies of the visited subtrees, the right child's copy is above the left one's
+struct TreeCopyStack
+{
+    TreeNode** nodes;
+    size_t     size;
+    size_t     capacity;
+
+    bool       memErr;
+};
+
+static const size_t TREE_COPY_STACK_STANDARD_CAPACITY = 64;
+
+TreeNode* TreeNodeCopy(const TreeNode* node)
+{
+    if (node == nullptr)
+        return nullptr;
+
+    static const TreeConstVisitor copyVisitor = { nullptr, nullptr, TreeNodeCopyVisit, false };
+
+    TreeCopyStack stack = {};
+
+    TreeErrors err  = TreeVisit(node, &copyVisitor, &stack);
+    TreeNode*  copy = nullptr;
+
+    if (err == TreeErrors::NO_ERR && !stack.memErr)
+    {
+        assert(stack.size == 1);
+        copy = stack.nodes[0];
+    }
+    else
+    {
+        for (size_t i = 0; i < stack.size; ++i)
+            TreeNodeDeepDtor(stack.nodes[i]);
+    }
+
+    free(stack.nodes);
+
+    return copy;
+}
+
+static TreeVisitAction TreeNodeCopyVisit(const TreeNode* node, TreeConstVisitState*,
+                                         void* context)
+{
+    assert(node);
+    assert(context);
+
+    TreeCopyStack* stack = (TreeCopyStack*)context;
+
+    TreeNode* right = node->right ? stack->nodes[--stack->size] : nullptr;
+    TreeNode* left  = node->left  ? stack->nodes[--stack->size] : nullptr;
+
+    if (stack->size == stack->capacity)
+    {
+        const size_t newCapacity = stack->capacity > 0 ? 2 * stack->capacity :
+                                                         TREE_COPY_STACK_STANDARD_CAPACITY;
+
+        TreeNode** newNodes = (TreeNode**)realloc(stack->nodes, newCapacity * sizeof(*newNodes));
+        if (newNodes == nullptr)
+        {
+            if (left)  TreeNodeDeepDtor(left);
+            if (right) TreeNodeDeepDtor(right);
+
+            stack->memErr = true;
+            return TreeVisitAction::STOP;
+        }
+
+        stack->nodes    = newNodes;
+        stack->capacity = newCapacity;
+    }
+
+    stack->nodes[stack->size++] = TreeNodeCreate(node->value, node->valueType, left, right);
+
+    return TreeVisitAction::CONTINUE;
 }
 
 //---------------------------------------------------------------------------------------
@@ -128,47 +380,182 @@ TreeErrors TreeVerify(const Tree* tree)
 
 TreeErrors TreeVerify(const TreeNode* node)
 {
-    if (node == nullptr)
-        return TreeErrors::NO_ERR;
+    // edges are checked before the children are visited, so self loop isn't followed
+    static const TreeConstVisitor verifyVisitor = { TreeVerifyVisit, nullptr, nullptr, false };
 
-    TreeErrors err = TreeVerify(node->left);
-    if (err != TreeErrors::NO_ERR) return err;
+    TreeErrors err = TreeErrors::NO_ERR;
 
-    err = TreeVerify(node->right);
-    if (err != TreeErrors::NO_ERR) return err;
+    TreeErrors visitErr = TreeVisit(node, &verifyVisitor, &err);
+    if (visitErr != TreeErrors::NO_ERR)
+        return visitErr;
 
-    if (node->left == node->right && node->left != nullptr)
-        return TreeErrors::NODE_EDGES_ERR;
-    
-    if (node->left == node || node->right == node)
-        return TreeErrors::NODE_EDGES_ERR;
+    return err;
+}
 
-    return TreeErrors::NO_ERR;
+static TreeVisitAction TreeVerifyVisit(const TreeNode* node, TreeConstVisitState*, void* context)
+{
+    assert(node);
+    assert(context);
+
+    TreeErrors* outErr = (TreeErrors*)context;
+
+    if ((node->left == node->right && node->left != nullptr) ||
+        (node->left == node || node->right == node))
+    {
+        *outErr = TreeErrors::NODE_EDGES_ERR;
+        return TreeVisitAction::STOP;
+    }
+
+    return TreeVisitAction::CONTINUE;
+}
+
+//---------------------------------------------------------------------------------------
+
+static TreeDumpPolicy TREE_DUMP_POLICY = TreeDumpPolicy::OFF;
+
+void TreeDumpPolicyInit(const char* policyOption)
+{
+    if (policyOption == nullptr)
+        policyOption = getenv("TREE_DUMP");
+
+    TreeDumpPolicy policy = TreeDumpPolicy::OFF;
+
+    if (policyOption != nullptr)
+    {
+        if      (strcasecmp(policyOption, "dot")    == 0) policy = TreeDumpPolicy::DOT;
+        else if (strcasecmp(policyOption, "render") == 0) policy = TreeDumpPolicy::RENDER;
+    }
+
+    TreeSetDumpPolicy(policy);
+}
+
+void TreeSetDumpPolicy(const TreeDumpPolicy policy)
+{
+    TREE_DUMP_POLICY = policy;
+}
+
+//---------------------------------------------------------------------------------------
+
+static const size_t MAX_DUMP_FILE_NAME_LENGTH = 64;
+
+struct DotFileContext
+{
+    FILE*                outDotFile;
+    const NameTableType* nameTable;
+};
+
+static inline void CreateImgInLogFile(const char* dotFileName, const size_t imgIndex, 
+                                      bool openImg)
+{
+    assert(dotFileName);
+
+    char imgName[MAX_DUMP_FILE_NAME_LENGTH] = "";
+    snprintf(imgName, MAX_DUMP_FILE_NAME_LENGTH, "../imgs/img_%zu_time_%s.png", imgIndex, __TIME__);
+
+    Log("<img src = \"%s\">\n", imgName);
+
+    TreeDumpWorkerPush(dotFileName, imgName, openImg);
 }
 
 //---------------------------------------------------------------------------------------
 
-static inline void CreateImgInLogFile(const size_t imgIndex, bool openImg)
+// Rendering is done by the single background worker so dot / open processes
+// are never waited for on the compilation path
+
+struct TreeDumpJob
+{
+    char dotFileName[MAX_DUMP_FILE_NAME_LENGTH];
+    char imgName    [MAX_DUMP_FILE_NAME_LENGTH];
+    bool openImg;
+
+    TreeDumpJob* next;
+};
+
+static std::mutex              TREE_DUMP_MUTEX;
+static std::condition_variable TREE_DUMP_CONDITION;
+static std::thread             TREE_DUMP_WORKER;
+static TreeDumpJob*            TREE_DUMP_JOBS_HEAD = nullptr;
+static TreeDumpJob*            TREE_DUMP_JOBS_TAIL = nullptr;
+static bool                    TREE_DUMP_WORKER_STOP = false;
+
+static void TreeDumpWorkerPush(const char* dotFileName, const char* imgName, bool openImg)
 {
-    static const size_t maxImgNameLength  = 64;
-    static char imgName[maxImgNameLength] = "";
-    snprintf(imgName, maxImgNameLength, "../imgs/img_%zu_time_%s.png", imgIndex, __TIME__);
+    assert(dotFileName);
+    assert(imgName);
+
+    TreeDumpJob* job = (TreeDumpJob*)calloc(1, sizeof(*job));
+    if (job == nullptr)
+        return;
+
+    strncpy(job->dotFileName, dotFileName, MAX_DUMP_FILE_NAME_LENGTH - 1);
+    strncpy(job->imgName,     imgName,     MAX_DUMP_FILE_NAME_LENGTH - 1);
+    job->openImg = openImg;
+
+    std::lock_guard<std::mutex> lock(TREE_DUMP_MUTEX);
 
-    static const size_t     maxCommandLength  = 128;
-    static char commandName[maxCommandLength] =  "";
-    snprintf(commandName, maxCommandLength, "dot treeHandler.dot -T png -o %s", imgName);
-    system(commandName);
+    if (!TREE_DUMP_WORKER.joinable())
+    {
+        TREE_DUMP_WORKER = std::thread(TreeDumpWorkerLoop);
+        atexit(TreeDumpWorkerStop);
+    }
+
+    if (TREE_DUMP_JOBS_TAIL) TREE_DUMP_JOBS_TAIL->next = job;
+    else                     TREE_DUMP_JOBS_HEAD       = job;
 
-    snprintf(commandName, maxCommandLength, "<img src = \"%s\">\n", imgName);    
-    Log(commandName);
+    TREE_DUMP_JOBS_TAIL = job;
+
+    TREE_DUMP_CONDITION.notify_one();
+}
 
-    if (openImg)
+static void TreeDumpWorkerLoop()
+{
+    static const size_t     maxCommandLength  = 192;
+    char commandName[maxCommandLength] =  "";
+
+    std::unique_lock<std::mutex> lock(TREE_DUMP_MUTEX);
+
+    while (true)
     {
-        snprintf(commandName, maxCommandLength, "open %s", imgName);
+        TREE_DUMP_CONDITION.wait(lock, []{ return TREE_DUMP_JOBS_HEAD || TREE_DUMP_WORKER_STOP; });
+
+        if (TREE_DUMP_JOBS_HEAD == nullptr)
+            break;
+
+        TreeDumpJob* job = TREE_DUMP_JOBS_HEAD;
+        TREE_DUMP_JOBS_HEAD = job->next;
+        if (TREE_DUMP_JOBS_HEAD == nullptr)
+            TREE_DUMP_JOBS_TAIL = nullptr;
+
+        lock.unlock();
+
+        snprintf(commandName, maxCommandLength, "dot %s -T png -o %s", job->dotFileName, job->imgName);
         system(commandName);
+
+        if (job->openImg)
+        {
+            snprintf(commandName, maxCommandLength, "open %s", job->imgName);
+            system(commandName);
+        }
+
+        free(job);
+
+        lock.lock();
     }
 }
 
+// Waits for all pushed images to be rendered
+static void TreeDumpWorkerStop()
+{
+    {
+        std::lock_guard<std::mutex> lock(TREE_DUMP_MUTEX);
+        TREE_DUMP_WORKER_STOP = true;
+    }
+    TREE_DUMP_CONDITION.notify_one();
+
+    if (TREE_DUMP_WORKER.joinable())
+        TREE_DUMP_WORKER.join();
+}
+
 //---------------------------------------------------------------------------------------
 
 static inline void DotFileBegin(FILE* outDotFile)
@@ -190,7 +577,15 @@ void TreeGraphicDump(const Tree* tree, bool openImg)
 {
     assert(tree);
 
-    static const char* dotFileName = "treeHandler.dot";
+    if (TREE_DUMP_POLICY == TreeDumpPolicy::OFF)
+        return;
+
+    static size_t imgIndex = 0;
+
+    // every dump has its own dot file, so the worker can render it later
+    char dotFileName[MAX_DUMP_FILE_NAME_LENGTH] = "";
+    snprintf(dotFileName, MAX_DUMP_FILE_NAME_LENGTH, "treeHandler_%zu.dot", imgIndex);
+
     FILE* outDotFile = fopen(dotFileName, "w");
 
     if (outDotFile == nullptr)
@@ -198,29 +593,38 @@ void TreeGraphicDump(const Tree* tree, bool openImg)
 
     DotFileBegin(outDotFile);
 
-    DotFileCreateNodes(tree->root, outDotFile, tree->allNamesTable);
+    DotFileContext dotContext = { outDotFile, tree->allNamesTable };
+
+    static const TreeConstVisitor nodesVisitor = { DotFileCreateNode, nullptr, nullptr, false };
+    static const TreeConstVisitor edgesVisitor = { DotFileCreateEdgesPre, DotFileCreateEdgesIn,
+                                                   nullptr, true };
 
-    TreeGraphicDump(tree->root, outDotFile);
+    TreeVisit(tree->root, &nodesVisitor, &dotContext);
+    TreeVisit(tree->root, &edgesVisitor, &dotContext);
 
     DotFileEnd(outDotFile);
 
     fclose(outDotFile);
 
-    static size_t imgIndex = 0;
-    CreateImgInLogFile(imgIndex, openImg);
+    if (TREE_DUMP_POLICY == TreeDumpPolicy::RENDER)
+        CreateImgInLogFile(dotFileName, imgIndex, openImg);
+    else
+        Log("Tree dot file: %s\n", dotFileName);
+
     imgIndex++;
 }
 
 //---------------------------------------------------------------------------------------
 
-static void DotFileCreateNodes(const TreeNode* node, FILE* outDotFile,
-                               const NameTableType* nameTable)
+static TreeVisitAction DotFileCreateNode(const TreeNode* node, TreeConstVisitState*,
+                                         void* context)
 {
-    assert(outDotFile);
+    assert(node);
+    assert(context);
+
+    FILE*                outDotFile = ((DotFileContext*)context)->outDotFile;
+    const NameTableType* nameTable  = ((DotFileContext*)context)->nameTable;
 
-    if (node == nullptr)
-        return;
-    
     fprintf(outDotFile, "node%p[shape=Mrecord, style=filled, ", node);
 
     if (node->valueType == TreeNodeValueType::OPERATION)
@@ -248,36 +652,43 @@ static void DotFileCreateNodes(const TreeNode* node, FILE* outDotFile,
         fprintf(outDotFile, "fillcolor=\"#FF0000\", label = \"ERROR\", ");
 
     fprintf(outDotFile, "color = \"#D0D000\"];\n");
-    
-    const NameTableType* localNameTable = nameTable;
-
-    if (node->valueType == TreeNodeValueType::NAME && 
-        nameTable->data[node->value.nameId].localNameTable)
-    {
-        localNameTable = (NameTableType*)nameTable->data[node->value.nameId].localNameTable;
-    }
 
-    DotFileCreateNodes(node->left,  outDotFile, localNameTable);
-    DotFileCreateNodes(node->right, outDotFile, localNameTable);
+    return TreeVisitAction::CONTINUE;
 }
 
 //---------------------------------------------------------------------------------------
 
-static void TreeGraphicDump(const TreeNode* node, FILE* outDotFile)
+// Edge to the child is started by the parent and finished by the child: "nodeP->nodeC;"
+
+static TreeVisitAction DotFileCreateEdgesPre(const TreeNode* node, TreeConstVisitState*,
+                                             void* context)
 {
+    assert(context);
+
+    FILE* outDotFile = ((DotFileContext*)context)->outDotFile;
+
     if (node == nullptr)
     {
         fprintf(outDotFile, "\n");
-        return;
+        return TreeVisitAction::CONTINUE;
     }
-    
+
     fprintf(outDotFile, "node%p;\n", node);
 
     if (node->left != nullptr) fprintf(outDotFile, "node%p->", node);
-    TreeGraphicDump(node->left, outDotFile);
 
-    if (node->right != nullptr) fprintf(outDotFile, "node%p->", node);
-    TreeGraphicDump(node->right, outDotFile);
+    return TreeVisitAction::CONTINUE;
+}
+
+static TreeVisitAction DotFileCreateEdgesIn(const TreeNode* node, TreeConstVisitState*,
+                                            void* context)
+{
+    assert(node);
+    assert(context);
+
+    if (node->right != nullptr) fprintf(((DotFileContext*)context)->outDotFile, "node%p->", node);
+
+    return TreeVisitAction::CONTINUE;
 }
 
 //---------------------------------------------------------------------------------------
@@ -292,7 +703,8 @@ void TreeTextDump(const Tree* tree, const char* fileName, const char* funcName,
 
     Log("Tree root: %p, value: %s\n", tree->root, tree->root->value);
     Log("Tree: ");
-    TreePrintPrefixFormat(tree, nullptr);
+    TreePrintPrefixFormat(tree->root, nullptr, tree->allNamesTable); // printed with LogLevel::TRACE only
+    Log("\n");
 
     LOG_END();
 }
@@ -395,11 +807,12 @@ TreeNode* TreeStringLiteralNodeCreate(int literalId)
 
 //---------------------------------------------------------------------------------------
 
+// Every printed token is mirrored to the log only with LogLevel::TRACE
 #define PRINT(outStream, ...)                          \
 do                                                     \
 {                                                      \
     if (outStream) fprintf(outStream, __VA_ARGS__);    \
-    Log(__VA_ARGS__);                                  \
+    LOG_TRACE(__VA_ARGS__);                            \
 } while (0)
 
 TreeErrors TreePrintPrefixFormat(const Tree* tree, FILE* outStream)
@@ -407,26 +820,48 @@ TreeErrors TreePrintPrefixFormat(const Tree* tree, FILE* outStream)
     assert(tree);
     assert(outStream);
 
-    LOG_BEGIN();
+    ON_LOG_TRACE(LOG_BEGIN(););
 
     TreeErrors err = TreePrintPrefixFormat(tree->root, outStream, tree->allNamesTable);
 
     PRINT(outStream, "\n");
 
-    LOG_END();
+    ON_LOG_TRACE(LOG_END(););
 
     return err;
 }
 
 //---------------------------------------------------------------------------------------
 
+struct TreePrintContext
+{
+    FILE*                outStream;
+    const NameTableType* nameTable;
+};
+
 static TreeErrors TreePrintPrefixFormat(const TreeNode* node, FILE* outStream,
                                         const NameTableType* nameTable)
 {
+    static const TreeConstVisitor printVisitor = { TreePrintPrefixFormatPre, nullptr,
+                                                   TreePrintPrefixFormatPost, true };
+
+    TreePrintContext context = { outStream, nameTable };
+
+    return TreeVisit(node, &printVisitor, &context);
+}
+
+static TreeVisitAction TreePrintPrefixFormatPre(const TreeNode* node, TreeConstVisitState*,
+                                                void* context)
+{
+    assert(context);
+
+    FILE*                outStream = ((TreePrintContext*)context)->outStream;
+    const NameTableType* nameTable = ((TreePrintContext*)context)->nameTable;
+
     if (node == nullptr)
     {
         PRINT(outStream, "nil ");
-        return TreeErrors::NO_ERR;
+        return TreeVisitAction::CONTINUE;
     }
 
     PRINT(outStream, "(");
@@ -440,101 +875,134 @@ static TreeErrors TreePrintPrefixFormat(const TreeNode* node, FILE* outStream,
     else
         PRINT(outStream, "%s ", TreeOperationGetLongName(node->value.operation));
 
-    TreeErrors err = TreeErrors::NO_ERR;
+    return TreeVisitAction::CONTINUE;
+}
 
-    err = TreePrintPrefixFormat(node->left, outStream, nameTable);
-    
-    err = TreePrintPrefixFormat(node->right, outStream, nameTable);
+static TreeVisitAction TreePrintPrefixFormatPost(const TreeNode*, TreeConstVisitState*,
+                                                 void* context)
+{
+    assert(context);
+
+    FILE* outStream = ((TreePrintContext*)context)->outStream;
 
     PRINT(outStream, ")");
-    
-    return err;
+
+    return TreeVisitAction::CONTINUE;
 }
 
+//---------------------------------------------------------------------------------------
+
+struct TreeReadContext
+{
+    const char*    stringPtr;
+    NameTableType* allNamesTable;
+    TreeErrors     err;
+};
+
 TreeErrors TreeReadPrefixFormat(Tree* tree, FILE* inStream)
 {
     assert(tree);
     assert(inStream);
 
-    char* inputTree = ReadText(inStream);
+    MappedText inputTree = {};
 
-    if (inputTree == nullptr)
+    if (MappedTextCtor(&inputTree, inStream) != 0 || inputTree.textSz == 0)
+    {
+        MappedTextDtor(&inputTree);
         return TreeErrors::READING_ERR;
+    }
 
-    const char* inputTreeEndPtr = inputTree;
-    
     NameTableCtor(&tree->allNamesTable);
 
-    tree->root = TreeReadPrefixFormat(inputTree, &inputTreeEndPtr, tree->allNamesTable);
+    // every link is nil before it is read, so the visitor fills the tree from the root
+    static const TreeVisitor readVisitor = { TreeReadPrefixFormatPre, nullptr,
+                                             TreeReadPrefixFormatPost, true };
 
-    free(inputTree);
+    TreeReadContext context = { inputTree.text, tree->allNamesTable, TreeErrors::NO_ERR };
 
-    return TreeErrors::NO_ERR;
+    TreeMakeCurrent(tree);
+    tree->root = nullptr;
+
+    TreeErrors err = TreeVisit(&tree->root, &readVisitor, &context);
+
+    MappedTextDtor(&inputTree);
+
+    return err != TreeErrors::NO_ERR ? err : context.err;
 }
 
 //---------------------------------------------------------------------------------------
 
-static TreeNode* TreeReadPrefixFormat(const char* const string, const char** stringEndPtr,
-                                                                    NameTableType* allNamesTable)
+static TreeVisitAction TreeReadPrefixFormatPre(TreeNode** link, TreeVisitState*, void* context)
 {
-    assert(string);
+    assert(link);
+    assert(*link == nullptr);
+    assert(context);
 
-    const char* stringPtr = string;
+    TreeReadContext* readContext = (TreeReadContext*)context;
 
-    stringPtr = SkipSymbolsWhileStatement(stringPtr, isspace);
+    const char* stringPtr = SkipSymbolsWhileStatement(readContext->stringPtr, isspace);
 
     int symbol = *stringPtr;
     stringPtr++;
     if (symbol != '(') //skipping nils
     {
-        int shift = 0;
-        sscanf(stringPtr, "%*s%n", &shift);
-        stringPtr += shift;
+        while (*stringPtr != '\0' && !isspace(*stringPtr))
+            stringPtr++;
 
-        *stringEndPtr = stringPtr;
-        return nullptr;
+        readContext->stringPtr = stringPtr;
+        return TreeVisitAction::CONTINUE;
     }
 
     TreeNodeValue value         = {};
     TreeNodeValueType valueType = {};
 
-    stringPtr = TreeReadNodeValue(&value, &valueType, stringPtr, allNamesTable);
-    TreeNode* node = TreeNodeCreate(value, valueType);
-    
-    TreeNode* left  = TreeReadPrefixFormat(stringPtr, &stringPtr, allNamesTable);
+    readContext->stringPtr = TreeReadNodeValue(&value, &valueType, stringPtr,
+                                               readContext->allNamesTable, &readContext->err);
+    *link = TreeNodeCreate(value, valueType);
 
-    TreeNode* right = nullptr;
-    right = TreeReadPrefixFormat(stringPtr, &stringPtr, allNamesTable);
+    return TreeVisitAction::CONTINUE;
+}
 
-    stringPtr = SkipSymbolsUntilStopChar(stringPtr, ')');
-    ++stringPtr;
+static TreeVisitAction TreeReadPrefixFormatPost(TreeNode**, TreeVisitState*, void* context)
+{
+    assert(context);
 
-    TreeNodeSetEdges(node, left, right);
+    TreeReadContext* readContext = (TreeReadContext*)context;
 
-    *stringEndPtr = stringPtr;
-    return node;
+    readContext->stringPtr = SkipSymbolsUntilStopChar(readContext->stringPtr, ')') + 1;
+
+    return TreeVisitAction::CONTINUE;
 }
 
 static const char* TreeReadNodeValue(TreeNodeValue* value, TreeNodeValueType* valueType, 
-                                            const char* string, NameTableType* allNamesTable)
+                                      const char* string, NameTableType* allNamesTable,
+                                      TreeErrors* outErr)
 {
     assert(value);
     assert(string);
     assert(valueType);
+    assert(outErr);
     
-    int readenValue = 0;
-    int shift = 0;
-    int scanResult = sscanf(string, "%d%n\n", &readenValue, &shift);
+    int    readenValue = 0;
+    size_t shift       = 0;
+    ScanIntErrors scanErr = ScanInt(string, &readenValue, &shift);
 
-    if (scanResult != 0)
+    if (scanErr == ScanIntErrors::OVERFLOW_ERR)
+    {
+        LogError("Number is too big to be int in tree: %.*s\n", (int)shift, string);
+        *outErr = TreeErrors::READING_ERR;
+
+        scanErr     = ScanIntErrors::NO_ERR;
+        readenValue = 0;
+    }
+
+    if (scanErr == ScanIntErrors::NO_ERR)
     {
         value->num = readenValue;
         *valueType = TreeNodeValueType::NUM;
         return string + shift;
     }
 
-    shift = 0;
-
     static const size_t      maxInputStringSize  = 1024;
     static char  inputString[maxInputStringSize] =  "";
 
@@ -566,9 +1034,7 @@ static const char* TreeReadNodeValue(TreeNodeValue* value, TreeNodeValueType* va
         return stringPtr;
     }
 
-    sscanf(string, "%s%n", inputString, &shift);
-
-    stringPtr = string + shift;
+    stringPtr = TreeReadWord(string, inputString, maxInputStringSize);
     assert(isspace(*stringPtr));
 
     int operationId = TreeOperationGetId(inputString);
@@ -604,6 +1070,27 @@ static const char* TreeReadNodeValue(TreeNodeValue* value, TreeNodeValueType* va
     return stringPtr;
 }
 
+// Same as sscanf("%s"): skips whitespaces and reads chars until the next whitespace
+static inline const char* TreeReadWord(const char* string, char* outWord, const size_t maxWordSize)
+{
+    assert(string);
+    assert(outWord);
+
+    const char* stringPtr = SkipSymbolsWhileStatement(string, isspace);
+
+    size_t wordPos = 0;
+    while (*stringPtr != '\0' && !isspace(*stringPtr))
+    {
+        assert(wordPos + 1 < maxWordSize);
+
+        outWord[wordPos++] = *stringPtr++;
+    }
+
+    outWord[wordPos] = '\0';
+
+    return stringPtr;
+}
+
 void TreeNodeSetEdges(TreeNode* node, TreeNode* left, TreeNode* right)
 {
     assert(node);
@@ -613,25 +1100,28 @@ void TreeNodeSetEdges(TreeNode* node, TreeNode* left, TreeNode* right)
 }
 
 
+#define GENERATE_OPERATION_CMD(NAME, ...) { #NAME, (int)TreeOperationId::NAME },
+
+static constexpr PerfectHashKey TREE_OPERATION_KEYS[] =
+{
+    #include "Operations.h"
+};
+
+#undef GENERATE_OPERATION_CMD
+
+// names are case insensitive
+static constexpr auto TREE_OPERATION_TABLE = PerfectHashTableCreate<64>(TREE_OPERATION_KEYS, true);
+
 int TreeOperationGetId(const char* string)
 {
     assert(string);
 
-    #define GENERATE_OPERATION_CMD(NAME, ...)   \
-        if (strcasecmp(string, #NAME) == 0)     \
-            return (int)TreeOperationId::NAME;  \
-        else
-
-    #include "Operations.h"
+    int operationId = -1;
 
-    /* else */
-    {
+    if (!PerfectHashFind(TREE_OPERATION_TABLE, string, strlen(string), &operationId))
         return -1;
-    }
-
-    #undef GENERATE_OPERATION_CMD
 
-    return -1;
+    return operationId;
 }
 
 const char* TreeOperationGetLongName(const  TreeOperationId operation)
@@ -37,11 +37,16 @@ struct TreeNode
     TreeNode* right;
 };
 
+/// @brief Chunked storage of the tree nodes with free list, defined in Tree.cpp
+struct TreeNodeArena;
+
 struct Tree
 {
     TreeNode* root;
 
     NameTableType* allNamesTable;
+
+    TreeNodeArena* nodeArena;   ///< all nodes of the tree live here
 };
 
 enum class TreeErrors
@@ -51,6 +56,7 @@ enum class TreeErrors
     MEM_ERR,
 
     READING_ERR,
+    WRITING_ERR,
 
     CAPACITY_ERR,
     VARIABLE_NAME_ERR, 
@@ -64,12 +70,31 @@ enum class TreeErrors
 
 //-------------Expression main funcs----------
 
+/// @brief Creates tree with empty node arena and makes it current
 TreeErrors TreeCtor(Tree* tree);
+
+/// @brief Destroys the tree, all nodes are freed with their arena at once
 void TreeDtor(Tree* tree);
 
+/// @brief Makes tree's node arena the one TreeNodeCreate / TreeNodeDtor work with in this thread
+/// @details TreeCtor calls it, so it is needed only if several trees are changed by turns
+void TreeMakeCurrent(Tree* tree);
+
+/// @brief Checks that nodes created and freed in this thread go to the arena of the tree
+/// @details Functions that change the tree assert it, so nodes can't silently land
+/// in the arena of the other tree and be freed with it
+bool TreeIsCurrent(const Tree* tree);
+
+/// @brief Moves all nodes of the source tree arena to the tree arena
+/// @details Is used to merge trees that were built in different threads.
+/// Source tree stays with empty arena, its root and allNamesTable aren't touched.
+void TreeAbsorbNodes(Tree* tree, Tree* source);
+
+/// @brief Creates the node in the current arena of this thread (see TreeMakeCurrent)
 TreeNode* TreeNodeCreate(TreeNodeValue value, TreeNodeValueType valueType,
                              TreeNode* left  = nullptr, TreeNode* right = nullptr);
 
+/// @brief Puts the node to the free list of the current arena, it has to be the node's one
 void TreeNodeDtor(TreeNode* node);
 void TreeNodeDeepDtor(TreeNode* node);
 
@@ -89,6 +114,24 @@ TreeNode* TreeStringLiteralNodeCreate   (int literalId);
 void TreeTextDump(const Tree* tree, 
                   const char* fileName, const char* funcName, const int line);
 
+/// @brief What TreeGraphicDump does
+enum class TreeDumpPolicy
+{
+    OFF,    ///< nothing is dumped
+    DOT,    ///< only dot file is created, graphviz is never called
+    RENDER, ///< dot file is created and rendered to png by the background worker
+};
+
+/// @brief Sets dump policy from the option value (off, dot, render)
+/// @details If option is nullptr TREE_DUMP environment variable is used. OFF by default
+/// @param [in]policyOption option value, usually from "--dump=" command line option
+void TreeDumpPolicyInit(const char* policyOption);
+
+void TreeSetDumpPolicy(const TreeDumpPolicy policy);
+
+/// @brief Dumps tree according to the dump policy
+/// @param [in]tree tree to dump
+/// @param [in]openImg open rendered image (only with TreeDumpPolicy::RENDER)
 void TreeGraphicDump(const Tree* tree, bool openImg);
 
 #define TREE_DUMP(tree) TreeDump((tree), __FILE__, __func__, __LINE__)
@@ -98,12 +141,34 @@ void TreeDump(const Tree* tree, const char* fileName, const char* funcName, cons
 void TreeNodeSetEdges(TreeNode* node, TreeNode* left, TreeNode* right);
 
 //Tree       TreeCopy(const Tree* tree);
-//TreeNode* TreeNodeCopy(const TreeNode* node);
+
+/// @brief Copies the subtree into the current arena
+/// @return copy or nullptr if there is no memory
+TreeNode* TreeNodeCopy(const TreeNode* node);
 
 TreeErrors TreePrintPrefixFormat(const Tree* tree, FILE* outStream);
 
 TreeErrors TreeReadPrefixFormat(Tree* tree, FILE* inStream = stdin);
 
+//-------------Binary format-----------
+
+/// @brief Formats the tree can be written to the file in
+enum class TreeFileFormat
+{
+    PREFIX, ///< human-readable prefix text format, used for debugging
+    BINARY, ///< compact binary format: header, names section, nodes array in preorder
+};
+
+TreeErrors TreePrintBinaryFormat(const Tree* tree, FILE* outStream);
+
+TreeErrors TreeReadBinaryFormat(Tree* tree, FILE* inStream);
+
+/// @brief Prints tree in the chosen format
+TreeErrors TreePrint(const Tree* tree, FILE* outStream, TreeFileFormat format);
+
+/// @brief Reads tree detecting its format by the binary format header
+TreeErrors TreeRead(Tree* tree, FILE* inStream);
+
 //-------------Operations funcs-----------
 
 int  TreeOperationGetId(const char* string);
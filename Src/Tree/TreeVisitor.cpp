@@ -0,0 +1,201 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "TreeVisitor.h"
+
+//---------------------------------------------------------------------------------------
+
+static const size_t TREE_VISIT_STANDARD_CAPACITY = 64;
+
+enum class TreeVisitStage
+{
+    PRE,
+    IN,
+    POST,
+};
+
+/// @brief Pending visit. Link is TreeNode** for the changeable tree and const TreeNode* otherwise
+template <typename Link>
+struct TreeVisitFrame
+{
+    Link           link;
+    TreeVisitStage stage;
+};
+
+template <typename Link>
+struct TreeVisitStateBase
+{
+    TreeVisitFrame<Link>* frames;   ///< frames are addressed by index, array is reallocated
+    size_t                size;
+    size_t                capacity;
+
+    bool isInPre;
+
+    bool childrenAreSet;
+    Link children[2];
+};
+
+struct TreeVisitState      : TreeVisitStateBase<TreeNode**>      {};
+struct TreeConstVisitState : TreeVisitStateBase<const TreeNode*> {};
+
+template <typename Link, typename State, typename Visitor>
+static TreeErrors TreeVisitImpl(Link root, const Visitor* visitor, void* context);
+
+template <typename Link, typename State>
+static TreeErrors TreeVisitPush(State* state, Link link, TreeVisitStage stage);
+
+static inline const TreeNode* TreeVisitGetNode(TreeNode** link)      { return *link; }
+static inline const TreeNode* TreeVisitGetNode(const TreeNode* node) { return node;  }
+
+static inline TreeNode** TreeVisitGetLeft (TreeNode** link) { return &(*link)->left;  }
+static inline TreeNode** TreeVisitGetRight(TreeNode** link) { return &(*link)->right; }
+
+static inline const TreeNode* TreeVisitGetLeft (const TreeNode* node) { return node->left;  }
+static inline const TreeNode* TreeVisitGetRight(const TreeNode* node) { return node->right; }
+
+//---------------------------------------------------------------------------------------
+
+TreeErrors TreeVisit(TreeNode** root, const TreeVisitor* visitor, void* context)
+{
+    assert(root);
+    assert(visitor);
+
+    return TreeVisitImpl<TreeNode**, TreeVisitState>(root, visitor, context);
+}
+
+TreeErrors TreeVisit(const TreeNode* root, const TreeConstVisitor* visitor, void* context)
+{
+    assert(visitor);
+
+    return TreeVisitImpl<const TreeNode*, TreeConstVisitState>(root, visitor, context);
+}
+
+//---------------------------------------------------------------------------------------
+
+void TreeVisitSetChildren(TreeVisitState* state, TreeNode** left, TreeNode** right)
+{
+    assert(state);
+    assert(state->isInPre);
+
+    state->childrenAreSet = true;
+    state->children[0]    = left;
+    state->children[1]    = right;
+}
+
+void TreeVisitSetChildren(TreeConstVisitState* state, const TreeNode* left, const TreeNode* right)
+{
+    assert(state);
+    assert(state->isInPre);
+
+    state->childrenAreSet = true;
+    state->children[0]    = left;
+    state->children[1]    = right;
+}
+
+//---------------------------------------------------------------------------------------
+
+template <typename Link, typename State, typename Visitor>
+static TreeErrors TreeVisitImpl(Link root, const Visitor* visitor, void* context)
+{
+    assert(visitor);
+
+    State      state = {};
+    TreeErrors err   = TreeVisitPush(&state, root, TreeVisitStage::PRE);
+
+    while (err == TreeErrors::NO_ERR && state.size > 0)
+    {
+        const TreeVisitFrame<Link> frame = state.frames[--state.size];
+
+        if (frame.stage == TreeVisitStage::IN)
+        {
+            if (visitor->in(frame.link, &state, context) == TreeVisitAction::STOP)
+                break;
+
+            continue;
+        }
+
+        if (frame.stage == TreeVisitStage::POST)
+        {
+            if (visitor->post(frame.link, &state, context) == TreeVisitAction::STOP)
+                break;
+
+            continue;
+        }
+
+        assert(frame.stage == TreeVisitStage::PRE);
+
+        if (TreeVisitGetNode(frame.link) == nullptr && !visitor->visitNil)
+            continue;
+
+        TreeVisitAction action = TreeVisitAction::CONTINUE;
+        state.childrenAreSet   = false;
+
+        if (visitor->pre)
+        {
+            state.isInPre = true;
+            action = visitor->pre(frame.link, &state, context);
+            state.isInPre = false;
+        }
+
+        if (action == TreeVisitAction::STOP)
+            break;
+
+        // nil link that pre callback hasn't filled
+        if (TreeVisitGetNode(frame.link) == nullptr)
+            continue;
+
+        if (visitor->post)
+            err = TreeVisitPush(&state, frame.link, TreeVisitStage::POST);
+
+        if (action == TreeVisitAction::SKIP_CHILDREN)
+            continue;
+
+        Link first  = state.childrenAreSet ? state.children[0] : TreeVisitGetLeft (frame.link);
+        Link second = state.childrenAreSet ? state.children[1] : TreeVisitGetRight(frame.link);
+
+        if (action == TreeVisitAction::REVERSE_CHILDREN)
+        {
+            Link temp = first;
+            first     = second;
+            second    = temp;
+        }
+
+        // stack is LIFO, so the frames are pushed in the reversed order
+        if (err == TreeErrors::NO_ERR && (second || !state.childrenAreSet))
+            err = TreeVisitPush(&state, second, TreeVisitStage::PRE);
+
+        if (err == TreeErrors::NO_ERR && visitor->in)
+            err = TreeVisitPush(&state, frame.link, TreeVisitStage::IN);
+
+        if (err == TreeErrors::NO_ERR && (first || !state.childrenAreSet))
+            err = TreeVisitPush(&state, first, TreeVisitStage::PRE);
+    }
+
+    free(state.frames);
+
+    return err;
+}
+
+template <typename Link, typename State>
+static TreeErrors TreeVisitPush(State* state, Link link, TreeVisitStage stage)
+{
+    assert(state);
+
+    if (state->size == state->capacity)
+    {
+        const size_t newCapacity = state->capacity > 0 ? 2 * state->capacity :
+                                                         TREE_VISIT_STANDARD_CAPACITY;
+
+        TreeVisitFrame<Link>* newFrames = (TreeVisitFrame<Link>*)realloc(state->frames,
+                                                            newCapacity * sizeof(*newFrames));
+        if (newFrames == nullptr)
+            return TreeErrors::MEM_ERR;
+
+        state->frames   = newFrames;
+        state->capacity = newCapacity;
+    }
+
+    state->frames[state->size++] = { link, stage };
+
+    return TreeErrors::NO_ERR;
+}
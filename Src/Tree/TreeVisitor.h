@@ -0,0 +1,67 @@
+#ifndef TREE_VISITOR_H
+#define TREE_VISITOR_H
+
+/// @file
+/// @brief Contains generic tree traversal with explicit stack
+/// @details Every node gets pre callback before its children, in callback between them and
+/// post callback after them. Pending visits are kept on the heap, so the depth of the tree
+/// is limited only by memory, not by the call stack.
+
+#include "Tree.h"
+
+/// @brief What traversal does after the callback
+enum class TreeVisitAction
+{
+    CONTINUE,           ///< goes on as usual
+    REVERSE_CHILDREN,   ///< (pre only) right child is visited before the left one
+    SKIP_CHILDREN,      ///< (pre only) children and in callback are skipped, post is still called
+    STOP,               ///< traversal ends at once, TreeVisit returns NO_ERR
+};
+
+/// @brief Traversal state, is passed to the callbacks to change the children to visit
+struct TreeVisitState;
+struct TreeConstVisitState;
+
+/// @brief Callback of the tree that can be changed
+/// @param [in]link pointer to the node in its parent (or to the root), *link can be replaced.
+/// If pre callback replaces the node, the new one's children are visited
+typedef TreeVisitAction TreeVisitFunc(TreeNode** link, TreeVisitState* state, void* context);
+
+/// @brief Callback of the read-only tree
+typedef TreeVisitAction TreeConstVisitFunc(const TreeNode* node, TreeConstVisitState* state,
+                                           void* context);
+
+/// @brief Callbacks of the traversal, nullptr callbacks are skipped
+struct TreeVisitor
+{
+    TreeVisitFunc* pre;
+    TreeVisitFunc* in;
+    TreeVisitFunc* post;
+
+    bool visitNil;  ///< pre is called for nullptr links too, the node it puts there is visited
+};
+
+struct TreeConstVisitor
+{
+    TreeConstVisitFunc* pre;
+    TreeConstVisitFunc* in;
+    TreeConstVisitFunc* post;
+
+    bool visitNil;  ///< pre is called with nullptr node for absent children
+};
+
+/// @brief Visits the subtree at the link
+/// @return MEM_ERR if the stack couldn't grow otherwise NO_ERR
+TreeErrors TreeVisit(TreeNode** root, const TreeVisitor* visitor, void* context);
+
+TreeErrors TreeVisit(const TreeNode* root, const TreeConstVisitor* visitor, void* context);
+
+/// @brief Replaces children of the node that are visited next, can be called only from pre.
+/// In callback is still called between them
+/// @details Is used to visit only some of the children or grandchildren instead of children.
+/// nullptr link isn't visited even with visitNil
+void TreeVisitSetChildren(TreeVisitState* state, TreeNode** left, TreeNode** right);
+
+void TreeVisitSetChildren(TreeConstVisitState* state, const TreeNode* left, const TreeNode* right);
+
+#endif
@@ -1,15 +1,16 @@
 #!/bin/bash
 
 input_file=$1
+tree_format=$2   # pass --binary to use binary AST between stages
 
 if [ -z "$input_file" ]; then
-    echo "Usage: $0 <input file>"
+    echo "Usage: $0 <input file> [--binary]"
     exit 1
 fi
 
-./bin/frontEnd $input_file bin/ParseTree.txt
+./bin/frontEnd $input_file bin/ParseTree.txt $tree_format
 
-./bin/middleEnd bin/ParseTree.txt bin/SimplifiedTree.txt
+./bin/middleEnd bin/ParseTree.txt bin/SimplifiedTree.txt $tree_format
 
 ./bin/backEnd bin/SimplifiedTree.txt bin/AsmCode.txt bin/out.bin
 